@@ -0,0 +1,167 @@
+#include <ctype.h>
+#include <algorithm>
+#include "FoldedIndex.h"
+#include "LiteralTrie.h"
+
+namespace LibWNXML {
+
+
+namespace {
+
+/// Base letters of the characters 0x80..0xFF of the single-byte encodings, '*' where a character is kept
+const char* const FoldISO8859_2 =
+	"********************************"
+	"*a*l*ls**sstz*zz*a*l*ls**sstz*zz"
+	"raaaalccceeeeiiddnnoooo*ruuuuyt*"
+	"raaaalccceeeeiiddnnoooo*ruuuuyt*";
+
+const char* const FoldWindows1250 =
+	"**********s*stzz**********s*stzz"
+	"***l*a****s****z***l*****as*l*lz"
+	"raaaalccceeeeiiddnnoooo*ruuuuyt*"
+	"raaaalccceeeeiiddnnoooo*ruuuuyt*";
+
+const char* const FoldISO8859_1 =
+	"********************************"
+	"********************************"
+	"aaaaaa*ceeeeiiiidnooooo*ouuuuy**"
+	"aaaaaa*ceeeeiiiidnooooo*ouuuuy*y";
+
+const char* const FoldWindows1252 =
+	"**********s***z***********s***zy"
+	"********************************"
+	"aaaaaa*ceeeeiiiidnooooo*ouuuuy**"
+	"aaaaaa*ceeeeiiiidnooooo*ouuuuy*y";
+
+/// Base letters of U+0100..U+017F (Latin Extended-A), '*' where a character is kept
+/// (U+00C0..U+00FF are folded like ISO-8859-1)
+const char* const FoldLatinExtendedA =
+	"aaaaaaccccccccddddeeeeeeeeeegggg"
+	"gggghhhhiiiiiiiiii**jjkk*lllllll"
+	"lllnnnnnnn**oooooo**rrrrrrssssss"
+	"ssttttttuuuuuuuuuuuuwwyyyzzzzzzs";
+
+/// Encoding name in upper case, without '-', '_' and spaces ("iso-8859-2" -> "ISO88592")
+std::string encoding_key( const std::string& encoding)
+{
+	std::string key;
+	for (size_t i=0; i!=encoding.size(); i++)
+		if (encoding[i] != '-' && encoding[i] != '_' && encoding[i] != ' ')
+			key += char( toupper( (unsigned char) encoding[i]));
+	return key;
+}
+
+} // namespace {
+
+
+FoldedIndex::FoldedIndex( const LiteralTrie& trie, const std::string& encoding)
+	: m_utf8( false)
+{
+	// folding table: ASCII letters are lowercased in all encodings
+	for (unsigned c=0; c!=256; c++)
+		m_table[c] = (unsigned char) (c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+	std::string key = encoding_key( encoding);
+	const char* upper = NULL;
+	if (key == "ISO88592" || key == "LATIN2")
+		upper = FoldISO8859_2;
+	else if (key == "WINDOWS1250" || key == "CP1250")
+		upper = FoldWindows1250;
+	else if (key == "ISO88591" || key == "LATIN1")
+		upper = FoldISO8859_1;
+	else if (key == "WINDOWS1252" || key == "CP1252")
+		upper = FoldWindows1252;
+	else if (key == "UTF8")
+		m_utf8 = true;
+	if (upper != NULL)
+		for (unsigned c=0x80; c!=0x100; c++)
+			if (upper[c - 0x80] != '*')
+				m_table[c] = (unsigned char) upper[c - 0x80];
+
+	// folded forms of the literals, sorted (literals of the same form stay in byte order)
+	std::vector< std::pair<std::string, unsigned> > folded( trie.size());
+	for (unsigned i=0; i!=trie.size(); i++) {
+		fold( trie.literal( i), trie.length( i), folded[i].first);
+		folded[i].second = i;
+	}
+	std::sort( folded.begin(), folded.end());
+
+	// distinct forms first (the index points into m_chars, so it must not grow afterwards), then the index
+	std::vector<unsigned> starts;
+	for (size_t i=0; i!=folded.size(); i++) {
+		if (i == 0 || folded[i].first != folded[i-1].first) {
+			starts.push_back( unsigned( m_chars.size()));
+			m_chars.append( folded[i].first);
+			m_chars.push_back( '\0');
+		}
+		m_literals.push_back( folded[i].second);
+	}
+	m_index.reserve( starts.size());
+	for (size_t i=0, f=0; i!=folded.size(); f++) {
+		size_t j = i + 1;
+		while (j != folded.size() && folded[j].first == folded[i].first)
+			j++;
+		m_index.insert( m_chars.data() + starts[f], folded[i].first.size(), std::make_pair( unsigned( i), unsigned( j - i)));
+		i = j;
+	}
+}
+
+
+void FoldedIndex::insert( unsigned k, const char* literal, size_t len)
+{
+	for (size_t i=0; i!=m_literals.size(); i++)
+		if (m_literals[i] >= k)
+			m_literals[i]++;
+
+	std::string folded;
+	fold( literal, len, folded);
+	const char* key = folded.data();
+	if (m_index.find( folded) == NULL) {
+		// (new form: the key is kept)
+		m_added.push_back( folded);
+		key = m_added.back().data();
+	}
+	std::pair<unsigned, unsigned>* r = m_index.insert( key, folded.size(), std::make_pair( 0u, 0u)).first;
+
+	// the literals of the form, with k among them in byte order (= by number)
+	size_t start = m_literals.size();
+	for (unsigned i=r->first; i!=r->first+r->second; i++)
+		m_literals.push_back( m_literals[i]);
+	m_literals.insert( std::upper_bound( m_literals.begin() + start, m_literals.end(), k), k);
+	r->first = unsigned( start);
+	r->second++;
+}
+
+
+void FoldedIndex::fold( const char* text, size_t len, std::string& folded) const
+{
+	folded.clear();
+	folded.reserve( len);
+	for (size_t i=0; i!=len; i++) {
+		unsigned char c = (unsigned char) text[i];
+		if (m_utf8 && i + 1 != len && (c == 0xC3 || c == 0xC4 || c == 0xC5) && ((unsigned char) text[i+1] & 0xC0) == 0x80) {
+			// 2-byte sequences of U+00C0..U+017F
+			unsigned cp = ((c & 0x1F) << 6) | ((unsigned char) text[i+1] & 0x3F);
+			char base = cp < 0x100 ? FoldISO8859_1[cp - 0x80] : FoldLatinExtendedA[cp - 0x100];
+			if (base != '*') {
+				folded += base;
+				i++;
+				continue;
+			}
+		}
+		folded += char( m_table[c]);
+	}
+}
+
+
+FoldedIndex::Literals FoldedIndex::find( const char* word, size_t len) const
+{
+	std::string folded;
+	fold( word, len, folded);
+	const std::pair<unsigned, unsigned>* r = m_index.find( folded);
+	if (r == NULL || m_literals.empty())
+		return Literals( NULL, NULL);
+	return Literals( &m_literals[0] + r->first, &m_literals[0] + r->first + r->second);
+}
+
+
+} // namespace LibWNXML {
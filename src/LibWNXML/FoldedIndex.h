@@ -0,0 +1,60 @@
+#ifndef __FOLDEDINDEX_H__
+#define __FOLDEDINDEX_H__
+
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include "StringHashTable.h"
+
+namespace LibWNXML {
+
+class LiteralTrie;
+
+/// Index of the literals of a LiteralTrie by their folded forms: lowercase, without diacritics
+/// (e.g. "KUTYA", and "kutya" with an acute accent on the u -> "kutya"), for looking up words written
+/// with different case or accents (see WNQuery::lookUpLiteralFolded()).
+///
+/// Folding works on the encoded strings, in the encoding of the WordNet (WNQuery::encoding(), the output
+/// encoding of WNXMLParser): ISO-8859-2 and Windows-1250 are folded fully, ISO-8859-1, Windows-1252
+/// and UTF-8 in the Latin-1 Supplement and Latin Extended-A ranges (which include the Hungarian letters);
+/// in other encodings only ASCII letters are lowercased. Letters with no ASCII base letter (sharp s, ligatures) are kept.
+class FoldedIndex
+{
+public:
+
+	/// Range of literal numbers (see LiteralTrie)
+	typedef std::pair<const unsigned*, const unsigned*>	Literals;
+
+	/// Build index of the literals of trie, encoded in encoding
+	FoldedIndex( const LiteralTrie& trie, const std::string& encoding);
+
+	/// Add literal number k of the trie, a literal LiteralTrie::update() inserted (the literals from k on were
+	/// numbered one less before). The literals of its folded form move to the end of the index.
+	void		insert( unsigned k, const char* literal, size_t len);
+
+	/// Fold text (replaces the content of folded)
+	void		fold( const char* text, size_t len, std::string& folded) const;
+
+	/// Numbers of the literals whose folded form is the same as that of word, in byte order (empty range if there are none)
+	Literals	find( const char* word, size_t len) const;
+
+	/// Number of distinct folded forms
+	size_t		size() const	{ return m_index.size(); }
+
+private:
+	FoldedIndex( const FoldedIndex&);				// not copyable (m_index points into m_chars and m_added)
+	FoldedIndex& operator=( const FoldedIndex&);
+
+	bool							m_utf8;		///< encoding is UTF-8 (else single-byte)
+	unsigned char					m_table[256];	///< folding of the bytes of a single-byte encoding (of ASCII for UTF-8)
+	std::string						m_chars;	///< distinct folded forms, each NUL-terminated
+	std::deque<std::string>			m_added;	///< folded forms added by insert()
+	std::vector<unsigned>			m_literals;	///< numbers of the literals, grouped by folded form
+	StringHashTable< std::pair<unsigned, unsigned> >	m_index;	///< folded form -> (start, count) in m_literals
+};
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __FOLDEDINDEX_H__
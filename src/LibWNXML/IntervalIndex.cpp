@@ -0,0 +1,131 @@
+#include <algorithm>
+#include "IntervalIndex.h"
+
+namespace LibWNXML {
+
+
+namespace {
+
+/// Node being searched for components
+struct Frame
+{
+	WNGraph::tnode			node;
+	const WNGraph::tnode*	cur;	///< next target to search
+	const WNGraph::tnode*	end;
+	unsigned				low;	///< number of components completed when node was reached
+};
+
+} // namespace {
+
+
+IntervalIndex::IntervalIndex( const WNGraph& g, unsigned rel)
+{
+	const unsigned npos = WNGraph::npos;
+	size_t nn = g.size();
+
+	// strongly connected components (Tarjan's algorithm, with an explicit stack), numbered in the
+	// order they are completed: this is a post-order of the DAG of components, the components
+	// completed while the root of a component was being searched are its DFS subtree
+	m_comp.assign( nn, npos);
+	m_low.clear();
+	std::vector<unsigned> index( nn, npos), lowlink( nn, 0);
+	std::vector<WNGraph::tnode> sccstack;
+	std::vector<WNGraph::tnode> members;	// nodes in component order
+	std::vector<unsigned> moffs( 1, 0);		// members of component c are members[moffs[c]..moffs[c+1])
+	std::vector<Frame> stack;
+	unsigned counter = 0;
+	for (WNGraph::tnode s=0; s!=nn; s++) {
+		if (index[s] != npos)
+			continue;
+		WNGraph::tnode v = s;
+		for (;;) {
+			// reach v
+			index[v] = lowlink[v] = counter++;
+			sccstack.push_back( v);
+			WNGraph::Targets t = g.targets( rel, v);
+			Frame f;
+			f.node = v;
+			f.cur = t.first;
+			f.end = t.last;
+			f.low = unsigned( m_low.size());
+			stack.push_back( f);
+			// go on with the first target not reached yet
+			v = npos;
+			while (!stack.empty()) {
+				Frame& top = stack.back();
+				if (top.cur != top.end) {
+					WNGraph::tnode w = *top.cur++;
+					if (index[w] == npos) {
+						v = w;
+						break;
+					}
+					if (m_comp[w] == npos) // on the component stack
+						lowlink[top.node] = std::min( lowlink[top.node], index[w]);
+					continue;
+				}
+				// all targets done: complete component if top.node is its root
+				WNGraph::tnode u = top.node;
+				if (lowlink[u] == index[u]) {
+					unsigned c = unsigned( m_low.size());
+					WNGraph::tnode x;
+					do {
+						x = sccstack.back();
+						sccstack.pop_back();
+						m_comp[x] = c;
+						members.push_back( x);
+					} while (x != u);
+					moffs.push_back( unsigned( members.size()));
+					m_low.push_back( top.low);
+				}
+				stack.pop_back();
+				if (!stack.empty())
+					lowlink[stack.back().node] = std::min( lowlink[stack.back().node], lowlink[u]);
+			}
+			if (v == npos)
+				break;
+		}
+	}
+
+	// labels, in component order (the components pointed to are completed earlier):
+	// own range merged with the labels of the components pointed to
+	size_t nc = m_low.size();
+	m_offsets.assign( 1, 0);
+	m_offsets.reserve( nc + 1);
+	std::vector< std::pair< unsigned, unsigned > > label;
+	for (unsigned c=0; c!=nc; c++) {
+		label.clear();
+		label.push_back( std::make_pair( m_low[c], c));
+		for (unsigned i=moffs[c]; i!=moffs[c+1]; i++) {
+			WNGraph::Targets t = g.targets( rel, members[i]);
+			for (const WNGraph::tnode* p=t.first; p!=t.last; p++) {
+				unsigned d = m_comp[*p];
+				if (d != c)
+					label.insert( label.end(), m_intervals.begin() + m_offsets[d], m_intervals.begin() + m_offsets[d+1]);
+			}
+		}
+		std::sort( label.begin(), label.end());
+		// merge overlapping and adjacent intervals
+		size_t n = 0;
+		for (size_t i=1; i!=label.size(); i++) {
+			if (label[i].first <= label[n].second + 1)
+				label[n].second = std::max( label[n].second, label[i].second);
+			else
+				label[++n] = label[i];
+		}
+		m_intervals.insert( m_intervals.end(), label.begin(), label.begin() + n + 1);
+		m_offsets.push_back( unsigned( m_intervals.size()));
+	}
+}
+
+
+bool IntervalIndex::in_label( unsigned cf, unsigned ct) const
+{
+	// last interval starting at or before ct
+	const std::pair< unsigned, unsigned >* first = &m_intervals[0] + m_offsets[cf];
+	const std::pair< unsigned, unsigned >* last = &m_intervals[0] + m_offsets[cf+1];
+	const std::pair< unsigned, unsigned >* p = std::upper_bound( first, last, std::make_pair( ct, ~0u));
+	return p != first && (p-1)->second >= ct;
+}
+
+
+} // namespace LibWNXML {
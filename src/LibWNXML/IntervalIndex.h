@@ -0,0 +1,57 @@
+#ifndef __INTERVALINDEX_H__
+#define __INTERVALINDEX_H__
+
+#include <utility>
+#include <vector>
+#include "WNGraph.h"
+
+namespace LibWNXML {
+
+/// Reachability index for one relation type of a WNGraph: tells in a few integer comparisons
+/// whether a node can be reached from another one by following the relation (e.g. whether a
+/// synset is under another one by "hyponym").
+///
+/// Cycles are collapsed first: the strongly connected components of the graph form a DAG.
+/// The components are numbered in the post-order of a depth-first search of this DAG, so the
+/// components found from a component in the search (its DFS subtree) have a contiguous range of
+/// numbers, ending with its own. The label of a component is a list of disjoint intervals of
+/// numbers: its own range, merged with the labels of the components it points to (a component with
+/// several parents is only in the range of one of them, the others get it as an extra interval).
+/// For tree-like relations such as hypernymy the labels are short.
+class IntervalIndex
+{
+public:
+
+	/// Build index for relation rel of g (rel may be npos: then nodes only reach themselves)
+	IntervalIndex( const WNGraph& g, unsigned rel);
+
+	/// Check if node to is reachable from node from (every node is reachable from itself)
+	bool	reaches( WNGraph::tnode from, WNGraph::tnode to) const
+	{
+		unsigned cf = m_comp[from], ct = m_comp[to];
+		if (ct <= cf && ct >= m_low[cf]) // in own range
+			return true;
+		return in_label( cf, ct);
+	}
+
+	/// Number of strongly connected components
+	size_t	componentCount() const	{ return m_offsets.size() - 1; }
+
+	/// Number of intervals in all labels
+	size_t	intervalCount() const	{ return m_intervals.size(); }
+
+private:
+
+	/// Check if component ct is in the label of component cf (binary search)
+	bool	in_label( unsigned cf, unsigned ct) const;
+
+	std::vector<unsigned>							m_comp;			///< component of nodes (its post-order number)
+	std::vector<unsigned>							m_low;			///< start of the own range of components
+	std::vector<unsigned>							m_offsets;		///< label of component c is m_intervals[m_offsets[c]..m_offsets[c+1])
+	std::vector< std::pair< unsigned, unsigned > >	m_intervals;	///< [first, last] intervals of labels, disjoint and sorted
+};
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __INTERVALINDEX_H__
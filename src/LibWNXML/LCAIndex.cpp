@@ -0,0 +1,137 @@
+#include <algorithm>
+#include "LCAIndex.h"
+
+namespace LibWNXML {
+
+
+LCAIndex::LCAIndex( const WNGraph& g, unsigned rel)
+{
+	const WNGraph::tnode npos = WNGraph::npos;
+	size_t ns = g.size(); // (phantom nodes are left out)
+	m_depth.assign( ns, -1);
+	m_root.assign( ns, npos);
+	m_top.assign( ns, 0);
+
+	// find chain nodes: follow single targets from every synset not seen yet, until a root,
+	// a branching, a cycle or a synset already classified, then classify the path backwards
+	std::vector<WNGraph::tnode> parent( ns, npos);
+	std::vector<char> state( ns, 0); // 0: not seen, 1: on current path, 2: done
+	std::vector<WNGraph::tnode> path;
+	for (WNGraph::tnode x=0; x!=ns; x++) {
+		if (state[x] == 2 || g.synset( x) == NULL)
+			continue;
+		path.clear();
+		WNGraph::tnode y = x;
+		int depth = -1;				// depth of the last node of the path, -1 if not a chain node
+		WNGraph::tnode root = npos;
+		for (;;) {
+			if (state[y] == 2) { // known: the last node of the path points to it
+				if (m_depth[y] >= 0) {
+					depth = m_depth[y] + 1;
+					root = m_root[y];
+					parent[path.back()] = y;
+				}
+				break;
+			}
+			if (state[y] == 1) // cycle
+				break;
+			state[y] = 1;
+			path.push_back( y);
+			WNGraph::Targets t = g.targets( rel, y);
+			if (t.size() == 1 && g.synset( *t.first) != NULL) { // single target: go on
+				y = *t.first;
+				continue;
+			}
+			if (t.size() <= 1) { // root: no target, or a missing one
+				depth = 0;
+				root = y;
+				m_top[y] = t.empty();
+			}
+			break;
+		}
+		// path[i+1] is the target of path[i]
+		for (size_t i=path.size(); i-- != 0; ) {
+			WNGraph::tnode p = path[i];
+			state[p] = 2;
+			if (depth >= 0) {
+				m_depth[p] = depth;
+				m_root[p] = root;
+				if (i + 1 < path.size())
+					parent[p] = path[i+1];
+				depth++;
+			}
+		}
+	}
+
+	// children of chain nodes (CSR)
+	std::vector<unsigned> coffs( ns + 1, 0);
+	for (WNGraph::tnode n=0; n!=ns; n++)
+		if (parent[n] != npos)
+			coffs[parent[n] + 1]++;
+	for (size_t n=0; n!=ns; n++)
+		coffs[n+1] += coffs[n];
+	std::vector<WNGraph::tnode> children( coffs[ns]);
+	std::vector<unsigned> fill( coffs.begin(), coffs.end() - 1);
+	for (WNGraph::tnode n=0; n!=ns; n++)
+		if (parent[n] != npos)
+			children[fill[parent[n]]++] = n;
+
+	// Euler tour of the trees
+	std::vector<WNGraph::tnode> euler;
+	m_first.assign( ns, ~0u);
+	std::vector< std::pair<WNGraph::tnode, unsigned> > stack; // (node, next child position)
+	for (WNGraph::tnode r=0; r!=ns; r++) {
+		if (m_root[r] != r)
+			continue;
+		stack.push_back( std::make_pair( r, coffs[r]));
+		m_first[r] = unsigned( euler.size());
+		euler.push_back( r);
+		while (!stack.empty()) {
+			std::pair<WNGraph::tnode, unsigned>& top = stack.back();
+			if (top.second == coffs[top.first + 1]) {
+				stack.pop_back();
+				if (!stack.empty())
+					euler.push_back( stack.back().first);
+				continue;
+			}
+			WNGraph::tnode c = children[top.second++];
+			m_first[c] = unsigned( euler.size());
+			euler.push_back( c);
+			stack.push_back( std::make_pair( c, coffs[c]));
+		}
+	}
+
+	// sparse table of minimum depths
+	size_t len = euler.size();
+	m_log.assign( len + 1, 0);
+	for (size_t i=2; i<=len; i++)
+		m_log[i] = m_log[i/2] + 1;
+	m_sparse.push_back( euler);
+	for (size_t k=1; (size_t( 1) << k) <= len; k++) {
+		const std::vector<WNGraph::tnode>& prev = m_sparse[k-1];
+		std::vector<WNGraph::tnode> cur( len - (size_t( 1) << k) + 1);
+		size_t half = size_t( 1) << (k-1);
+		for (size_t i=0; i!=cur.size(); i++) {
+			WNGraph::tnode a = prev[i], b = prev[i + half];
+			cur[i] = m_depth[a] <= m_depth[b] ? a : b;
+		}
+		m_sparse.push_back( std::vector<WNGraph::tnode>());
+		m_sparse.back().swap( cur);
+	}
+}
+
+
+WNGraph::tnode LCAIndex::lca( WNGraph::tnode a, WNGraph::tnode b) const
+{
+	if (m_root[a] != m_root[b])
+		return WNGraph::npos;
+	unsigned i = m_first[a], j = m_first[b];
+	if (i > j)
+		std::swap( i, j);
+	unsigned k = m_log[j - i + 1];
+	WNGraph::tnode x = m_sparse[k][i], y = m_sparse[k][j + 1 - (1u << k)];
+	return m_depth[x] <= m_depth[y] ? x : y;
+}
+
+
+} // namespace LibWNXML {
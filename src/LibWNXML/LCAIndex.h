@@ -0,0 +1,55 @@
+#ifndef __LCAINDEX_H__
+#define __LCAINDEX_H__
+
+#include <vector>
+#include "WNGraph.h"
+
+namespace LibWNXML {
+
+/// Lowest common ancestor index for one relation type of a WNGraph, used for
+/// Leacock-Chodorow similarity.
+///
+/// A synset is a "chain node" if following the relation from it never branches and never
+/// returns to a synset: every synset on the way has exactly one target, up to one with no
+/// target, or only a missing one (the root of the chain). The chain nodes form a forest (the
+/// parent of a node is its target), which is indexed with an Euler tour and a sparse table
+/// of depths, so the lowest common ancestor of two chain nodes is found in constant time.
+/// For other synsets (several targets somewhere, or a cycle) isChain() is false, and the
+/// nodes reachable from them have to be searched.
+class LCAIndex
+{
+public:
+
+	/// Build index for relation rel of g (rel may be npos: then every synset is a root)
+	LCAIndex( const WNGraph& g, unsigned rel);
+
+	/// Check if n is a chain node (false for phantom nodes)
+	bool			isChain( WNGraph::tnode n) const	{ return n < m_depth.size() && m_depth[n] >= 0; }
+
+	/// Distance of chain node from the root of its chain
+	int				depth( WNGraph::tnode n) const		{ return m_depth[n]; }
+
+	/// Root of chain node
+	WNGraph::tnode	root( WNGraph::tnode n) const		{ return m_root[n]; }
+
+	/// Check if the root of chain node n has no relation of the type at all (only then is an
+	/// artificial top added above it, see WNQuery::similarityLeacockChodorow())
+	bool			hasTop( WNGraph::tnode n) const		{ return m_top[m_root[n]] != 0; }
+
+	/// Lowest common ancestor of two chain nodes, npos if they are in different trees
+	WNGraph::tnode	lca( WNGraph::tnode a, WNGraph::tnode b) const;
+
+private:
+
+	std::vector<int>							m_depth;	///< depth of chain nodes, -1 for others
+	std::vector<WNGraph::tnode>					m_root;		///< root of chain nodes
+	std::vector<char>							m_top;		///< for roots: no target at all
+	std::vector<unsigned>						m_first;	///< first position of chain nodes in the Euler tour
+	std::vector< std::vector<WNGraph::tnode> >	m_sparse;	///< m_sparse[k][i]: node of minimum depth in Euler tour [i, i+2^k)
+	std::vector<unsigned char>					m_log;		///< floor(log2(i))
+};
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __LCAINDEX_H__
@@ -0,0 +1,629 @@
+#include <string.h>
+#include <algorithm>
+#include <queue>
+#include "LiteralTrie.h"
+#include "WNGraph.h"
+
+namespace LibWNXML {
+
+
+namespace {
+
+const unsigned	TagLiterals = snapshotTag( 'T','R','L','I');	///< number of literals, then each: literal, number of senses in n, v, a, b
+const unsigned	TagNodes = snapshotTag( 'T','R','N','O');		///< number of nodes, then each: begin, end, depth, child, nchildren, best
+
+/// Most literals update() inserts one by one (each moves all literals after it), more are merged by building again
+const size_t	MaxInserted = 64;
+
+/// Orders literal numbers of a graph by their literals
+struct LiteralLess
+{
+	const WNGraph&	g;
+
+	LiteralLess( const WNGraph& graph)
+		: g( graph)
+	{}
+
+	bool operator()( unsigned a, unsigned b) const	{ return g.literal( a) < g.literal( b); }
+};
+
+/// Orders counts by literal, then POS
+struct CountLess
+{
+	bool operator()( const LiteralTrie::Count* a, const LiteralTrie::Count* b) const
+	{
+		int c = a->literal.compare( b->literal);
+		return c != 0 ? c < 0 : a->pos < b->pos;
+	}
+};
+
+} // namespace {
+
+
+struct LiteralTrie::Candidate
+{
+	unsigned	score;		///< number of senses of a literal, upper limit of them for a node
+	unsigned	begin;		///< literal number, first literal of a node
+	unsigned	node;		///< npos for a literal
+
+	Candidate( unsigned s, unsigned b, unsigned n)
+		: score( s), begin( b), node( n)
+	{}
+
+	/// Order of the priority queue (the greatest is the best): higher score first, then lower literal number,
+	/// a literal before the node it's the first literal of. So no literal is taken while a node holding
+	/// a literal that comes before it is in the queue.
+	bool operator<( const Candidate& o) const
+	{
+		if (score != o.score)
+			return score < o.score;
+		if (begin != o.begin)
+			return begin > o.begin;
+		return node != npos && o.node == npos;
+	}
+};
+
+
+LiteralTrie::LiteralTrie()
+{
+	clear();
+}
+
+
+void LiteralTrie::clear()
+{
+	m_chars.clear();
+	m_offsets.assign( 1, 0);
+	m_senses.clear();
+	m_nodes.clear();
+	m_unused = 0;
+	m_patched = false;
+}
+
+
+void LiteralTrie::append( const char* lit, size_t len, const unsigned* senses)
+{
+	m_chars.append( lit, len);
+	m_chars.push_back( '\0');
+	m_offsets.push_back( unsigned( m_chars.size()));
+	m_senses.insert( m_senses.end(), senses, senses + 4);
+}
+
+
+void LiteralTrie::build( const WNGraph& n, const WNGraph& v, const WNGraph& a, const WNGraph& b)
+{
+	clear();
+
+	// the literals with senses of each graph in byte order (they are numbered so, unless the graph was patched)
+	const WNGraph* g[4] = { &n, &v, &a, &b };
+	std::vector<unsigned> order[4];
+	for (int p=0; p!=4; p++) {
+		order[p].reserve( g[p]->literalCount());
+		for (unsigned l=0; l!=g[p]->literalCount(); l++)
+			if (!g[p]->literalSenses( l).empty())
+				order[p].push_back( l);
+		if (!std::is_sorted( order[p].begin(), order[p].end(), LiteralLess( *g[p])))
+			std::sort( order[p].begin(), order[p].end(), LiteralLess( *g[p]));
+	}
+
+	// merged
+	size_t l[4] = { 0, 0, 0, 0 };
+	for (;;) {
+		const std::string* lit = NULL;
+		for (int p=0; p!=4; p++)
+			if (l[p] != order[p].size() && (lit == NULL || g[p]->literal( order[p][l[p]]) < *lit))
+				lit = &g[p]->literal( order[p][l[p]]);
+		if (lit == NULL)
+			break;
+		unsigned c[4];
+		for (int p=0; p!=4; p++) {
+			c[p] = 0;
+			if (l[p] != order[p].size() && g[p]->literal( order[p][l[p]]) == *lit)
+				c[p] = unsigned( g[p]->literalSenses( order[p][l[p]++]).size());
+		}
+		append( lit->data(), lit->size(), c);
+	}
+	build_nodes();
+}
+
+
+void LiteralTrie::build_nodes()
+{
+	m_nodes.clear();
+	m_unused = 0;
+	m_patched = false;
+	if (size() == 0)
+		return;
+
+	// nodes, breadth-first: a node's prefix is the common prefix of its literals, its children split them
+	// by the byte that follows it
+	Node root = { 0, unsigned( size()), 0, 0, 0, 0 };
+	m_nodes.push_back( root);
+	for (size_t i=0; i!=m_nodes.size(); i++) {
+		const unsigned end = m_nodes[i].end;
+		unsigned depth = 0;
+		const char* first = literal( m_nodes[i].begin);
+		const char* last = literal( end - 1);
+		while (first[depth] == last[depth] && first[depth] != '\0')
+			depth++;
+		m_nodes[i].depth = depth;
+		m_nodes[i].child = unsigned( m_nodes.size());
+
+		unsigned l = m_nodes[i].begin;
+		if (length( l) == depth) // literal ending at the node
+			l++;
+		while (l != end) {
+			unsigned char c = (unsigned char) literal( l)[depth];
+			unsigned e = l + 1;
+			while (e != end && (unsigned char) literal( e)[depth] == c)
+				e++;
+			Node child = { l, e, 0, 0, 0, 0 };
+			m_nodes.push_back( child);
+			m_nodes[i].nchildren++;
+			l = e;
+		}
+	}
+
+	// highest number of senses, bottom-up (children come after their parents)
+	for (size_t i=m_nodes.size(); i-- != 0; )
+		set_best( m_nodes[i]);
+}
+
+
+void LiteralTrie::set_best( Node& nd) const
+{
+	nd.best = length( nd.begin) == nd.depth ? senses( nd.begin, -1) : 0;
+	for (unsigned c=nd.child; c!=nd.child+nd.nchildren; c++)
+		nd.best = std::max( nd.best, m_nodes[c].best);
+}
+
+
+void LiteralTrie::rebuild( size_t nsorted)
+{
+	std::string chars;
+	std::vector<unsigned> offsets, senses;
+	chars.swap( m_chars);
+	offsets.swap( m_offsets);
+	senses.swap( m_senses);
+	clear();
+
+	size_t i = 0, j = nsorted, n = senses.size() / 4;
+	while (i != nsorted || j != n) {
+		size_t l = j == n || (i != nsorted && strcmp( chars.data() + offsets[i], chars.data() + offsets[j]) < 0) ? i++ : j++;
+		if (senses[4*l] + senses[4*l+1] + senses[4*l+2] + senses[4*l+3] != 0)
+			append( chars.data() + offsets[l], offsets[l+1] - offsets[l] - 1, &senses[4*l]);
+	}
+	build_nodes();
+}
+
+
+bool LiteralTrie::update( const std::vector<Count>& counts, std::vector<unsigned>& added)
+{
+	added.clear();
+
+	// in byte order, so the numbers of the literals inserted stay (the last count of a literal in a POS holds)
+	std::vector<const Count*> order( counts.size());
+	for (size_t i=0; i!=counts.size(); i++)
+		order[i] = &counts[i];
+	std::stable_sort( order.begin(), order.end(), CountLess());
+
+	// the counts of a literal: [i, e)
+	size_t nnew = 0;
+	for (size_t i=0, e; i!=order.size(); i=e) {
+		unsigned total = 0;
+		for (e=i; e!=order.size() && order[e]->literal == order[i]->literal; e++)
+			total += order[e]->senses;
+		if (total != 0 && lookup( order[i]->literal.data(), order[i]->literal.size()) == npos)
+			nnew++;
+	}
+
+	if (nnew > MaxInserted || 2 * m_unused > m_nodes.size()) {
+		// build again: the new literals are appended (in byte order), then merged into the others
+		size_t nold = size();
+		for (size_t i=0, e; i!=order.size(); i=e) {
+			const std::string& lit = order[i]->literal;
+			unsigned l = lookup( lit.data(), lit.size());
+			if (l == npos) {
+				const unsigned none[4] = { 0, 0, 0, 0 };
+				append( lit.data(), lit.size(), none);
+				l = unsigned( size() - 1);
+			}
+			for (e=i; e!=order.size() && order[e]->literal == lit; e++)
+				m_senses[4*l+order[e]->pos] = order[e]->senses;
+		}
+		rebuild( nold);
+		return false;
+	}
+
+	std::vector<unsigned> path;
+	for (size_t i=0, e; i!=order.size(); i=e) {
+		const std::string& lit = order[i]->literal;
+		unsigned total = 0;
+		for (e=i; e!=order.size() && order[e]->literal == lit; e++)
+			total += order[e]->senses;
+		unsigned l = lookup( lit.data(), lit.size());
+		if (l == npos) {
+			if (total == 0)
+				continue;
+			l = insert( lit.data(), lit.size());
+			added.push_back( l);
+		}
+		for (size_t j=i; j!=e; j++)
+			m_senses[4*l+order[j]->pos] = order[j]->senses;
+
+		// highest numbers of senses along the path of the literal
+		find( lit.data(), lit.size(), &path);
+		for (size_t j=path.size(); j-- != 0; )
+			set_best( m_nodes[path[j]]);
+		m_patched = true;
+	}
+	return true;
+}
+
+
+unsigned LiteralTrie::insert( const char* lit, size_t len)
+{
+	m_patched = true;
+	const unsigned none[4] = { 0, 0, 0, 0 };
+	if (m_nodes.empty()) {
+		clear();
+		append( lit, len, none);
+		Node root = { 0, 1, unsigned( len), 0, 0, 0 };
+		m_nodes.push_back( root);
+		m_patched = true;
+		return 0;
+	}
+
+	// its number: the literals before it in byte order
+	unsigned k = 0, hi = unsigned( size());
+	while (k < hi) {
+		unsigned mid = (k + hi) / 2;
+		size_t ml = length( mid);
+		int c = memcmp( literal( mid), lit, std::min( ml, len));
+		if (c < 0 || (c == 0 && ml < len))
+			k = mid + 1;
+		else
+			hi = mid;
+	}
+
+	// the nodes whose prefixes it starts with, down to where it leaves the trie: d bytes match there
+	std::vector<unsigned> path;
+	size_t d = 0;
+	for (unsigned ni=0; ; ) {
+		path.push_back( ni);
+		const Node& nd = m_nodes[ni];
+		const char* l = literal( nd.begin);
+		while (d != nd.depth && d != len && l[d] == lit[d])
+			d++;
+		if (d != nd.depth || d == len)
+			break;
+		unsigned c = lower_child( nd, (unsigned char) lit[d]);
+		if (c == nd.child + nd.nchildren || label( m_nodes[c], nd.depth) != (unsigned char) lit[d])
+			break;
+		ni = c;
+	}
+
+	// literals (the ones of the nodes on the path get it, those of the others from k on move up one)
+	unsigned at = m_offsets[k];
+	m_chars.insert( at, lit, len);
+	m_chars.insert( at + len, 1, '\0');
+	m_offsets.insert( m_offsets.begin() + k, at);
+	for (size_t i=k+1; i!=m_offsets.size(); i++)
+		m_offsets[i] += unsigned( len + 1);
+	m_senses.insert( m_senses.begin() + 4 * k, none, none + 4);
+	std::vector<Node> before( path.size());
+	for (size_t i=0; i!=path.size(); i++)
+		before[i] = m_nodes[path[i]];
+	for (size_t i=0; i!=m_nodes.size(); i++)
+		if (m_nodes[i].begin >= k) {
+			m_nodes[i].begin++;
+			m_nodes[i].end++;
+		}
+	for (size_t i=0; i!=path.size(); i++) {
+		m_nodes[path[i]] = before[i];
+		m_nodes[path[i]].end++;
+	}
+
+	// nodes
+	const unsigned ni = path.back();
+	const Node leaf = { k, k + 1, unsigned( len), 0, 0, 0 };
+	if (d != m_nodes[ni].depth) {
+		// split: the node stands for the common prefix, its old content moves to a child
+		Node rest = before.back();
+		if (rest.begin >= k) {
+			rest.begin++;
+			rest.end++;
+		}
+		Node& nd = m_nodes[ni];
+		nd.depth = unsigned( d);
+		nd.child = unsigned( m_nodes.size());
+		nd.nchildren = d == len ? 1 : 2;
+		if (d != len && (unsigned char) lit[d] < label( rest, unsigned( d)))
+			m_nodes.push_back( leaf);
+		m_nodes.push_back( rest);
+		if (d != len && (unsigned char) lit[d] > label( rest, unsigned( d)))
+			m_nodes.push_back( leaf);
+	}
+	else if (d != len) {
+		// new child: the children move to the end, with it among them
+		Node nd = m_nodes[ni];
+		unsigned c = lower_child( nd, (unsigned char) lit[d]);
+		unsigned child = unsigned( m_nodes.size());
+		for (unsigned i=nd.child; i!=c; i++)
+			m_nodes.push_back( m_nodes[i]);
+		m_nodes.push_back( leaf);
+		for (unsigned i=c; i!=nd.child+nd.nchildren; i++)
+			m_nodes.push_back( m_nodes[i]);
+		m_unused += nd.nchildren;
+		m_nodes[ni].child = child;
+		m_nodes[ni].nchildren++;
+	}
+	// (else it ends at the node, as the first of its literals)
+	return k;
+}
+
+
+unsigned LiteralTrie::find( const char* prefix, size_t len, std::vector<unsigned>* path) const
+{
+	if (path != NULL)
+		path->clear();
+	if (m_nodes.empty())
+		return npos;
+	unsigned ni = 0;
+	size_t pd = 0; // depth of parent
+	for (;;) {
+		if (path != NULL)
+			path->push_back( ni);
+		const Node& nd = m_nodes[ni];
+		// match label
+		const char* lit = literal( nd.begin);
+		for (size_t d=pd; d!=nd.depth && d!=len; d++)
+			if (lit[d] != prefix[d])
+				return npos;
+		if (len <= nd.depth)
+			return ni;
+
+		// child whose label starts with the next byte of prefix
+		pd = nd.depth;
+		unsigned char c = (unsigned char) prefix[pd];
+		unsigned lo = lower_child( nd, c);
+		if (lo == nd.child + nd.nchildren || label( m_nodes[lo], unsigned( pd)) != c)
+			return npos;
+		ni = lo;
+	}
+}
+
+
+unsigned LiteralTrie::lower_child( const Node& nd, unsigned char c) const
+{
+	unsigned lo = nd.child, hi = nd.child + nd.nchildren;
+	while (lo < hi) {
+		unsigned mid = (lo + hi) / 2;
+		if (label( m_nodes[mid], nd.depth) < c)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+
+unsigned LiteralTrie::lookup( const char* lit, size_t len) const
+{
+	unsigned ni = find( lit, len);
+	return ni != npos && length( m_nodes[ni].begin) == len ? m_nodes[ni].begin : npos;
+}
+
+
+std::pair<unsigned, unsigned> LiteralTrie::prefixRange( const char* prefix, size_t len) const
+{
+	unsigned ni = find( prefix, len);
+	if (ni == npos)
+		return std::make_pair( 0u, 0u);
+	return std::make_pair( m_nodes[ni].begin, m_nodes[ni].end);
+}
+
+
+void LiteralTrie::complete( const char* prefix, size_t len, int p, size_t k, std::vector<unsigned>& results) const
+{
+	results.clear();
+	unsigned ni = find( prefix, len);
+	if (ni == npos || k == 0)
+		return;
+
+	// the prefix itself
+	unsigned exact = npos;
+	if (length( m_nodes[ni].begin) == len) {
+		exact = m_nodes[ni].begin;
+		if (senses( exact, p) != 0)
+			results.push_back( exact);
+	}
+
+	// the others best-first: nodes are expanded in the order of the highest number of senses under them,
+	// a literal is taken when no node in the queue can hold a better one
+	std::priority_queue<Candidate> queue;
+	queue.push( Candidate( m_nodes[ni].best, m_nodes[ni].begin, ni));
+	while (!queue.empty() && results.size() < k) {
+		Candidate c = queue.top();
+		queue.pop();
+		if (c.node == npos) {
+			results.push_back( c.begin);
+			continue;
+		}
+		const Node& nd = m_nodes[c.node];
+		if (length( nd.begin) == nd.depth && nd.begin != exact) {
+			unsigned s = senses( nd.begin, p);
+			if (s != 0)
+				queue.push( Candidate( s, nd.begin, npos));
+		}
+		for (unsigned ch=nd.child; ch!=nd.child+nd.nchildren; ch++)
+			queue.push( Candidate( m_nodes[ch].best, m_nodes[ch].begin, ch));
+	}
+}
+
+
+void LiteralTrie::approximate( const char* word, size_t len, unsigned maxdist, int p, size_t k, std::vector< std::pair<unsigned, unsigned> >& results) const
+{
+	results.clear();
+	if (m_nodes.empty() || k == 0)
+		return;
+
+	// rows[d*w .. d*w+len] are the distances of the prefixes of word from the first d bytes of the path walked
+	const size_t w = len + 1;
+	std::vector<unsigned> rows( w);
+	for (size_t j=0; j<=len; j++)
+		rows[j] = unsigned( j);
+	std::vector< std::pair<unsigned, unsigned> > stack; // nodes to visit, with the depth of their parents
+	stack.push_back( std::make_pair( 0u, 0u));
+	while (!stack.empty()) {
+		unsigned ni = stack.back().first;
+		unsigned d = stack.back().second;
+		stack.pop_back();
+		const Node& nd = m_nodes[ni];
+
+		// rows of the bytes of the label
+		if (rows.size() < (nd.depth + 1) * w)
+			rows.resize( (nd.depth + 1) * w);
+		const char* lit = literal( nd.begin);
+		bool reachable = true;
+		for (; d != nd.depth && reachable; d++) {
+			const unsigned* prev = &rows[d * w];
+			unsigned* row = &rows[(d + 1) * w];
+			row[0] = d + 1;
+			unsigned best = row[0];
+			for (size_t j=1; j<=len; j++) {
+				row[j] = std::min( std::min( prev[j], row[j-1]) + 1, prev[j-1] + (word[j-1] == lit[d] ? 0 : 1));
+				best = std::min( best, row[j]);
+			}
+			reachable = best <= maxdist;
+		}
+		if (!reachable)
+			continue;
+
+		// literal ending at the node
+		unsigned dist = rows[nd.depth * w + len];
+		if (length( nd.begin) == nd.depth && dist <= maxdist && senses( nd.begin, p) != 0)
+			results.push_back( std::make_pair( nd.begin, dist));
+
+		for (unsigned ch=nd.child; ch!=nd.child+nd.nchildren; ch++)
+			stack.push_back( std::make_pair( ch, nd.depth));
+	}
+
+	// nearest first, then by number of senses, then in byte order
+	std::vector< std::pair< std::pair<unsigned, int>, unsigned > > order( results.size());
+	for (size_t i=0; i!=results.size(); i++)
+		order[i] = std::make_pair( std::make_pair( results[i].second, - int( senses( results[i].first, p))), results[i].first);
+	std::sort( order.begin(), order.end());
+	if (order.size() > k)
+		order.resize( k);
+	results.resize( order.size());
+	for (size_t i=0; i!=order.size(); i++)
+		results[i] = std::make_pair( order[i].second, order[i].first.first);
+}
+
+
+void LiteralTrie::save( SnapshotWriter& w) const
+{
+	if (m_patched) {
+		// as build() would make it, so the snapshot is the same as one of the patched file
+		LiteralTrie t;
+		t.m_chars = m_chars;
+		t.m_offsets = m_offsets;
+		t.m_senses = m_senses;
+		t.rebuild( t.size());
+		t.save( w);
+		return;
+	}
+
+	w.beginSection( TagLiterals);
+	w.put( unsigned( size()));
+	for (unsigned i=0; i!=size(); i++) {
+		w.putString( literal( i));
+		for (int p=0; p!=4; p++)
+			w.put( m_senses[4*i+p]);
+	}
+
+	w.beginSection( TagNodes);
+	w.put( unsigned( m_nodes.size()));
+	for (size_t i=0; i!=m_nodes.size(); i++) {
+		const Node& nd = m_nodes[i];
+		w.put( nd.begin);
+		w.put( nd.end);
+		w.put( nd.depth);
+		w.put( nd.child);
+		w.put( nd.nchildren);
+		w.put( nd.best);
+	}
+}
+
+
+void LiteralTrie::load( const SnapshotReader& rdr)
+{
+	clear();
+	try {
+		SnapshotCursor lc( rdr, TagLiterals);
+		unsigned nlit = lc.get();
+		for (unsigned i=0; i!=nlit; i++) {
+			const char* lit = rdr.str( lc.get());
+			// (in byte order, each once, as the searches expect)
+			if (i != 0 && strcmp( literal( i - 1), lit) >= 0) {
+				ML_THROW_EXC( "Literal trie literals out of order at " << i, WNSnapshotException);
+			}
+			m_chars.append( lit, strlen( lit) + 1);
+			m_offsets.push_back( unsigned( m_chars.size()));
+			for (int p=0; p!=4; p++)
+				m_senses.push_back( lc.get());
+		}
+
+		SnapshotCursor nc( rdr, TagNodes);
+		unsigned nnodes = nc.get();
+		m_nodes.resize( nnodes);
+		for (unsigned i=0; i!=nnodes; i++) {
+			Node& nd = m_nodes[i];
+			nd.begin = nc.get();
+			nd.end = nc.get();
+			nd.depth = nc.get();
+			nd.child = nc.get();
+			nd.nchildren = nc.get();
+			nd.best = nc.get();
+			// (children after their parents, so searches end)
+			if (nd.begin >= nd.end || nd.end > nlit || nd.depth > length( nd.begin)
+				|| (nd.nchildren != 0 && (nd.child <= i || nd.child > nnodes || nd.nchildren > nnodes - nd.child))) {
+				ML_THROW_EXC( "Invalid literal trie node " << i, WNSnapshotException);
+			}
+		}
+
+		// structure as build() makes it: the root holds all literals, the children of a node are deeper and split
+		// its literals (except the one ending at the node) into consecutive ranges, every node but the root has one parent
+		if ((nnodes == 0) != (nlit == 0) || (nnodes != 0 && (m_nodes[0].begin != 0 || m_nodes[0].end != nlit))) {
+			ML_THROW_EXC( "Invalid literal trie root", WNSnapshotException);
+		}
+		std::vector<char> parent( nnodes, 0);
+		for (unsigned i=0; i!=nnodes; i++) {
+			const Node& nd = m_nodes[i];
+			unsigned l = length( nd.begin) == nd.depth ? nd.begin + 1 : nd.begin;
+			for (unsigned c=nd.child; c!=nd.child+nd.nchildren; c++) {
+				const Node& ch = m_nodes[c];
+				if (parent[c] != 0 || ch.depth <= nd.depth || ch.begin != l) {
+					ML_THROW_EXC( "Invalid literal trie node " << c, WNSnapshotException);
+				}
+				parent[c] = 1;
+				l = ch.end;
+			}
+			if (l != nd.end) {
+				ML_THROW_EXC( "Invalid literal trie node " << i, WNSnapshotException);
+			}
+		}
+		for (unsigned i=1; i<nnodes; i++)
+			if (parent[i] == 0) {
+				ML_THROW_EXC( "Invalid literal trie node " << i, WNSnapshotException);
+			}
+	}
+	catch (...) {
+		clear();
+		throw;
+	}
+}
+
+
+} // namespace LibWNXML {
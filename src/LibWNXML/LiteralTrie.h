@@ -0,0 +1,151 @@
+#ifndef __LITERALTRIE_H__
+#define __LITERALTRIE_H__
+
+#include <string>
+#include <vector>
+#include "WNSnapshot.h"
+
+namespace LibWNXML {
+
+class WNGraph;
+
+/// Compact trie (radix tree) of the literals of all POS, for prefix search and completion
+/// (see WNQuery::completeLiteral()).
+///
+/// The literals are numbered in byte order, so the literals starting with a prefix have consecutive numbers.
+/// Every node covers such a range of literals; its label is the part of the first literal of the range between
+/// the depth of its parent and its own depth, so no labels are stored, only the literals themselves.
+/// The children of a node are consecutive nodes, ordered by the first byte of their labels.
+/// Each node also keeps the highest number of senses of the literals under it, so the literals with the most
+/// senses can be found best-first, without visiting the whole subtree of a short prefix.
+///
+/// A node takes 6 32-bit words, and all data is in flat arrays, so it can be saved into a snapshot as it is.
+///
+/// A patch (see WNQuery::applyPatch()) changes the numbers of senses in place, and inserts the few new literals
+/// into the trie (renumbering the literals after them); the nodes it adds or moves go at the end, the ones it
+/// leaves are unused until the trie is built again. Literals left with no senses stay, the searches skip them.
+class LiteralTrie
+{
+public:
+
+	/// New number of senses of a literal in a POS, for update()
+	struct Count
+	{
+		std::string	literal;
+		int			pos;		///< POS number (0..3: n, v, a, b)
+		unsigned	senses;
+	};
+
+	LiteralTrie();
+
+	/// Build from the literal indices of the graphs of the POS n, v, a and b (replaces the current content)
+	void	build( const WNGraph& n, const WNGraph& v, const WNGraph& a, const WNGraph& b);
+
+	/// Set the numbers of senses of literals changed by a patch, inserting the new literals.
+	/// If there are too many new literals (or unused nodes) for that, the trie is built again from its literals instead,
+	/// leaving out the ones with no senses.
+	/// @param added numbers of the inserted literals, in increasing order (cleared first): the literals from
+	/// each of them on were numbered one less before it was inserted
+	/// @return false if the trie was built again (all literal numbers may have changed)
+	bool	update( const std::vector<Count>& counts, std::vector<unsigned>& added);
+
+	/// Number of literals (after update(), also the ones left with no senses)
+	size_t		size() const					{ return m_senses.size() / 4; }
+
+	/// Literal number i (NUL-terminated)
+	const char*	literal( unsigned i) const		{ return m_chars.data() + m_offsets[i]; }
+
+	/// Length of literal number i
+	size_t		length( unsigned i) const		{ return m_offsets[i+1] - m_offsets[i] - 1; }
+
+	/// Number of senses of literal number i in POS number p (0..3: n, v, a, b), or in all POS (p = -1)
+	unsigned	senses( unsigned i, int p) const
+	{ return p < 0 ? m_senses[4*i] + m_senses[4*i+1] + m_senses[4*i+2] + m_senses[4*i+3] : m_senses[4*i+p]; }
+
+	/// Numbers of the literals starting with prefix: [first, last), empty if there are none
+	std::pair<unsigned, unsigned>	prefixRange( const char* prefix, size_t len) const;
+
+	/// Get the k best literals starting with prefix: the prefix itself if it's a literal, then the others by decreasing
+	/// number of senses, literals with the same number of senses in byte order.
+	/// @param p POS number (0..3: n, v, a, b): only literals with senses in this POS, ranked by them; -1 for all POS
+	/// @param results literal numbers, best first (cleared first)
+	void	complete( const char* prefix, size_t len, int p, size_t k, std::vector<unsigned>& results) const;
+
+	/// Get the k literals nearest to word by Levenshtein distance (number of bytes inserted, deleted or replaced),
+	/// at most maxdist away, nearest first, literals at the same distance by decreasing number of senses, then in byte order.
+	/// The trie is walked depth-first with a row of distances per byte of the path, and subtrees are skipped as soon as
+	/// no distance in the row is within maxdist, so only a small part of the trie is visited for small distances.
+	/// @param p POS number (0..3: n, v, a, b): only literals with senses in this POS, ranked by them; -1 for all POS
+	/// @param results (literal number, distance) pairs, nearest first (cleared first)
+	void	approximate( const char* word, size_t len, unsigned maxdist, int p, size_t k, std::vector< std::pair<unsigned, unsigned> >& results) const;
+
+	/// Append the trie to a snapshot, as sections of its own (after update(), as build() would make it)
+	void	save( SnapshotWriter& w) const;
+
+	/// Load trie saved by save() (replaces the current content)
+	/// @exception WNSnapshotException if the trie in the snapshot is missing or invalid (literals out of order, nodes
+	/// not nested as build() makes them)
+	void	load( const SnapshotReader& rdr) throw(WNSnapshotException);
+
+private:
+	LiteralTrie( const LiteralTrie&);				// not copyable
+	LiteralTrie& operator=( const LiteralTrie&);
+
+	struct Node
+	{
+		unsigned	begin;		///< literals [begin, end) are under the node
+		unsigned	end;
+		unsigned	depth;		///< length of the prefix the node stands for (if literal begin has this length, it ends here)
+		unsigned	child;		///< first child
+		unsigned	nchildren;
+		unsigned	best;		///< highest number of senses (in all POS) of the literals under the node
+	};
+
+	/// Candidate of the best-first search of complete()
+	struct Candidate;
+
+	/// Clear content
+	void		clear();
+
+	/// Append a literal with its numbers of senses in n, v, a, b
+	void		append( const char* lit, size_t len, const unsigned* senses);
+
+	/// Make the nodes over the literals (which must be in byte order)
+	void		build_nodes();
+
+	/// Build again from the literals with senses, the literals from nsorted on (in byte order too) merged into the others
+	void		rebuild( size_t nsorted);
+
+	/// Node where the literals starting with prefix are, npos if there are none
+	/// @param path if not NULL, gets the nodes from the root to it
+	unsigned	find( const char* prefix, size_t len, std::vector<unsigned>* path = NULL) const;
+
+	/// Number of literal lit, npos if it's not in the trie
+	unsigned	lookup( const char* lit, size_t len) const;
+
+	/// First child of node nd whose label starts with byte c or a later one
+	unsigned	lower_child( const Node& nd, unsigned char c) const;
+
+	/// Insert a literal that is not in the trie, with no senses, return its number
+	unsigned	insert( const char* lit, size_t len);
+
+	/// Compute the highest number of senses of the literals under node nd (from its children's)
+	void		set_best( Node& nd) const;
+
+	/// First byte of the label of node n, whose parent's depth is depth
+	unsigned char	label( const Node& n, unsigned depth) const	{ return (unsigned char) m_chars[m_offsets[n.begin] + depth]; }
+
+	static const unsigned	npos = ~0u;
+
+	std::string				m_chars;	///< literals, in byte order, each NUL-terminated
+	std::vector<unsigned>	m_offsets;	///< start of literal i in m_chars is m_offsets[i], and the end of the last one
+	std::vector<unsigned>	m_senses;	///< number of senses of literal i in n, v, a, b: m_senses[4*i..4*i+3]
+	std::vector<Node>		m_nodes;	///< root first; build() puts the parents before their children, update() adds nodes at the end
+	size_t					m_unused;	///< number of nodes left by update() (in no child range)
+	bool					m_patched;	///< changed by update() since built or loaded
+};
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __LITERALTRIE_H__
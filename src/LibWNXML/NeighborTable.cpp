@@ -0,0 +1,237 @@
+#include <string.h>
+#include <algorithm>
+#include "NeighborTable.h"
+#include "ThreadPool.h"
+
+namespace LibWNXML {
+
+
+namespace {
+
+const unsigned	TagHeader = snapshotTag( 'N','B','R','H');	///< pos, relation, k, addArtificialTop, number of synsets
+const unsigned	TagIDs = snapshotTag( 'N','B','R','I');		///< synset ids
+const unsigned	TagOffsets = snapshotTag( 'N','B','R','O');	///< start of the neighbors of each synset, and the end of the last
+const unsigned	TagEntries = snapshotTag( 'N','B','R','E');	///< neighbors: synset index, score (a double, in 2 words)
+
+/// Order of nodes by id
+struct IdLess
+{
+	const WNGraph&	g;
+
+	IdLess( const WNGraph& gr)
+		: g( gr)
+	{}
+
+	bool operator()( WNGraph::tnode a, WNGraph::tnode b) const	{ return g.id( a) < g.id( b); }
+};
+
+} // namespace {
+
+
+struct NeighborTable::BuildJob : public ThreadPool::Job
+{
+	const WNQuery&		wn;
+	const WNGraph&		g;
+	const std::vector<WNGraph::tnode>&	nodes;
+	unsigned			rel;
+	size_t				k;
+	bool				addTop;
+	std::vector< std::vector< std::pair< WNGraph::tnode, double > > >&	results;
+
+	BuildJob( const WNQuery& w, const WNGraph& gr, const std::vector<WNGraph::tnode>& ns, unsigned r, size_t kk, bool t, std::vector< std::vector< std::pair< WNGraph::tnode, double > > >& res)
+		: wn( w), g( gr), nodes( ns), rel( r), k( kk), addTop( t), results( res)
+	{}
+
+	void run( size_t i)
+	{
+		wn.nearest_nodes( g, nodes[i], rel, k, addTop, results[i]);
+	}
+};
+
+
+NeighborTable::NeighborTable()
+	: m_wn( NULL)
+	, m_generation( 0)
+	, m_k( 0)
+	, m_addtop( false)
+{}
+
+
+void NeighborTable::clear()
+{
+	m_wn = NULL;
+	m_generation = 0;
+	m_pos.clear();
+	m_relation.clear();
+	m_k = 0;
+	m_addtop = false;
+	m_index.clear();
+	m_ids.clear();
+	m_offsets.clear();
+	m_entries.clear();
+}
+
+
+void NeighborTable::index()
+{
+	m_index.clear();
+	m_index.reserve( m_ids.size());
+	for (size_t i=0; i!=m_ids.size(); i++)
+		m_index.insert( m_ids[i].data(), m_ids[i].size(), unsigned( i));
+}
+
+
+void NeighborTable::build(	const WNQuery& wn,
+							const std::string& pos,
+							const std::string& relation,
+							size_t k,
+							const bool addArtificialTop,
+							ThreadPool* pool)
+{
+	const WNGraph& g = wn.graph( pos);
+	clear();
+	m_pos = pos;
+	m_relation = relation;
+	m_k = k;
+	m_addtop = addArtificialTop;
+	m_wn = &wn;
+	m_generation = wn.generation();
+
+	// the synset nodes in id order (their node numbers are, unless the graph was patched), and their positions among them
+	std::vector<WNGraph::tnode> nodes;
+	nodes.reserve( g.synsetCount());
+	for (WNGraph::tnode n=0; n!=g.size(); n++)
+		if (g.synset( n) != NULL)
+			nodes.push_back( n);
+	if (!std::is_sorted( nodes.begin(), nodes.end(), IdLess( g)))
+		std::sort( nodes.begin(), nodes.end(), IdLess( g));
+	std::vector<unsigned> position( g.size(), 0);
+	for (size_t i=0; i!=nodes.size(); i++)
+		position[nodes[i]] = unsigned( i);
+
+	// neighbors of every synset node
+	size_t ns = nodes.size();
+	std::vector< std::vector< std::pair< WNGraph::tnode, double > > > results( ns);
+	if (k != 0) {
+		BuildJob job( wn, g, nodes, g.relation( relation), k, addArtificialTop, results);
+		if (pool != NULL)
+			pool->run( job, ns);
+		else
+			for (size_t i=0; i!=ns; i++)
+				job.run( i);
+	}
+
+	m_ids.reserve( ns);
+	m_offsets.reserve( ns + 1);
+	m_offsets.push_back( 0);
+	for (size_t i=0; i!=ns; i++) {
+		m_ids.push_back( g.id( nodes[i]));
+		for (size_t j=0; j!=results[i].size(); j++) {
+			Entry e;
+			e.synset = position[results[i][j].first];
+			e.score = results[i][j].second;
+			m_entries.push_back( e);
+		}
+		m_offsets.push_back( unsigned( m_entries.size()));
+	}
+	index();
+}
+
+
+void NeighborTable::save( const std::string& filename) const
+{
+	SnapshotWriter w;
+
+	w.beginSection( TagHeader);
+	w.putString( m_pos);
+	w.putString( m_relation);
+	w.put( unsigned( m_k));
+	w.put( m_addtop ? 1 : 0);
+	w.put( unsigned( m_ids.size()));
+
+	w.beginSection( TagIDs);
+	for (size_t i=0; i!=m_ids.size(); i++)
+		w.putString( m_ids[i]);
+
+	w.beginSection( TagOffsets);
+	for (size_t i=0; i!=m_offsets.size(); i++)
+		w.put( m_offsets[i]);
+
+	w.beginSection( TagEntries);
+	for (size_t i=0; i!=m_entries.size(); i++) {
+		unsigned score[2];
+		memcpy( score, &m_entries[i].score, sizeof(score));
+		w.put( m_entries[i].synset);
+		w.put( score[0]);
+		w.put( score[1]);
+	}
+
+	w.write( filename);
+}
+
+
+void NeighborTable::load( const std::string& filename)
+{
+	clear();
+	try {
+		SnapshotReader rdr( filename);
+
+		SnapshotCursor hc( rdr, TagHeader);
+		m_pos = hc.getString();
+		m_relation = hc.getString();
+		m_k = hc.get();
+		m_addtop = hc.get() != 0;
+		unsigned ns = hc.get();
+
+		SnapshotCursor ic( rdr, TagIDs);
+		m_ids.reserve( ns);
+		for (unsigned i=0; i!=ns; i++)
+			m_ids.push_back( ic.getString());
+
+		SnapshotCursor oc( rdr, TagOffsets);
+		m_offsets.reserve( ns + 1);
+		for (unsigned i=0; i!=ns+1; i++) {
+			m_offsets.push_back( oc.get());
+			if (i != 0 && m_offsets[i] < m_offsets[i-1]) {
+				ML_THROW_EXC( "Invalid neighbor offsets in " << filename, WNSnapshotException);
+			}
+		}
+
+		SnapshotCursor ec( rdr, TagEntries);
+		m_entries.resize( m_offsets.empty() ? 0 : m_offsets.back());
+		for (size_t i=0; i!=m_entries.size(); i++) {
+			m_entries[i].synset = ec.get();
+			if (m_entries[i].synset >= ns) {
+				ML_THROW_EXC( "Invalid neighbor in " << filename, WNSnapshotException);
+			}
+			unsigned score[2];
+			score[0] = ec.get();
+			score[1] = ec.get();
+			memcpy( &m_entries[i].score, score, sizeof(score));
+		}
+	}
+	catch (...) {
+		clear();
+		throw;
+	}
+	index();
+}
+
+
+bool NeighborTable::lookup( const std::string& id, WNQuery::tNeighbors& results) const
+{
+	results.clear();
+	if (!isCurrent()) {
+		ML_THROW_EXC( "Neighbor table of " << m_pos << " " << m_relation << " is out of date: the WordNet changed since it was built", WNQueryException);
+	}
+	const unsigned* i = m_index.find( id);
+	if (i == NULL)
+		return false;
+	results.reserve( m_offsets[*i+1] - m_offsets[*i]);
+	for (unsigned j=m_offsets[*i]; j!=m_offsets[*i+1]; j++)
+		results.push_back( std::make_pair( m_ids[m_entries[j].synset], m_entries[j].score));
+	return true;
+}
+
+
+} // namespace LibWNXML {
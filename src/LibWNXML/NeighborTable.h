@@ -0,0 +1,98 @@
+#ifndef __NEIGHBORTABLE_H__
+#define __NEIGHBORTABLE_H__
+
+#include <string>
+#include <vector>
+#include "StringHashTable.h"
+#include "WNQuery.h"
+#include "WNSnapshot.h"
+
+namespace LibWNXML {
+
+/// Nearest neighbors (see WNQuery::nearestNeighbors()) of every synset of a POS, precomputed,
+/// so that looking them up is a hash lookup.
+/// Building the table for a whole POS takes a while, so it's meant to be built offline and saved
+/// to a file, then loaded by the applications. The file is in the binary snapshot format
+/// (see WNSnapshot.h), with its own sections.
+/// A table built from a WNQuery refers to it, which must outlive the table (or the table must be built again or
+/// loaded first): if the WordNet content changes (see WNQuery::generation()), the table is out of date, and lookups
+/// are refused until it's built again. A loaded table is not checked, it must match the WordNet it's used with.
+class NeighborTable
+{
+public:
+
+	NeighborTable();
+
+	/// Compute the k nearest neighbors of every synset of POS (replaces the current content).
+	/// @param wn WordNet to compute from
+	/// @param pos, relation, k, addArtificialTop see WNQuery::nearestNeighbors()
+	/// @param pool threads to compute with, NULL to compute in the calling thread only
+	/// @exception InvalidPOSException for invalid POS
+	void	build(	const WNQuery& wn,
+					const std::string& pos,
+					const std::string& relation,
+					size_t k,
+					const bool addArtificialTop,
+					ThreadPool* pool = NULL) throw(InvalidPOSException);
+
+	/// Write table to file.
+	/// @exception WNSnapshotException on I/O errors
+	void	save( const std::string& filename) const throw(WNSnapshotException);
+
+	/// Load table from a file written by save() (replaces the current content).
+	/// @exception WNSnapshotException if the file can't be read, or is not a valid neighbor table
+	void	load( const std::string& filename) throw(WNSnapshotException);
+
+	/// Parameters the table was built with
+	const std::string&	pos() const					{ return m_pos; }
+	const std::string&	relation() const			{ return m_relation; }
+	size_t				k() const					{ return m_k; }
+	bool				addArtificialTop() const	{ return m_addtop; }
+
+	/// Number of synsets in the table
+	size_t				size() const				{ return m_ids.size(); }
+
+	/// False if the table was built from a WNQuery whose content changed since then (see WNQuery::generation())
+	bool	isCurrent() const
+		{ return m_wn == NULL || m_wn->generation() == m_generation; }
+
+	/// Get the neighbors of a synset, the same as WNQuery::nearestNeighbors() gives with the parameters of the table.
+	/// @return false if the synset is not in the table (results are empty then)
+	/// @exception WNQueryException if the table is out of date (see isCurrent())
+	bool	lookup( const std::string& id, WNQuery::tNeighbors& results) const throw(WNQueryException);
+
+private:
+	NeighborTable( const NeighborTable&);				// not copyable (m_index points into m_ids)
+	NeighborTable& operator=( const NeighborTable&);
+
+	struct Entry
+	{
+		unsigned	synset;		///< index into m_ids
+		double		score;
+	};
+
+	/// Computes the neighbors of each synset (see build())
+	struct BuildJob;
+
+	/// Clear content
+	void	clear();
+
+	/// Build m_index from m_ids
+	void	index();
+
+	const WNQuery*				m_wn;			///< WordNet the table was built from, NULL if loaded or empty
+	unsigned long				m_generation;	///< WNQuery::generation() of m_wn when the table was built
+	std::string					m_pos;
+	std::string					m_relation;
+	size_t						m_k;
+	bool						m_addtop;
+	std::vector<std::string>	m_ids;		///< synset ids, in id order
+	StringHashTable<unsigned>	m_index;	///< id -> index into m_ids
+	std::vector<unsigned>		m_offsets;	///< neighbors of m_ids[i] are m_entries[m_offsets[i]..m_offsets[i+1])
+	std::vector<Entry>			m_entries;
+};
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __NEIGHBORTABLE_H__
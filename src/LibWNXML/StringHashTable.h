@@ -0,0 +1,185 @@
+#ifndef __STRINGHASHTABLE_H__
+#define __STRINGHASHTABLE_H__
+
+#include <string.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define LIBWNXML_STRING_VIEW
+#include <string_view>
+#endif
+
+namespace LibWNXML {
+
+/// Open-addressing (linear probing) hash table from strings to values.
+/// The keys are not copied, only referenced: they must stay valid (and unmodified)
+/// as long as the table is used, e.g. the keys of a std::map that is not changed.
+/// Lookups take a (pointer, length) pair, so no std::string has to be built for them.
+template <class V>
+class StringHashTable
+{
+public:
+
+	StringHashTable()
+		: m_size( 0)
+	{}
+
+	/// Hash function (FNV-1a)
+	static unsigned hash( const char* key, size_t len)
+	{
+		unsigned h = 2166136261u;
+		for (size_t i=0; i!=len; i++) {
+			h ^= (unsigned char) key[i];
+			h *= 16777619u;
+		}
+		return h;
+	}
+
+	/// Remove all entries
+	void	clear()
+	{
+		m_slots.clear();
+		m_size = 0;
+	}
+
+	/// Make room for n entries (the table is kept at most half full)
+	void	reserve( size_t n)
+	{
+		size_t cap = 16;
+		while (cap < 2 * n)
+			cap *= 2;
+		if (cap > m_slots.size())
+			rehash( cap);
+	}
+
+	/// Number of entries
+	size_t	size() const	{ return m_size; }
+
+	/// Memory used by the table (not including the keys)
+	size_t	memory() const	{ return m_slots.capacity() * sizeof( Slot); }
+
+	/// Insert key with value if not present yet.
+	/// @return pointer to the value stored for key, and whether it was inserted
+	std::pair<V*, bool>	insert( const char* key, size_t len, const V& value)
+	{
+		if (2 * (m_size + 1) > m_slots.size())
+			rehash( m_slots.empty() ? 16 : 2 * m_slots.size());
+		unsigned h = hash( key, len);
+		size_t mask = m_slots.size() - 1;
+		for (size_t i = h & mask; ; i = (i + 1) & mask) {
+			Slot& s = m_slots[i];
+			if (s.key == NULL) {
+				s.key = key;
+				s.len = unsigned( len);
+				s.hash = h;
+				s.value = value;
+				m_size++;
+				return std::make_pair( &s.value, true);
+			}
+			if (s.hash == h && s.len == len && memcmp( s.key, key, len) == 0)
+				return std::make_pair( &s.value, false);
+		}
+	}
+
+	/// Get value stored for key, NULL if not found
+	const V*	find( const char* key, size_t len) const
+	{
+		size_t i = slot( key, len);
+		return i == NoSlot ? NULL : &m_slots[i].value;
+	}
+
+	/// Make the entry of key refer to newkey, another copy of the same string (e.g. before the old copy is freed)
+	/// @return false if key is not in the table
+	bool	rekey( const char* key, size_t len, const char* newkey)
+	{
+		size_t i = slot( key, len);
+		if (i == NoSlot)
+			return false;
+		m_slots[i].key = newkey;
+		return true;
+	}
+
+	/// Remove key (the entries after it in its run are moved back, so no deleted slots are left)
+	/// @return false if key is not in the table
+	bool	erase( const char* key, size_t len)
+	{
+		size_t i = slot( key, len);
+		if (i == NoSlot)
+			return false;
+		size_t mask = m_slots.size() - 1;
+		for (size_t j = (i + 1) & mask; m_slots[j].key != NULL; j = (j + 1) & mask) {
+			// move the entry at j to the hole at i, unless its home slot is cyclically in (i, j]
+			size_t h = m_slots[j].hash & mask;
+			if (i <= j ? (h <= i || h > j) : (h <= i && h > j)) {
+				m_slots[i] = m_slots[j];
+				i = j;
+			}
+		}
+		m_slots[i] = Slot();
+		m_size--;
+		return true;
+	}
+
+	const V*	find( const std::string& key) const	{ return find( key.data(), key.size()); }
+	const V*	find( const char* key) const		{ return find( key, strlen( key)); }
+#ifdef LIBWNXML_STRING_VIEW
+	const V*	find( std::string_view key) const	{ return find( key.data(), key.size()); }
+#endif
+
+private:
+
+	struct Slot
+	{
+		const char*	key;	///< NULL for empty slots
+		unsigned	len;
+		unsigned	hash;
+		V			value;
+
+		Slot()
+			: key( NULL), len( 0), hash( 0), value()
+		{}
+	};
+
+	static const size_t	NoSlot = ~size_t( 0);
+
+	/// Slot of key, NoSlot if not found
+	size_t	slot( const char* key, size_t len) const
+	{
+		if (m_size == 0)
+			return NoSlot;
+		unsigned h = hash( key, len);
+		size_t mask = m_slots.size() - 1;
+		for (size_t i = h & mask; ; i = (i + 1) & mask) {
+			const Slot& s = m_slots[i];
+			if (s.key == NULL)
+				return NoSlot;
+			if (s.hash == h && s.len == len && memcmp( s.key, key, len) == 0)
+				return i;
+		}
+	}
+
+	void	rehash( size_t cap)
+	{
+		std::vector<Slot> old( cap);
+		old.swap( m_slots);
+		size_t mask = cap - 1;
+		for (size_t j=0; j!=old.size(); j++) {
+			if (old[j].key == NULL)
+				continue;
+			size_t i = old[j].hash & mask;
+			while (m_slots[i].key != NULL)
+				i = (i + 1) & mask;
+			m_slots[i] = old[j];
+		}
+	}
+
+	std::vector<Slot>	m_slots;	///< size is a power of 2
+	size_t				m_size;
+};
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __STRINGHASHTABLE_H__
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include "TargetSet.h"
+
+namespace LibWNXML {
+
+
+TargetSet::TargetSet(	const WNQuery& wn,
+						const std::string& pos,
+						const std::string& relation,
+						const std::set<std::string>& targetIDs)
+	: m_wn( wn)
+	, m_pos( pos)
+	, m_relation( relation)
+	, m_targetids( targetIDs)
+{
+	wn.graph( pos); // check POS
+	compile();
+}
+
+
+TargetSet::tCompiledPtr TargetSet::compile() const
+{
+	std::lock_guard<std::mutex> lock( m_mutex);
+	unsigned long gen = m_wn.generation();
+	tCompiledPtr last = std::atomic_load( &m_compiled);
+	if (last && last->generation == gen) // compiled by another thread meanwhile
+		return last;
+
+	std::shared_ptr<Compiled> c( new Compiled());
+	c->generation = gen;
+	const WNGraph& g = m_wn.graph( m_pos);
+	unsigned rel = g.relation( m_relation);
+	c->bits.assign( (g.size() + 31) / 32 + 1, 0);
+	c->single = WNGraph::npos;
+
+	// search backwards from the targets, breadth-first
+	std::vector<WNGraph::tnode> queue;
+	size_t ntargets = 0;
+	for (std::set<std::string>::const_iterator it=m_targetids.begin(); it!=m_targetids.end(); it++) {
+		WNGraph::tnode t = g.find( *it);
+		if (t == WNGraph::npos) {
+			c->missing.push_back( *it); // (sorted, as the set is)
+			continue;
+		}
+		ntargets++;
+		c->single = t;
+		if (!c->marked( t)) {
+			c->bits[t >> 5] |= 1u << (t & 31);
+			queue.push_back( t);
+		}
+	}
+	if (ntargets != 1)
+		c->single = WNGraph::npos;
+	for (size_t i=0; i!=queue.size(); i++) {
+		WNGraph::Targets s = g.sources( rel, queue[i]);
+		for (const WNGraph::tnode* p=s.first; p!=s.last; p++)
+			if (!c->marked( *p)) {
+				c->bits[*p >> 5] |= 1u << (*p & 31);
+				queue.push_back( *p);
+			}
+	}
+
+	tCompiledPtr result( c);
+	std::atomic_store( &m_compiled, result);
+	return result;
+}
+
+
+bool TargetSet::connected( const Compiled& c, const std::string& id) const
+{
+	WNGraph::tnode n = m_wn.graph( m_pos).find( id);
+	if (n == WNGraph::npos)
+		return std::binary_search( c.missing.begin(), c.missing.end(), id);
+	return c.marked( n);
+}
+
+
+bool TargetSet::isIDConnected( const std::string& id) const
+{
+	return connected( *compiled(), id);
+}
+
+
+bool TargetSet::isIDConnected( const std::string& id, std::string& foundTargetID) const
+{
+	foundTargetID = "";
+	tCompiledPtr c = compiled();
+	if (!connected( *c, id))
+		return false;
+	// which target: the synset itself, the only one, or the one the search finds first
+	if (m_targetids.count( id) != 0)
+		foundTargetID = id;
+	else if (c->single != WNGraph::npos)
+		foundTargetID = m_wn.graph( m_pos).id( c->single);
+	else
+		m_wn.id_connected_with( id, m_pos, m_relation, m_targetids, foundTargetID, -1);
+	return true;
+}
+
+
+bool TargetSet::isLiteralConnected( const std::string& literal, std::string& foundID, std::string& foundTargetID) const
+{
+	foundID = "";
+	foundTargetID = "";
+	tCompiledPtr c = compiled();
+	const WNGraph& g = m_wn.graph( m_pos);
+	WNGraph::Targets senses = g.senses( literal);
+	for (const WNGraph::tnode* p=senses.first; p!=senses.last; p++)
+		if (c->marked( *p)) {
+			foundID = g.id( *p);
+			isIDConnected( foundID, foundTargetID);
+			return true;
+		}
+	return false;
+}
+
+
+} // namespace LibWNXML {
@@ -0,0 +1,91 @@
+#ifndef __TARGETSET_H__
+#define __TARGETSET_H__
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "WNQuery.h"
+
+namespace LibWNXML {
+
+/// A set of target synsets compiled for checking again and again which synsets are connected with
+/// them by a relation (see WNQuery::isIDConnectedWith()), e.g. the synsets of a semantic feature class.
+///
+/// Compiling searches backwards from the targets (against the relation) once, and marks every synset
+/// that can reach any of them in a bitset over the graph nodes, so a check is a hash lookup and a bit test.
+/// If the WordNet content changes (see WNQuery::generation()), the set is compiled again at the next check.
+/// The set refers to the WNQuery, which must outlive it. Checks can be run from several threads: each one takes
+/// the current compilation through an atomic shared_ptr, a new one is published by swapping it.
+class TargetSet
+{
+public:
+
+	/// Compile target set.
+	/// @param wn WordNet to check in
+	/// @param pos, relation, targetIDs see WNQuery::isIDConnectedWith()
+	/// @exception InvalidPOSException for invalid POS
+	TargetSet(	const WNQuery& wn,
+				const std::string& pos,
+				const std::string& relation,
+				const std::set<std::string>& targetIDs) throw(InvalidPOSException);
+
+	const std::string&				pos() const			{ return m_pos; }
+	const std::string&				relation() const	{ return m_relation; }
+	const std::set<std::string>&	targetIDs() const	{ return m_targetids; }
+
+	/// Check if synset is connected with any of the targets (same as WNQuery::isIDConnectedWith() without maxDepth).
+	bool	isIDConnected( const std::string& id) const;
+
+	/// Check if synset is connected with any of the targets, also return the target found first
+	/// (same as WNQuery::isIDConnectedWith() without maxDepth).
+	bool	isIDConnected( const std::string& id, std::string& foundTargetID) const;
+
+	/// Check if any sense of literal is connected with any of the targets (same as WNQuery::isLiteralConnectedWith()).
+	bool	isLiteralConnected( const std::string& literal, std::string& foundID, std::string& foundTargetID) const;
+
+private:
+	TargetSet( const TargetSet&);				// not copyable
+	TargetSet& operator=( const TargetSet&);
+
+	/// Result of a compilation (not changed after it's published)
+	struct Compiled
+	{
+		unsigned long				generation;	///< WNQuery::generation() of the compilation
+		std::vector<unsigned>		bits;		///< nodes that can reach a target
+		std::vector<std::string>	missing;	///< target ids not in the graph, sorted (reached only from themselves)
+		WNGraph::tnode				single;		///< the only target in the graph, npos if there are none or several
+
+		/// Check if node is marked
+		bool	marked( WNGraph::tnode n) const	{ return (bits[n >> 5] & (1u << (n & 31))) != 0; }
+	};
+	typedef std::shared_ptr<const Compiled>	tCompiledPtr;
+
+	/// Get the current compilation, compile again if the WordNet content changed since the last one
+	tCompiledPtr	compiled() const
+	{
+		tCompiledPtr c = std::atomic_load( &m_compiled);
+		if (c->generation != m_wn.generation())
+			c = compile();
+		return c;
+	}
+
+	/// Mark the nodes that can reach the targets, publish and return the result
+	tCompiledPtr	compile() const;
+
+	/// Check if synset is connected with any of the targets in the given compilation
+	bool	connected( const Compiled& c, const std::string& id) const;
+
+	const WNQuery&						m_wn;
+	std::string							m_pos;
+	std::string							m_relation;
+	std::set<std::string>				m_targetids;
+	mutable tCompiledPtr				m_compiled;		///< the last compilation (read and replaced with std::atomic_load/atomic_store)
+	mutable std::mutex					m_mutex;		///< guards compile()
+};
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __TARGETSET_H__
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include "ThreadPool.h"
+
+namespace LibWNXML {
+
+
+namespace {
+
+/// Pools the current thread is working on a run of (innermost last)
+thread_local std::vector<const ThreadPool*> t_running;
+
+/// Marks the current thread as working on a run of a pool, while it exists
+class RunningMark
+{
+public:
+	explicit RunningMark( const ThreadPool* pool)	{ t_running.push_back( pool); }
+	~RunningMark()									{ t_running.pop_back(); }
+};
+
+} // namespace {
+
+
+ThreadPool::ThreadPool( unsigned nthreads)
+	: m_job( NULL)
+	, m_count( 0)
+	, m_next( 0)
+	, m_active( 0)
+	, m_generation( 0)
+	, m_stop( false)
+{
+	if (nthreads == 0)
+		nthreads = std::thread::hardware_concurrency();
+	for (unsigned i=1; i<nthreads; i++)
+		m_threads.push_back( std::thread( &ThreadPool::worker, this));
+}
+
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> runlock( m_runmutex);
+		std::lock_guard<std::mutex> lock( m_mutex);
+		m_stop = true;
+	}
+	m_startcond.notify_all();
+	for (size_t i=0; i!=m_threads.size(); i++)
+		m_threads[i].join();
+}
+
+
+void ThreadPool::run( Job& job, size_t n)
+{
+	// called from a job of this pool: run it here (m_runmutex is held by the outer run)
+	if (std::find( t_running.begin(), t_running.end(), this) != t_running.end()) {
+		for (size_t i=0; i!=n; i++)
+			job.run( i);
+		return;
+	}
+
+	std::lock_guard<std::mutex> runlock( m_runmutex);
+	RunningMark mark( this);
+	{
+		std::lock_guard<std::mutex> lock( m_mutex);
+		m_job = &job;
+		m_count = n;
+		m_next = 0;
+		m_error = std::exception_ptr();
+		m_active = unsigned( m_threads.size());
+		m_generation++;
+	}
+	m_startcond.notify_all();
+
+	// work too, then wait for the workers
+	work();
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock( m_mutex);
+		while (m_active != 0)
+			m_donecond.wait( lock);
+		m_job = NULL;
+		error = m_error;
+	}
+	if (error)
+		std::rethrow_exception( error);
+}
+
+
+void ThreadPool::worker()
+{
+	unsigned long done = 0; // last run worked on
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock( m_mutex);
+			while (!m_stop && m_generation == done)
+				m_startcond.wait( lock);
+			if (m_stop)
+				return;
+			done = m_generation;
+		}
+		{
+			RunningMark mark( this);
+			work();
+		}
+		{
+			std::lock_guard<std::mutex> lock( m_mutex);
+			m_active--;
+		}
+		m_donecond.notify_one();
+	}
+}
+
+
+void ThreadPool::work()
+{
+	for (size_t i = m_next++; i < m_count; i = m_next++) {
+		try {
+			m_job->run( i);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock( m_mutex);
+			if (!m_error)
+				m_error = std::current_exception();
+			m_next = m_count; // skip the rest
+		}
+	}
+}
+
+
+} // namespace LibWNXML {
@@ -0,0 +1,71 @@
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LibWNXML {
+
+/// Fixed set of worker threads for running data-parallel jobs.
+/// The threads are started once and wait for jobs between runs, so the pool
+/// can be kept and reused for many (small) runs.
+class ThreadPool
+{
+public:
+
+	/// A job: run( i) is called once for every index i of a run, from several threads at the same time.
+	class Job
+	{
+	public:
+		virtual ~Job() {}
+		virtual void run( size_t i) = 0;
+	};
+
+	/// Start threads.
+	/// @param nthreads number of threads working on a run, including the thread calling run()
+	/// (so nthreads-1 worker threads are started). 0 means the number of hardware threads.
+	explicit ThreadPool( unsigned nthreads = 0);
+
+	/// Stop threads (waits for a run in progress to finish).
+	~ThreadPool();
+
+	/// Number of threads working on a run
+	unsigned	size() const	{ return unsigned( m_threads.size()) + 1; }
+
+	/// Call job.run( i) for i = 0..n-1, distributed among the threads, return when all are done.
+	/// Calls from several threads are run one after the other.
+	/// If job.run() throws, the remaining indices are skipped, and the first exception is rethrown here.
+	/// A call from a job of this pool (in any of its threads) runs the job in the calling thread only, since the
+	/// other threads are busy with the outer run, and waiting for it would never end. Calls that wait for each other
+	/// through several pools (a job of pool A running pool B, whose job runs pool A) are not detected, and deadlock.
+	void		run( Job& job, size_t n);
+
+private:
+	ThreadPool( const ThreadPool&);				// not copyable
+	ThreadPool& operator=( const ThreadPool&);
+
+	void		worker();
+	void		work();
+
+	std::vector<std::thread>	m_threads;
+	std::mutex					m_runmutex;		///< serializes run() calls
+	std::mutex					m_mutex;		///< guards the members below
+	std::condition_variable		m_startcond;	///< signals workers: new run, or stop
+	std::condition_variable		m_donecond;		///< signals run(): a worker finished
+	Job*						m_job;
+	size_t						m_count;
+	std::atomic<size_t>			m_next;			///< next index to run
+	unsigned					m_active;		///< workers still working on the current run
+	unsigned long				m_generation;	///< number of runs started
+	bool						m_stop;
+	std::exception_ptr			m_error;
+};
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __THREADPOOL_H__
@@ -0,0 +1,624 @@
+#include <algorithm>
+#include <iterator>
+#include "IntervalIndex.h"
+#include "LCAIndex.h"
+#include "WNGraph.h"
+
+namespace LibWNXML {
+
+
+namespace {
+
+/// Order of senses by literal
+struct SenseLess
+{
+	bool operator()( const WNGraph::Sense* s1, const WNGraph::Sense* s2) const	{ return *s1->literal < *s2->literal; }
+};
+
+/// Order of nodes by rank (see WNGraph::m_ranks)
+struct RankLess
+{
+	const std::vector<unsigned>&	ranks;
+
+	RankLess( const std::vector<unsigned>& r)
+		: ranks( r)
+	{}
+
+	bool operator()( unsigned rank, WNGraph::tnode n) const	{ return rank < ranks[n]; }
+};
+
+/// Literal of the literal numbers that have no senses
+const std::string	NoLiteral;
+
+/// Replace the index slots with n empty ones
+template <class T>
+void reset_slots( std::vector< std::atomic<T*> >& slots, size_t n)
+{
+	std::vector< std::atomic<T*> >( n).swap( slots);
+	for (size_t i=0; i!=slots.size(); i++)
+		slots[i].store( NULL);
+}
+
+} // namespace {
+
+
+const unsigned WNGraph::npos;
+
+
+WNGraph::~WNGraph()
+{
+	clearIndices();
+}
+
+
+void WNGraph::clearIndices()
+{
+	std::lock_guard<std::mutex> lock( m_mutex);
+	for (size_t i=0; i!=m_lca.size(); i++)
+		delete m_lca[i].exchange( NULL);
+	for (size_t i=0; i!=m_intervals.size(); i++)
+		delete m_intervals[i].exchange( NULL);
+}
+
+
+void WNGraph::clearIndices( unsigned rel)
+{
+	std::lock_guard<std::mutex> lock( m_mutex);
+	delete m_lca[rel].exchange( NULL);
+	delete m_intervals[rel].exchange( NULL);
+}
+
+
+const LCAIndex& WNGraph::lcaIndex( unsigned rel) const
+{
+	// double-checked: only the thread that builds the index takes the lock
+	size_t i = rel < m_adj.size() ? rel : m_adj.size();
+	LCAIndex* lca = m_lca[i].load( std::memory_order_acquire);
+	if (lca == NULL) {
+		std::lock_guard<std::mutex> lock( m_mutex);
+		lca = m_lca[i].load( std::memory_order_relaxed);
+		if (lca == NULL) {
+			lca = new LCAIndex( *this, rel < m_adj.size() ? rel : npos);
+			m_lca[i].store( lca, std::memory_order_release);
+		}
+	}
+	return *lca;
+}
+
+
+const IntervalIndex& WNGraph::intervalIndex( unsigned rel) const
+{
+	// double-checked, as lcaIndex()
+	size_t i = rel < m_adj.size() ? rel : m_adj.size();
+	IntervalIndex* intervals = m_intervals[i].load( std::memory_order_acquire);
+	if (intervals == NULL) {
+		std::lock_guard<std::mutex> lock( m_mutex);
+		intervals = m_intervals[i].load( std::memory_order_relaxed);
+		if (intervals == NULL) {
+			intervals = new IntervalIndex( *this, rel < m_adj.size() ? rel : npos);
+			m_intervals[i].store( intervals, std::memory_order_release);
+		}
+	}
+	return *intervals;
+}
+
+
+void WNGraph::build( const std::map<std::string, Synset>& dat, const std::vector<Sense>& senses)
+{
+	clearIndices();
+	m_syns.clear();
+	m_ids.clear();
+	m_phantoms.clear();
+	m_nodes.clear();
+	m_ranks.clear();
+	m_detached.clear();
+	m_literals.clear();
+	m_litnames.clear();
+	m_litsenses = Rows();
+	m_relids.clear();
+	m_relnames.clear();
+	m_adj.clear();
+	m_radj.clear();
+
+	// number synsets in id order
+	m_nsyns = dat.size();
+	m_syns.reserve( m_nsyns);
+	m_ids.reserve( m_nsyns);
+	m_nodes.reserve( m_nsyns);
+	for (std::map<std::string, Synset>::const_iterator it=dat.begin(); it!=dat.end(); it++) {
+		m_nodes.insert( it->first.data(), it->first.size(), tnode( m_syns.size()));
+		m_syns.push_back( &it->second);
+		m_ids.push_back( &it->first);
+	}
+
+	// number relation types and missing targets, count edges per (relation, node)
+	std::vector< std::vector<unsigned> > offsets; // per relation type: the targets of synset node n start at offsets[n]
+	for (size_t n=0; n!=m_nsyns; n++) {
+		const Synset::tPtrVect& ilrs = m_syns[n]->ilrs;
+		for (size_t i=0; i!=ilrs.size(); i++) {
+			std::pair<std::map<std::string, unsigned>::iterator, bool> rt = m_relids.insert( std::make_pair( ilrs[i].second, unsigned( m_relnames.size())));
+			if (rt.second) {
+				m_relnames.push_back( ilrs[i].second);
+				offsets.push_back( std::vector<unsigned>( m_nsyns + 1, 0));
+			}
+			offsets[rt.first->second][n+1]++;
+			if (find( ilrs[i].first) == npos) { // phantom
+				m_phantoms.push_back( ilrs[i].first);
+				m_nodes.insert( m_phantoms.back().data(), m_phantoms.back().size(), tnode( m_ids.size()));
+				m_ids.push_back( &m_phantoms.back());
+			}
+		}
+	}
+	const size_t nn = m_ids.size();
+	m_syns.resize( nn, NULL);
+
+	// (empty) slots of the derived indices
+	reset_slots( m_lca, m_relnames.size() + 1);
+	reset_slots( m_intervals, m_relnames.size() + 1);
+
+	// rows: prefix sums of counts (phantoms have empty rows at the end)
+	m_adj.resize( m_relnames.size());
+	for (size_t r=0; r!=m_adj.size(); r++) {
+		std::vector<unsigned>& o = offsets[r];
+		for (size_t n=0; n!=m_nsyns; n++)
+			o[n+1] += o[n];
+		Rows& a = m_adj[r];
+		a.items.resize( o[m_nsyns]);
+		a.bounds.resize( nn, std::make_pair( o[m_nsyns], o[m_nsyns]));
+		for (size_t n=0; n!=m_nsyns; n++)
+			a.bounds[n] = std::make_pair( o[n], o[n]);
+	}
+
+	// fill in targets in ilrs order (the end of a row is its fill position until it's full)
+	for (size_t n=0; n!=m_nsyns; n++) {
+		const Synset::tPtrVect& ilrs = m_syns[n]->ilrs;
+		for (size_t i=0; i!=ilrs.size(); i++) {
+			Rows& a = m_adj[m_relids.find( ilrs[i].second)->second];
+			a.items[a.bounds[n].second++] = find( ilrs[i].first);
+		}
+	}
+
+	// reverse adjacency: count sources per target, prefix sums, then fill in node order
+	m_radj.resize( m_adj.size());
+	for (size_t r=0; r!=m_adj.size(); r++) {
+		const Rows& a = m_adj[r];
+		Rows& ra = m_radj[r];
+		std::vector<unsigned> o( nn + 1, 0);
+		for (size_t i=0; i!=a.items.size(); i++)
+			o[a.items[i] + 1]++;
+		for (size_t n=0; n!=nn; n++)
+			o[n+1] += o[n];
+		ra.items.resize( a.items.size());
+		ra.bounds.resize( nn);
+		for (size_t n=0; n!=nn; n++)
+			ra.bounds[n] = std::make_pair( o[n], o[n]);
+		for (size_t n=0; n!=m_nsyns; n++)
+			for (unsigned i=a.bounds[n].first; i!=a.bounds[n].second; i++)
+				ra.items[ra.bounds[a.items[i]].second++] = tnode( n);
+	}
+
+	// ranks: the synsets in the order of their first senses
+	m_ranks.assign( nn, npos);
+	for (size_t i=0; i!=senses.size(); i++) {
+		tnode n = find( *senses[i].id);
+		if (synset( n) != NULL && m_ranks[n] == npos)
+			m_ranks[n] = unsigned( i);
+	}
+	m_nextrank = unsigned( senses.size());
+
+	// literal index: the senses sorted by literal (stably, so the senses of a literal keep their order),
+	// each literal's senses stored contiguously
+	std::vector<const Sense*> sorted;
+	sorted.reserve( senses.size());
+	for (size_t i=0; i!=senses.size(); i++)
+		sorted.push_back( &senses[i]);
+	std::stable_sort( sorted.begin(), sorted.end(), SenseLess());
+	std::vector<tnode>& items = m_litsenses.items;
+	items.reserve( sorted.size());
+	for (size_t i=0; i!=sorted.size(); ) {
+		const std::string& lit = *sorted[i]->literal;
+		unsigned first = unsigned( items.size());
+		for (; i!=sorted.size() && *sorted[i]->literal == lit; i++) {
+			tnode n = find( *sorted[i]->id);
+			if (synset( n) != NULL)
+				items.push_back( n);
+		}
+		if (items.size() == first) // no synset
+			continue;
+		m_literals.insert( lit.data(), lit.size(), unsigned( m_litnames.size()));
+		m_litnames.push_back( &lit);
+		m_litsenses.bounds.push_back( std::make_pair( first, unsigned( items.size())));
+	}
+}
+
+
+void WNGraph::detach( const std::string& id, bool erase)
+{
+	tnode n = find( id);
+	if (synset( n) == NULL || m_detached.count( n) != 0)
+		return;
+	const Synset& syns = *m_syns[n];
+
+	// senses: one of each literal row, then the literal index must not point into the synset
+	std::vector<tnode> row;
+	for (size_t i=0; i!=syns.synonyms.size(); i++) {
+		const unsigned* l = m_literals.find( syns.synonyms[i].literal);
+		if (l == NULL)
+			continue;
+		Targets t = literalSenses( *l);
+		row.assign( t.first, t.last);
+		std::vector<tnode>::iterator p = std::find( row.begin(), row.end(), n);
+		if (p != row.end()) {
+			row.erase( p);
+			m_litsenses.set( *l, row);
+		}
+	}
+	for (size_t i=0; i!=syns.synonyms.size(); i++) {
+		const unsigned* l = m_literals.find( syns.synonyms[i].literal);
+		if (l != NULL)
+			rekey_literal( *l, syns);
+	}
+
+	if (!erase) {
+		m_detached.insert( n);
+		return;
+	}
+	// phantom: no targets, and the id copied
+	std::vector<tnode> none;
+	for (unsigned r=0; r!=m_adj.size(); r++)
+		set_targets( r, n, none);
+	m_phantoms.push_back( id);
+	m_nodes.rekey( id.data(), id.size(), m_phantoms.back().data());
+	m_ids[n] = &m_phantoms.back();
+	m_syns[n] = NULL;
+	m_ranks[n] = npos;
+	m_nsyns--;
+	clearIndices();
+}
+
+
+void WNGraph::update( const std::string& id, const Synset& syns)
+{
+	tnode n = find( id);
+	if (n == npos)
+		n = add_node( &id);
+	bool senses = m_detached.erase( n) != 0;
+	if (m_syns[n] == NULL) { // new synset (a phantom until now)
+		if (m_ids[n] != &id) {
+			m_nodes.rekey( id.data(), id.size(), id.data());
+			m_ids[n] = &id;
+		}
+		m_nsyns++;
+		clearIndices();
+		senses = true;
+	}
+	m_syns[n] = &syns;
+
+	// targets by relation type, in ilrs order
+	const Synset::tPtrVect& ilrs = syns.ilrs;
+	std::vector< std::vector<tnode> > targets( m_adj.size());
+	for (size_t i=0; i!=ilrs.size(); i++) {
+		unsigned r = add_relation( ilrs[i].second);
+		if (r >= targets.size())
+			targets.resize( r + 1);
+		tnode t = find( ilrs[i].first);
+		if (t == npos) { // phantom
+			m_phantoms.push_back( ilrs[i].first);
+			t = add_node( &m_phantoms.back());
+		}
+		targets[r].push_back( t);
+	}
+	targets.resize( m_adj.size());
+	for (unsigned r=0; r!=m_adj.size(); r++)
+		set_targets( r, n, targets[r]);
+
+	// senses: after the senses of the synsets ranked before it (one with no senses loses its place)
+	if (!senses)
+		return;
+	if (syns.synonyms.empty()) {
+		m_ranks[n] = npos;
+		return;
+	}
+	if (m_ranks[n] == npos)
+		m_ranks[n] = m_nextrank++;
+	std::vector<tnode> row;
+	for (size_t i=0; i!=syns.synonyms.size(); i++) {
+		const std::string& lit = syns.synonyms[i].literal;
+		std::pair<unsigned*, bool> l = m_literals.insert( lit.data(), lit.size(), unsigned( m_litnames.size()));
+		if (l.second) {
+			m_litnames.push_back( &lit);
+			m_litsenses.bounds.push_back( std::make_pair( 0u, 0u));
+		}
+		Targets t = literalSenses( *l.first);
+		row.assign( t.first, t.last);
+		row.insert( std::upper_bound( row.begin(), row.end(), m_ranks[n], RankLess( m_ranks)), n);
+		m_litsenses.set( *l.first, row);
+	}
+}
+
+
+WNGraph::tnode WNGraph::add_node( const std::string* id)
+{
+	tnode n = tnode( m_ids.size());
+	m_nodes.insert( id->data(), id->size(), n);
+	m_ids.push_back( id);
+	m_syns.push_back( NULL);
+	m_ranks.push_back( npos);
+	for (size_t r=0; r!=m_adj.size(); r++) {
+		m_adj[r].bounds.push_back( std::make_pair( 0u, 0u));
+		m_radj[r].bounds.push_back( std::make_pair( 0u, 0u));
+	}
+	clearIndices(); // (they are sized by the number of nodes)
+	return n;
+}
+
+
+unsigned WNGraph::add_relation( const std::string& name)
+{
+	std::pair<std::map<std::string, unsigned>::iterator, bool> rt = m_relids.insert( std::make_pair( name, unsigned( m_relnames.size())));
+	if (rt.second) {
+		m_relnames.push_back( name);
+		m_adj.push_back( Rows());
+		m_adj.back().bounds.assign( m_ids.size(), std::make_pair( 0u, 0u));
+		m_radj.push_back( m_adj.back());
+		// one slot more (the last one is for npos)
+		clearIndices();
+		reset_slots( m_lca, m_relnames.size() + 1);
+		reset_slots( m_intervals, m_relnames.size() + 1);
+	}
+	return rt.first->second;
+}
+
+
+void WNGraph::set_targets( unsigned rel, tnode n, const std::vector<tnode>& targets)
+{
+	Rows& a = m_adj[rel];
+	Targets old = a.row( n);
+	if (old.size() == targets.size() && std::equal( old.first, old.last, targets.begin()))
+		return;
+
+	// sources: n out of the rows of the targets it lost, into the rows of the new ones (in node order)
+	std::vector<tnode> before( old.first, old.last), after( targets), lost, gained;
+	std::sort( before.begin(), before.end());
+	std::sort( after.begin(), after.end());
+	std::set_difference( before.begin(), before.end(), after.begin(), after.end(), std::back_inserter( lost));
+	std::set_difference( after.begin(), after.end(), before.begin(), before.end(), std::back_inserter( gained));
+	Rows& ra = m_radj[rel];
+	std::vector<tnode> row;
+	for (size_t i=0; i!=lost.size(); i++) {
+		Targets t = ra.row( lost[i]);
+		row.assign( t.first, t.last);
+		row.erase( std::lower_bound( row.begin(), row.end(), n));
+		ra.set( lost[i], row);
+	}
+	for (size_t i=0; i!=gained.size(); i++) {
+		Targets t = ra.row( gained[i]);
+		row.assign( t.first, t.last);
+		row.insert( std::upper_bound( row.begin(), row.end(), n), n);
+		ra.set( gained[i], row);
+	}
+	a.set( n, targets);
+	clearIndices( rel);
+}
+
+
+void WNGraph::rekey_literal( unsigned l, const Synset& syns)
+{
+	const std::string* name = m_litnames[l];
+	size_t i = 0;
+	while (i != syns.synonyms.size() && &syns.synonyms[i].literal != name)
+		i++;
+	if (i == syns.synonyms.size()) // points elsewhere
+		return;
+	Targets t = literalSenses( l);
+	if (t.empty()) {
+		m_literals.erase( name->data(), name->size());
+		m_litnames[l] = &NoLiteral;
+		return;
+	}
+	// the literal in the synset of the first sense left
+	const Synset& other = *m_syns[*t.first];
+	for (i=0; i!=other.synonyms.size(); i++)
+		if (other.synonyms[i].literal == *name) {
+			m_literals.rekey( name->data(), name->size(), other.synonyms[i].literal.data());
+			m_litnames[l] = &other.synonyms[i].literal;
+			return;
+		}
+}
+
+
+void WNGraph::Rows::set( size_t i, const std::vector<tnode>& nodes)
+{
+	std::pair<unsigned, unsigned>& b = bounds[i];
+	unsigned len = b.second - b.first;
+	if (nodes.size() <= len) { // in place
+		std::copy( nodes.begin(), nodes.end(), items.begin() + b.first);
+		b.second = b.first + unsigned( nodes.size());
+		unused += len - nodes.size();
+	}
+	else { // at the end
+		b.first = unsigned( items.size());
+		items.insert( items.end(), nodes.begin(), nodes.end());
+		b.second = unsigned( items.size());
+		unused += len;
+	}
+
+	// without gaps again, once they take more than the rows
+	if (2 * unused > items.size()) {
+		std::vector<tnode> packed;
+		packed.reserve( items.size() - unused);
+		for (size_t r=0; r!=bounds.size(); r++) {
+			unsigned first = unsigned( packed.size());
+			packed.insert( packed.end(), items.begin() + bounds[r].first, items.begin() + bounds[r].second);
+			bounds[r] = std::make_pair( first, unsigned( packed.size()));
+		}
+		items.swap( packed);
+		unused = 0;
+	}
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// GraphWalker
+
+GraphWalker::GraphWalker( const WNGraph& g, unsigned rel, WNGraph::tnode start, eMode mode, int maxdepth)
+	: m_graph( g)
+	, m_rel( rel)
+	, m_start( start)
+	, m_mode( mode)
+	, m_maxdepth( maxdepth)
+	, m_scratch( NULL)
+	, m_ownscratch( false)
+	, m_repeated( false)
+{
+	// use the scratch space of the thread, unless another walk is using it
+	static thread_local Scratch threadscratch;
+	if (threadscratch.busy) {
+		m_scratch = new Scratch();
+		m_ownscratch = true;
+	}
+	else
+		m_scratch = &threadscratch;
+	m_scratch->busy = true;
+	size_t nwords = (g.size() + 31) / 32;
+	if (m_scratch->bits.size() < nwords)
+		m_scratch->bits.resize( nwords, 0);
+}
+
+
+GraphWalker::~GraphWalker()
+{
+	// clear marks: visited nodes, or the nodes on the current path
+	if (m_mode != VisitPaths) {
+		for (size_t i=0; i!=m_scratch->touched.size(); i++)
+			unmark( m_scratch->touched[i]);
+	}
+	else {
+		for (size_t i=0; i!=m_scratch->stack.size(); i++)
+			unmark( m_scratch->stack[i].node);
+	}
+	m_scratch->touched.clear();
+	m_scratch->stack.clear();
+	m_scratch->busy = false;
+	if (m_ownscratch)
+		delete m_scratch;
+}
+
+
+void GraphWalker::push( WNGraph::tnode n, int depth)
+{
+	bool leaf = m_maxdepth >= 0 && depth >= m_maxdepth;
+	if (m_mode != VisitTree || !leaf) { // (in VisitTree mode, nodes are marked when their targets are walked)
+		mark( n);
+		if (m_mode != VisitPaths)
+			m_scratch->touched.push_back( n);
+	}
+	Frame f;
+	f.node = n;
+	f.depth = depth;
+	if (leaf) // don't go deeper
+		f.cur = f.end = NULL;
+	else {
+		WNGraph::Targets t = m_graph.targets( m_rel, n);
+		f.cur = t.first;
+		f.end = t.last;
+	}
+	m_scratch->stack.push_back( f);
+}
+
+
+bool GraphWalker::next( WNGraph::tnode& n, int& depth)
+{
+	if (m_start != WNGraph::npos) {
+		push( m_start, 0);
+		n = m_start;
+		depth = 0;
+		m_start = WNGraph::npos;
+		return true;
+	}
+	std::vector<Frame>& stack = m_scratch->stack;
+	while (!stack.empty()) {
+		Frame& f = stack.back();
+		if (f.cur == f.end) { // all targets done
+			if (m_mode == VisitPaths)
+				unmark( f.node);
+			stack.pop_back();
+			continue;
+		}
+		WNGraph::tnode t = *f.cur++;
+		m_repeated = marked( t); // visited already, or would close a cycle
+		if (m_repeated && m_mode != VisitTree)
+			continue;
+		depth = f.depth + 1;
+		n = t;
+		if (!m_repeated)
+			push( t, depth);
+		return true;
+	}
+	return false;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// GraphBFS
+
+GraphBFS::GraphBFS( const WNGraph& g, unsigned rel, WNGraph::tnode start, int maxdepth)
+	: m_graph( g)
+	, m_rel( rel)
+	, m_maxdepth( maxdepth)
+	, m_depth( 0)
+	, m_levelbegin( 0)
+	, m_scratch( NULL)
+{
+	// get a free scratch space of the thread (deque: elements don't move when adding new ones)
+	static thread_local std::deque<Scratch> pool;
+	for (size_t i=0; i!=pool.size() && m_scratch == NULL; i++)
+		if (!pool[i].busy)
+			m_scratch = &pool[i];
+	if (m_scratch == NULL) {
+		pool.push_back( Scratch());
+		m_scratch = &pool.back();
+	}
+	m_scratch->busy = true;
+	if (m_scratch->dist.size() < g.size())
+		m_scratch->dist.resize( g.size(), -1);
+
+	if (g.synset( start) != NULL) {
+		m_scratch->dist[start] = 0;
+		m_scratch->order.push_back( start);
+	}
+}
+
+
+GraphBFS::~GraphBFS()
+{
+	for (size_t i=0; i!=m_scratch->order.size(); i++)
+		m_scratch->dist[m_scratch->order[i]] = -1;
+	m_scratch->order.clear();
+	m_scratch->busy = false;
+}
+
+
+bool GraphBFS::nextLevel()
+{
+	std::vector<WNGraph::tnode>& order = m_scratch->order;
+	size_t end = order.size();
+	if (m_maxdepth >= 0 && m_depth >= m_maxdepth) {
+		m_levelbegin = end;
+		return false;
+	}
+	m_depth++;
+	for (size_t i=m_levelbegin; i!=end; i++) {
+		WNGraph::Targets t = m_graph.targets( m_rel, order[i]);
+		for (const WNGraph::tnode* p=t.first; p!=t.last; p++)
+			if (m_scratch->dist[*p] < 0 && m_graph.synset( *p) != NULL) {
+				m_scratch->dist[*p] = m_depth;
+				order.push_back( *p);
+			}
+	}
+	m_levelbegin = end;
+	return order.size() != end;
+}
+
+
+} // namespace LibWNXML {
@@ -0,0 +1,376 @@
+#ifndef __WNGRAPH_H__
+#define __WNGRAPH_H__
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "StringHashTable.h"
+#include "Synset.h"
+
+namespace LibWNXML {
+
+class IntervalIndex;
+class LCAIndex;
+
+/// Relation graph of the synsets of one POS, with dense integer node numbers
+/// and one compressed sparse row (CSR) adjacency structure per relation type.
+///
+/// build() numbers the synsets 0..synsetCount()-1 in id order. Relation targets that
+/// are not synsets of the POS get "phantom" nodes after these, with no synset
+/// and no outgoing edges, so that every relation pointer has a target node.
+/// The targets of a node by a relation are in the order of the synset's ilrs.
+/// The reverse edges are stored too (sources()), for searching against the relations.
+///
+/// The graph also holds hash indices from synset ids to nodes, and from literals
+/// to the synset nodes of their senses. build() numbers the literals in byte order.
+///
+/// A patch (see WNQuery::applyPatch()) changes the graph in place with detach() and update(), only at the synsets
+/// it touches: a removed synset's node becomes a phantom, a new synset gets the phantom node of its id or a new node
+/// at the end, and new literals are numbered after the others. So node numbers are not in id order any more then:
+/// a node is a synset node if synset() is not NULL.
+///
+/// Indices derived from the graph for a relation type (lcaIndex(), intervalIndex()) are built
+/// at first use, this is thread-safe. They are published through atomic pointers, so once
+/// built they are got without locking.
+///
+/// The graph points into the synset map and the senses it was built from (the hash indices
+/// don't copy their keys), so it must be rebuilt if those change, or told about the changes (detach(), update()).
+class WNGraph
+{
+public:
+
+	/// Node number
+	typedef unsigned tnode;
+
+	/// Invalid node / relation number
+	static const unsigned npos = ~0u;
+
+	/// Range of target nodes
+	struct Targets
+	{
+		const tnode*	first;
+		const tnode*	last;
+
+		bool	empty() const	{ return first == last; }
+		size_t	size() const	{ return last - first; }
+	};
+
+	/// Word sense: a literal of a synset, pointing into a synset map (see WNQuery::tdat)
+	struct Sense
+	{
+		const std::string*	literal;	///< literal of one of the synonyms of the synset
+		const std::string*	id;			///< id of the synset (the key of the map)
+	};
+
+	WNGraph()
+		: m_nsyns( 0)
+		, m_nextrank( 0)
+		, m_lca( 1)
+		, m_intervals( 1)
+	{}
+	~WNGraph();
+
+	/// (Re)build graph from synset map and word senses of a POS. The senses of a literal are kept
+	/// in the order they have in senses (senses of missing synsets are left out).
+	void build( const std::map<std::string, Synset>& dat, const std::vector<Sense>& senses);
+
+	/// Take the synset with id out of the literal index before its synonyms are changed, or before it's erased
+	/// from the synset map (erase true): then its node becomes a phantom, with no targets. update() puts it back.
+	/// (Nothing is done if id is not a synset of the graph.)
+	void detach( const std::string& id, bool erase);
+
+	/// Update the graph after synset syns (with id, the key of the synset map) is added or changed: its targets are
+	/// set from its ilrs, adding phantom nodes for new targets, and if it's new or detached, it's made a synset node
+	/// (getting a new node if its id has none) and its senses are added to the literal index, after the senses of
+	/// the synsets that were there before it (in the order their senses have in build(), the new ones, and the ones
+	/// that had no senses, in the order they are updated). Only the rows of the changed relations are rewritten, in place if they don't grow.
+	void update( const std::string& id, const Synset& syns);
+
+	/// Number of nodes (synsets + phantoms)
+	size_t		size() const			{ return m_ids.size(); }
+
+	/// Number of synset nodes
+	size_t		synsetCount() const		{ return m_nsyns; }
+
+	/// Get node of synset id, or npos if not found (phantom nodes are found too)
+	tnode		find( const char* id, size_t len) const
+	{
+		const tnode* n = m_nodes.find( id, len);
+		return n == NULL ? npos : *n;
+	}
+	tnode		find( const std::string& id) const		{ return find( id.data(), id.size()); }
+
+	/// Get synset nodes of the senses of literal (in the order of the literal index)
+	Targets		senses( const char* literal, size_t len) const
+	{
+		const unsigned* l = m_literals.find( literal, len);
+		if (l == NULL) {
+			Targets t = { NULL, NULL };
+			return t;
+		}
+		return literalSenses( *l);
+	}
+	Targets		senses( const std::string& literal) const	{ return senses( literal.data(), literal.size()); }
+
+	/// Number of literal numbers (literals that lost all their senses by detach() keep theirs, with no senses)
+	size_t		literalCount() const	{ return m_litnames.size(); }
+
+	/// Literal number l (in byte order if the graph was not changed since build(), empty if it has no senses)
+	const std::string&	literal( unsigned l) const	{ return *m_litnames[l]; }
+
+	/// Synset nodes of the senses of literal number l
+	Targets		literalSenses( unsigned l) const	{ return m_litsenses.row( l); }
+
+	/// Synset id of node
+	const std::string&	id( tnode n) const		{ return *m_ids[n]; }
+
+	/// Synset of node, NULL for phantom nodes (and for npos)
+	const Synset*		synset( tnode n) const	{ return n < m_syns.size() ? m_syns[n] : NULL; }
+
+	/// Get relation type number, or npos if no synset of this POS has such a relation
+	unsigned	relation( const std::string& name) const
+	{
+		std::map<std::string, unsigned>::const_iterator it = m_relids.find( name);
+		return it == m_relids.end() ? npos : it->second;
+	}
+
+	/// Number of relation types
+	size_t				relationCount() const			{ return m_relnames.size(); }
+
+	/// Name of relation type
+	const std::string&	relationName( unsigned rel) const	{ return m_relnames[rel]; }
+
+	/// Get targets of node by relation type (empty range for rel == npos)
+	Targets		targets( unsigned rel, tnode n) const
+	{
+		if (rel >= m_adj.size() || n >= m_ids.size()) {
+			Targets t = { NULL, NULL };
+			return t;
+		}
+		return m_adj[rel].row( n);
+	}
+
+	/// Get nodes having a relation of type rel to node n, in node order (empty range for rel == npos)
+	Targets		sources( unsigned rel, tnode n) const
+	{
+		if (rel >= m_radj.size() || n >= m_ids.size()) {
+			Targets t = { NULL, NULL };
+			return t;
+		}
+		return m_radj[rel].row( n);
+	}
+
+	/// Get LCA index of relation type (rel may be npos), built at first use
+	const LCAIndex&	lcaIndex( unsigned rel) const;
+
+	/// Get reachability index of relation type (rel may be npos), built at first use
+	const IntervalIndex&	intervalIndex( unsigned rel) const;
+
+private:
+	WNGraph( const WNGraph&);				// not copyable
+	WNGraph& operator=( const WNGraph&);
+
+	/// Delete derived indices
+	void		clearIndices();
+
+	/// Delete derived indices of relation type rel
+	void		clearIndices( unsigned rel);
+
+	/// Rows of node numbers (CSR): row i is items[bounds[i].first..bounds[i].second).
+	/// build() stores the rows one after the other; a row changed by a patch is rewritten in place if it doesn't
+	/// grow, else it's moved to the end, and the rows are stored again without gaps when the gaps outgrow them.
+	struct Rows
+	{
+		std::vector< std::pair<unsigned, unsigned> >	bounds;
+		std::vector<tnode>								items;
+		size_t											unused;	///< number of items in no row
+
+		Rows()
+			: unused( 0)
+		{}
+
+		Targets	row( size_t i) const
+		{
+			Targets t;
+			t.first = items.empty() ? NULL : &items[0] + bounds[i].first;
+			t.last = t.first + (bounds[i].second - bounds[i].first);
+			return t;
+		}
+
+		/// Replace row i with nodes (which must not point into items)
+		void	set( size_t i, const std::vector<tnode>& nodes);
+	};
+
+	/// Add a node for id (with no synset), return its number
+	tnode		add_node( const std::string* id);
+
+	/// Get number of relation type name, adding it if it's new
+	unsigned	add_relation( const std::string& name);
+
+	/// Set targets of synset node n by relation type rel (and its sources in the reverse rows)
+	void		set_targets( unsigned rel, tnode n, const std::vector<tnode>& targets);
+
+	/// Make the literal index refer to a copy of the literal of l that is not in synset (if l has senses left),
+	/// or remove l from the hash index (if it has none)
+	void		rekey_literal( unsigned l, const Synset& syns);
+
+	size_t								m_nsyns;
+	std::vector<const Synset*>			m_syns;		///< synsets of the nodes, NULL for phantoms
+	std::vector<const std::string*>		m_ids;		///< ids of all nodes (point into synset map keys, or m_phantoms)
+	std::deque<std::string>				m_phantoms;	///< ids of phantom nodes
+	StringHashTable<tnode>				m_nodes;	///< id -> node
+	std::vector<unsigned>				m_ranks;	///< order of the senses of nodes in literal rows (position of the node's first sense in build(), then
+													///< numbered on as update() adds them), npos for nodes with no senses yet
+	unsigned							m_nextrank;	///< rank of the next node update() adds senses of
+	std::set<tnode>						m_detached;	///< synset nodes taken out of the literal index by detach(), until update()
+	StringHashTable<unsigned>			m_literals;	///< literal -> literal number
+	std::vector<const std::string*>		m_litnames;	///< literals by number (point into the synsets)
+	Rows								m_litsenses;	///< synset nodes of the senses of each literal
+	std::map<std::string, unsigned>		m_relids;	///< relation name -> relation type number
+	std::vector<std::string>			m_relnames;	///< relation type number -> name
+	std::vector<Rows>					m_adj;		///< adjacency per relation type (targets of all nodes, none for phantoms)
+	std::vector<Rows>					m_radj;		///< reverse adjacency per relation type (sources of all nodes, phantoms too)
+
+	mutable std::mutex					m_mutex;	///< guards building derived indices
+	mutable std::vector< std::atomic<LCAIndex*> >	m_lca;	///< LCA index per relation type (last one for npos), NULL if not built yet (sized by build() and add_relation())
+	mutable std::vector< std::atomic<IntervalIndex*> >	m_intervals;	///< reachability index per relation type (last one for npos), NULL if not built yet (sized by build() and add_relation())
+};
+
+
+/// Depth-first walk of a WNGraph along one relation type, with an explicit stack (no recursion),
+/// so long or cyclic relation paths can't overflow the call stack.
+/// Nodes are returned in pre-order, the same order as a recursive walk would visit them.
+/// The visited marks (a bitset) and the stack are scratch space kept per thread and reused by
+/// the next walk, so a walk only allocates when the graph is bigger than any walked before.
+class GraphWalker
+{
+public:
+
+	enum eMode {
+		VisitOnce,	///< every reachable node is returned once
+		VisitPaths,	///< every node is returned once for every path to it (e.g. for printing trees), paths are cut where they would form a cycle
+		VisitTree	///< like VisitPaths, but the targets of a node are only walked at its first occurrence, later ones are returned
+					///< as leaves (see repeated()), so the walk takes time linear in the size of the graph, not in the number of paths
+	};
+
+	/// @param g graph to walk
+	/// @param rel relation type (see WNGraph::relation(), may be npos)
+	/// @param start node to start from (returned first, with depth 0)
+	/// @param mode see eMode
+	/// @param maxdepth don't go further from start than this many steps, -1 for no limit
+	GraphWalker( const WNGraph& g, unsigned rel, WNGraph::tnode start, eMode mode, int maxdepth = -1);
+	~GraphWalker();
+
+	/// Get next node and its distance (number of steps) from the start node.
+	/// @return false if there are no more nodes
+	bool	next( WNGraph::tnode& n, int& depth);
+
+	/// Check whether the node returned last was returned before, and its targets are not walked again
+	/// (only in VisitTree mode; nodes cut off by maxdepth are walked again if they are reached again)
+	bool	repeated() const	{ return m_repeated; }
+
+private:
+	GraphWalker( const GraphWalker&);				// not copyable
+	GraphWalker& operator=( const GraphWalker&);
+
+	struct Frame
+	{
+		WNGraph::tnode			node;
+		const WNGraph::tnode*	cur;	///< next target to visit
+		const WNGraph::tnode*	end;
+		int						depth;
+	};
+
+	struct Scratch
+	{
+		std::vector<unsigned>		bits;		///< visited (VisitOnce) or on current path (VisitPaths)
+		std::vector<WNGraph::tnode>	touched;	///< nodes marked in VisitOnce mode, to clear the bits afterwards
+		std::vector<Frame>			stack;
+		bool						busy;
+
+		Scratch()
+			: busy( false)
+		{}
+	};
+
+	bool	marked( WNGraph::tnode n) const	{ return (m_scratch->bits[n >> 5] & (1u << (n & 31))) != 0; }
+	void	mark( WNGraph::tnode n)			{ m_scratch->bits[n >> 5] |= 1u << (n & 31); }
+	void	unmark( WNGraph::tnode n)		{ m_scratch->bits[n >> 5] &= ~(1u << (n & 31)); }
+	void	push( WNGraph::tnode n, int depth);
+
+	const WNGraph&	m_graph;
+	unsigned		m_rel;
+	WNGraph::tnode	m_start;	///< npos after it was returned
+	eMode			m_mode;
+	int				m_maxdepth;
+	Scratch*		m_scratch;
+	bool			m_ownscratch; ///< scratch was allocated for this walk (the thread's one was in use by another walk)
+	bool			m_repeated;	///< see repeated()
+};
+
+
+/// Breadth-first search from a synset along one relation type, one level at a time.
+/// Every reachable synset is visited once, at its shortest distance; missing targets are skipped.
+/// The distances are kept in per-thread scratch space, reused by later searches
+/// (several searches can be active in a thread at the same time).
+class GraphBFS
+{
+public:
+
+	/// @param g graph to search
+	/// @param rel relation type (see WNGraph::relation(), may be npos)
+	/// @param start node to start from (level 0, empty if it's not a synset)
+	/// @param maxdepth don't go further from start than this many steps, -1 for no limit
+	GraphBFS( const WNGraph& g, unsigned rel, WNGraph::tnode start, int maxdepth = -1);
+	~GraphBFS();
+
+	/// Nodes of the current level
+	WNGraph::Targets	level() const
+	{
+		WNGraph::Targets t;
+		t.first = m_scratch->order.empty() ? NULL : &m_scratch->order[0] + m_levelbegin;
+		t.last = t.first + (m_scratch->order.size() - m_levelbegin);
+		return t;
+	}
+
+	/// Distance of the current level from start
+	int			depth() const	{ return m_depth; }
+
+	/// Go to next level.
+	/// @return false if it's empty (all reachable nodes have been visited, or maxdepth was reached)
+	bool		nextLevel();
+
+	/// Distance of synset node from start, -1 if not visited (yet)
+	int			distance( WNGraph::tnode n) const	{ return m_scratch->dist[n]; }
+
+private:
+	GraphBFS( const GraphBFS&);				// not copyable
+	GraphBFS& operator=( const GraphBFS&);
+
+	struct Scratch
+	{
+		std::vector<int>			dist;	///< distance of synset nodes, -1 if not visited
+		std::vector<WNGraph::tnode>	order;	///< visited nodes, level by level
+		bool						busy;
+
+		Scratch()
+			: busy( false)
+		{}
+	};
+
+	const WNGraph&	m_graph;
+	unsigned		m_rel;
+	int				m_maxdepth;
+	int				m_depth;
+	size_t			m_levelbegin;	///< start of current level in order
+	Scratch*		m_scratch;
+};
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __WNGRAPH_H__
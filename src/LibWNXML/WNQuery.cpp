@@ -1,409 +1,1252 @@
-#include <fstream>
-#include <iomanip>
-#include <sstream>
-#include "WNXMLParser.h"
-#include "WNQuery.h"
-
-namespace LibWNXML {
-
-
-WNQuery::WNQuery( const std::string& wnxmlfilename, ML::MultiLog& logger)
-	: m_logger(logger)
-{
-	// open file
-	std::ifstream inf( wnxmlfilename.c_str());
-	if (!inf) {
-		ML_THROW_EXC( "Could not open file: " << wnxmlfilename, WNQueryException);
-	}
-
-	// parse input file
-	std::auto_ptr<WNXMLParser> psr = std::auto_ptr<WNXMLParser>( new WNXMLParser( "ISO-8859-2"));
-	Synset syns;
-	int lcnt = 0;
-	while (!inf.eof()) {
-		psr->parseXMLSynset( inf, syns, ++lcnt); // read next synset
-		_save_synset( syns, lcnt);
-	}
-	// finish parsing (?call to xmlpp::SaxParser::finish_chunk_parsing() perhaps parses end of internal buffer?)
-	psr->finishParsing();
-	_save_synset( syns, lcnt);
-
-	// invert relations
-	invert_relations();
-
-}
-
-
-void WNQuery::_save_synset( Synset& syns, int lcnt)
-{
-	if (syns.empty())
-		return;
-	try {
-		// check if id already exists, print warning if yes
-		if (dat(syns.pos).find(syns.id) != dat(syns.pos).end()) {
-			std::ostringstream os;
-			os << "Warning W01: synset with this id (" << syns.id << ") already exists (input line " << lcnt << ")";
-			m_logger.addLog( os.str(), 3);
-			return;
-		}
-		// store synset
-		dat(syns.pos)[ syns.id ] = syns;
-		// index literals
-		for (size_t i=0; i!=syns.synonyms.size(); i++)
-			idx(syns.pos).insert( std::make_pair( syns.synonyms[i].literal, syns.id));
-	}
-	catch (const InvalidPOSException& e) {
-		std::ostringstream os;
-		os << "Warning W02: "<< e.msg() << " for synset in input line " << lcnt;
-		m_logger.addLog( os.str(), 3);
-	}
-}
-
-
-void WNQuery::invert_relations()
-{
-	// create inversion table
-	std::map<std::string,std::string> inv;
-	_invRelTable( inv);
-
-	// nouns
-	m_logger.addLog("Inverting relations for nouns...", 3);
-	_inv_rel_pos( m_ndat, inv);
-	// verbs
-	m_logger.addLog("Inverting relations for verbs...", 3);
-	_inv_rel_pos( m_vdat, inv);
-	// adjectives
-	m_logger.addLog("Inverting relations for adjectives...", 3);
-	_inv_rel_pos( m_adat, inv);
-	// adverbs
-	m_logger.addLog("Inverting relations for adverbs...", 3);
-	_inv_rel_pos( m_bdat, inv);
-}
-
-void WNQuery::_inv_rel_pos( tdat& dat, std::map<std::string,std::string>& inv)
-{
-	// for all synsets
-	for (tdat::iterator it=dat.begin(); it!=dat.end(); it++) {
-		// for all relations of synset
-		for (size_t i=0; i!=it->second.ilrs.size(); i++) {
-			// check if invertable
-			std::map<std::string,std::string>::iterator invr = inv.find(it->second.ilrs[i].second);
-			if (invr != inv.end()) {
-				// check if target exists
-				tdat::iterator tt = dat.find( it->second.ilrs[i].first);
-				if (tt == dat.end()) {
-					std::ostringstream os;
-					os  << "Warning W03: synset " << it->second.ilrs[i].first << " is missing ('" << invr->first << "' target from synset " << it->first << ")";
-					m_logger.addLog( os.str(), 3);
-				}
-				else {
-					// check wether target is not the same as source
-					if (tt->second.id == it->second.id) {
-						std::ostringstream os;
-						os  << "Warning W04: self-referencing relation '" << invr->second << "' for synset "  << it->second.id;
-						m_logger.addLog( os.str(), 3);
-					}
-					else {
-						// add inverse to target synset
-						tt->second.ilrs.push_back( std::make_pair(it->first, invr->second));
-						//std::ostringstream os;
-						//os  << "Added inverted relation (target=" << it->first << ",type=" << invr->second << ") to synset " << tt->second.id;
-						//m_logger.addLog( os.str(), 3);
-					} // if target and source are not the same
-				} // if target exists
-			} // if invertible
-		} // for all relations
-	} // for all synsets
-}
-
-
-bool WNQuery::lookUpID( const std::string& id, const std::string& pos, Synset& syns) const
-{
-	syns.clear();
-	tdat::const_iterator it = dat(pos).find( id);
-	if (it == dat(pos).end())
-		return false;
-	else {
-		syns = it->second;
-		return true;
-	}
-}
-
-
-bool WNQuery::lookUpLiteral( const std::string& literal, const std::string& pos, std::vector<Synset>& res) const
-{
-	res.clear();
-	std::pair<tidx::const_iterator,tidx::const_iterator> ip = idx(pos).equal_range( literal);
-	if (ip.first == ip.second)
-		return false;
-	for (tidx::const_iterator i=ip.first; i!=ip.second; i++) {
-		Synset syns;
-		if (lookUpID( i->second, pos, syns))
-			res.push_back( syns);
-	}
-	return true;
-}
-
-
-bool WNQuery::lookUpLiteral( const std::string& literal, const std::string& pos, std::vector<std::string>& res) const
-{
-	res.clear();
-	std::pair<tidx::const_iterator,tidx::const_iterator> ip = idx(pos).equal_range( literal);
-	if (ip.first == ip.second)
-		return false;
-	for (tidx::const_iterator i=ip.first; i!=ip.second; i++)
-		res.push_back( i->second);
-	return true;
-}
-
-
-bool WNQuery::lookUpSense( const std::string& literal, const int sensenum, const std::string& pos, Synset& syns) const
-{
-	syns.clear();
-	std::vector<Synset> res;
-	if (!lookUpLiteral( literal, pos, res))
-		return false;
-	for (size_t i=0; i!=res.size(); i++) {
-		for (size_t j=0; j!=res[i].synonyms.size(); j++) {
-			if (res[i].synonyms[j].literal == literal && atoi(res[i].synonyms[j].sense.c_str()) == sensenum) {
-				syns = res[i];
-				return true;
-			}
-		}
-	}
-	return false;
-}
-
-
-void WNQuery::lookUpRelation( const std::string& id, const std::string& pos, const std::string& relation, std::vector<std::string>& targetIDs) const throw(InvalidPOSException)
-{
-	targetIDs.clear();
-	// look up current synset
-	tdat::const_iterator it = dat(pos).find( id);
-	if (it == dat(pos).end()) // not found
-		return;
-	// get relation targets
-	const std::vector< std::pair< std::string, std::string > >& ilrs = it->second.ilrs;
-	for (size_t i=0; i!=ilrs.size(); i++)
-		if (ilrs[i].second == relation)
-			targetIDs.push_back( ilrs[i].first);
-}
-
-
-void WNQuery::traceRelation( const std::string& id, const std::string& pos, const std::string& relation, std::vector<std::string>& result) const
-{
-	result.clear();
-	trace_rel_rec( id, pos, relation, result);
-}
-
-
-void WNQuery::trace_rel_rec( const std::string& id, const std::string& pos, const std::string& rel, std::vector<std::string>& res) const
-{
-	// get children
-	std::vector<std::string> ids;
-	lookUpRelation( id, pos, rel, ids);
-	if (ids.empty()) // not found
-		return;
-	// save current synset
-	res.push_back( id);
-	// recurse on children
-	for (size_t i=0; i!=ids.size(); i++) // for all relations of synset
-		trace_rel_rec( ids[i], pos, rel, res); // recurse on target
-}
-
-
-void WNQuery::traceRelationOS( const std::string& id, const std::string& pos, const std::string& relation, std::ostream& os) const
-{
-	trace_rel_os_rec( id, pos, relation, os, 0);
-}
-
-
-void WNQuery::trace_rel_os_rec( const std::string& id, const std::string& pos, const std::string& rel, std::ostream& os, int lev) const
-{
-	// look up current synset
-	tdat::const_iterator it = dat(pos).find( id);
-	if (it == dat(pos).end()) // not found
-		return;
-	// print current synset
-	for (int i=0; i<lev; i++) os << "  "; // indent
-	os << it->second.id << "  {";
-	for (size_t i=0; i!=it->second.synonyms.size(); i++) {
-		os << it->second.synonyms[i].literal << ":" << it->second.synonyms[i].sense;
-		if (i != it->second.synonyms.size()-1)
-			os << ", ";
-	}
-	os << "}  (" << it->second.def << ")\n";
-	// recurse on children
-	lev++;
-	for (size_t i=0; i!=it->second.ilrs.size(); i++) // for all relations of synset
-		if (it->second.ilrs[i].second == rel) // if it is the right type
-			trace_rel_os_rec( it->second.ilrs[i].first, pos, rel, os, lev); // recurse on target	
-}
-
-
-bool WNQuery::isIDConnectedWith( const std::string& id, const std::string& pos, const std::string& relation, const std::set<std::string>& target_ids,  std::string& foundTargetID) const
-{
-	foundTargetID = "";
-	is_id_connected_with_rec( id, pos, relation, target_ids, foundTargetID);
-	return ( foundTargetID != "");
-}
-
-
-void WNQuery::is_id_connected_with_rec( const std::string& id, const std::string& pos, const std::string& rel, const std::set<std::string>& targ_ids, std::string& foundTargetID) const
-{
-	// check if current synset is any of the searched ids
-	if (targ_ids.count( id) != 0) { // found it
-		foundTargetID = id;
-		return; 
-	}
-	// look up / get children of current synset
-	std::vector<std::string> children;
-	lookUpRelation( id, pos, rel, children);
-	if (children.empty())
-		return;
-	// recurse on children
-	for (size_t i=0; i!=children.size(); i++) {
-			if (foundTargetID != "") // check if not found already
-				return;
-			else 
-				is_id_connected_with_rec( children[i], pos, rel, targ_ids, foundTargetID); // recurse on target
-	}
-}
-
-
-bool WNQuery::isLiteralConnectedWith( const std::string& literal, const std::string& pos, const std::string& relation, const std::set<std::string>& targ_ids, std::string& foundID, std::string& foundTargetID) const
-{
-	foundID = "";
-	foundTargetID = "";
-	std::vector<std::string> ids;
-	lookUpLiteral( literal, pos, ids);
-	for (size_t i=0; i!=ids.size(); i++)
-		if (isIDConnectedWith( ids[i], pos, relation, targ_ids, foundTargetID)) {
-			foundID = ids[i];
-			return true;
-		}
-	return false;
-}
-
-
-bool WNQuery::isLiteralCompatibleWithSynset( const std::string& literal, const std::string& pos, const std::string id, bool hyponyms) const
-{
-	// check if synset contains literal
-	Synset syns;
-	if (!lookUpID( id, pos, syns))
-		return false;
-	for (size_t i=0; i!=syns.synonyms.size(); i++)
-		if (syns.synonyms[i].literal == literal)
-			return true;
-	// if allowed, recurse on hyponyms
-	if (hyponyms) {
-		for (size_t i=0; i!=syns.ilrs.size(); i++) {
-			if (syns.ilrs[i].second == "hyponym") {
-				if (isLiteralCompatibleWithSynset( literal, pos, syns.ilrs[i].first, true))
-					return true;
-			}
-		}
-	}
-	return false;
-}
-
-
-bool WNQuery::areSynonyms(	const std::string& literal1, 
-							const std::string& literal2,
-							const std::string& pos,
-							std::string& synsetid
-						)  const
-{
-	synsetid = "";
-
-	// get senses of input word1
-	std::vector<std::string> senses1;
-	lookUpLiteral( literal1, pos, senses1);
-
-	// for each sense, check if it contains word2
-	for (size_t i=0; i<senses1.size(); i++)
-		if ( isLiteralCompatibleWithSynset( literal2, pos, senses1[i], false)) {
-			synsetid = senses1[i];
-			return true;
-		}
-
-	// no common synset
-	return false;
-}
-
-
-void WNQuery::writeStats( std::ostream& os) const
-{
-	os << "PoS       \t#synsets\t#word senses\n";
-	os << "Nouns     \t" << std::setw(8) << int(dat("n").size()) << "\t" << std::setw(11) << int(idx("n").size()) << std::endl;
-	os << "Verbs     \t" << std::setw(8) << int(dat("v").size()) << "\t" << std::setw(11) << int(idx("v").size()) << std::endl;
-	os << "Adjectives\t" << std::setw(8) << int(dat("a").size()) << "\t" << std::setw(11) << int(idx("a").size()) << std::endl;
-	os << "Adverbs   \t" << std::setw(8) << int(dat("b").size()) << "\t" << std::setw(11) <<  int(idx("b").size()) << std::endl;
-}
-
-
-WNQuery::tdat&	WNQuery::dat( const std::string& pos)
-{
-	if (pos == "n")
-		return m_ndat;
-	else if (pos == "v")
-		return m_vdat;
-	else if (pos == "a")
-		return m_adat;
-	else if (pos == "b")
-		return m_bdat;
-	else {
-		ML_THROW_EXC("Invalid POS '" << pos << "'", InvalidPOSException);
-	}
-}
-
-
-const WNQuery::tdat& WNQuery::dat( const std::string& pos) const
-{
-	if (pos == "n")
-		return m_ndat;
-	else if (pos == "v")
-		return m_vdat;
-	else if (pos == "a")
-		return m_adat;
-	else if (pos == "b")
-		return m_bdat;
-	else {
-		ML_THROW_EXC("Invalid POS '" << pos << "'", InvalidPOSException);
-	}
-}
-
-
-WNQuery::tidx&	WNQuery::idx( const std::string& pos)
-{
-	if (pos == "n")
-		return m_nidx;
-	else if (pos == "v")
-		return m_vidx;
-	else if (pos == "a")
-		return m_aidx;
-	else if (pos == "b")
-		return m_bidx;
-	else {
-		ML_THROW_EXC("Invalid POS '" << pos << "'", InvalidPOSException);
-	}
-}
-
-
-const WNQuery::tidx&	WNQuery::idx( const std::string& pos) const
-{
-	if (pos == "n")
-		return m_nidx;
-	else if (pos == "v")
-		return m_vidx;
-	else if (pos == "a")
-		return m_aidx;
-	else if (pos == "b")
-		return m_bidx;
-	else {
-		ML_THROW_EXC("Invalid POS '" << pos << "'", InvalidPOSException);
-	}
-}
-
-} // namespace LibWNXML {
-
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include "../CharConverter/EncodingNames.h"
+#include "IntervalIndex.h"
+#include "WNXMLParser.h"
+#include "WNQuery.h"
+
+namespace LibWNXML {
+
+
+namespace {
+
+/// Seconds elapsed since t
+double seconds_since( std::chrono::steady_clock::time_point t)
+{
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - t).count();
+}
+
+/// POS of the literal trie, in the order of its POS numbers
+const char TriePosNames[4] = { 'n', 'v', 'a', 'b' };
+
+/// POS number of the literal trie (see LiteralTrie::senses()), -1 for all POS (empty pos)
+int trie_pos( const std::string& pos)
+{
+	if (pos.empty())
+		return -1;
+	for (int p=0; p!=4; p++)
+		if (pos.size() == 1 && pos[0] == TriePosNames[p])
+			return p;
+	ML_THROW_EXC("Invalid POS '" << pos << "'", InvalidPOSException);
+}
+
+/// Append the word senses of a synset (with its id) to senses
+void add_senses( const std::string& id, const Synset& syns, WNQuery::tsenses& senses)
+{
+	for (size_t i=0; i!=syns.synonyms.size(); i++) {
+		WNGraph::Sense s = { &syns.synonyms[i].literal, &id };
+		senses.push_back( s);
+	}
+}
+
+} // namespace {
+
+
+WNQuery::WNQuery( const std::string& wnxmlfilename, ML::MultiLog& logger, unsigned nthreads, const std::string& encoding)
+	: m_logger(logger)
+	, m_encoding(encoding)
+	, m_folded(NULL)
+	, m_generation(0)
+{
+	// (checked here, the parsers would throw WNXMLParserException)
+	if (ML::EncodingNames::getEncoding( m_encoding.c_str()) == ML::CharEncoding::UNKNOWN) {
+		ML_THROW_EXC( "Unknown character encoding: " << m_encoding, WNQueryException);
+	}
+	if (nthreads == 0)
+		nthreads = std::thread::hardware_concurrency();
+
+	// parse input file
+	if (nthreads > 1)
+		_load_parallel( wnxmlfilename, nthreads);
+	else
+		_load_serial( wnxmlfilename);
+
+	// invert relations
+	std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+	invert_relations();
+	m_stats.m_times.invert = seconds_since( t);
+
+	// build relation graphs
+	build_indices( true);
+}
+
+
+WNQuery::~WNQuery()
+{
+	delete m_folded.exchange( NULL);
+}
+
+
+void WNQuery::_load_serial( const std::string& wnxmlfilename)
+{
+	// open file
+	std::ifstream inf( wnxmlfilename.c_str());
+	if (!inf) {
+		ML_THROW_EXC( "Could not open file: " << wnxmlfilename, WNQueryException);
+	}
+
+	// parse input file
+	std::auto_ptr<WNXMLParser> psr = std::auto_ptr<WNXMLParser>( new WNXMLParser( m_encoding));
+	psr->setBlockSize( WNXMLParser::DefaultBlockSize);
+	Synset syns;
+	int lcnt = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(), t;
+	while (!inf.eof() || psr->hasBuffered()) {
+		psr->parseXMLSynset( inf, syns, lcnt); // read next synset
+		t = std::chrono::steady_clock::now();
+		_save_synset( syns, lcnt);
+		m_stats.m_times.save += seconds_since( t);
+	}
+	// finish parsing (xmlpp::SaxParser::finish_chunk_parsing() parses the end of its internal buffer, which may complete synsets)
+	psr->finishParsing();
+	while (psr->hasBuffered()) {
+		psr->parseXMLSynset( inf, syns, lcnt);
+		t = std::chrono::steady_clock::now();
+		_save_synset( syns, lcnt);
+		m_stats.m_times.save += seconds_since( t);
+	}
+	m_stats.m_times.parse = seconds_since( start) - m_stats.m_times.save;
+}
+
+
+namespace {
+
+/// Input stream buffer reading directly from memory (no copying)
+class MemoryStreamBuf : public std::streambuf
+{
+public:
+	MemoryStreamBuf( const char* begin, const char* end)
+	{ setg( const_cast<char*>( begin), const_cast<char*>( begin), const_cast<char*>( end)); }
+};
+
+/// Parses one chunk of the input (a run of whole SYNSETs) with its own parser, in its own thread.
+/// The chunk is preceded by the prolog of the file (XML declaration, DOCTYPE, root tag),
+/// so that the parser sees the same encoding and root element as for the whole file.
+struct ParseChunkJob
+{
+	std::string								text;		///< prolog + chunk
+	int										startline;	///< line number to start counting from (so that line numbers match those of the whole file)
+	std::string								encoding;
+	std::vector< std::pair<Synset, int> >	result;		///< synsets read, with input line numbers
+	std::exception_ptr						error;
+
+	void operator()()
+	{
+		try {
+			MemoryStreamBuf buf( text.data(), text.data() + text.size());
+			std::istream is( &buf);
+			WNXMLParser psr( encoding);
+			psr.setBlockSize( WNXMLParser::DefaultBlockSize);
+			Synset syns;
+			int lcnt = startline;
+			while (!is.eof() || psr.hasBuffered()) {
+				psr.parseXMLSynset( is, syns, lcnt);
+				if (!syns.empty())
+					result.push_back( std::make_pair( syns, lcnt));
+			}
+			psr.finishParsing();
+			while (psr.hasBuffered()) {
+				psr.parseXMLSynset( is, syns, lcnt);
+				result.push_back( std::make_pair( syns, lcnt));
+			}
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+	}
+};
+
+} // namespace {
+
+
+void WNQuery::_load_parallel( const std::string& wnxmlfilename, unsigned nthreads)
+{
+	// read whole file
+	std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+	std::ifstream inf( wnxmlfilename.c_str(), std::ios::in | std::ios::binary);
+	if (!inf) {
+		ML_THROW_EXC( "Could not open file: " << wnxmlfilename, WNQueryException);
+	}
+	std::string data;
+	inf.seekg( 0, std::ios::end);
+	data.resize( size_t( inf.tellg()));
+	inf.seekg( 0, std::ios::beg);
+	if (!data.empty())
+		inf.read( &data[0], std::streamsize( data.size()));
+	if (!inf) {
+		ML_THROW_EXC( "Error reading file: " << wnxmlfilename, WNQueryException);
+	}
+
+	// everything before the first SYNSET is the prolog, repeated in front of every chunk
+	size_t first = data.find( "<SYNSET>");
+	if (first == std::string::npos) // nothing to split
+		first = data.size();
+	const std::string prolog = data.substr( 0, first);
+	const int prologlines = int( std::count( prolog.begin(), prolog.end(), '\n'));
+
+	// split the rest into about equal sized chunks at SYNSET start tags
+	// (a few more chunks than threads, to even out differences in parsing speed)
+	size_t nchunks = size_t( nthreads) * 4;
+	std::vector<size_t> bounds;
+	bounds.push_back( first);
+	for (size_t k=1; k<nchunks; k++) {
+		size_t b = data.find( "<SYNSET>", std::max( bounds.back() + 1, first + (data.size() - first) * k / nchunks));
+		if (b == std::string::npos)
+			break;
+		bounds.push_back( b);
+	}
+	bounds.push_back( data.size());
+
+	std::vector<ParseChunkJob> jobs( bounds.size() - 1);
+	int line = 1 + prologlines; // line number of the start of the current chunk
+	for (size_t k=0; k!=jobs.size(); k++) {
+		if (k != 0)
+			line += int( std::count( data.begin() + bounds[k-1], data.begin() + bounds[k], '\n'));
+		jobs[k].text = prolog + data.substr( bounds[k], bounds[k+1] - bounds[k]);
+		jobs[k].startline = line - 1 - prologlines;
+		jobs[k].encoding = m_encoding;
+	}
+	std::string().swap( data);
+
+	// parse chunks, at most nthreads at a time
+	for (size_t k=0; k<jobs.size(); k+=nthreads) {
+		std::vector<std::thread> threads;
+		for (size_t j=k; j<jobs.size() && j<k+nthreads; j++)
+			threads.push_back( std::thread( std::ref( jobs[j])));
+		for (size_t j=0; j!=threads.size(); j++)
+			threads[j].join();
+	}
+
+	m_stats.m_times.parse = seconds_since( t);
+
+	// store results in input order, so that duplicate/invalid POS handling and warnings are the same as when loading serially
+	t = std::chrono::steady_clock::now();
+	for (size_t k=0; k!=jobs.size(); k++) {
+		if (jobs[k].error)
+			std::rethrow_exception( jobs[k].error);
+		for (size_t i=0; i!=jobs[k].result.size(); i++)
+			_save_synset( jobs[k].result[i].first, jobs[k].result[i].second);
+		std::vector< std::pair<Synset, int> >().swap( jobs[k].result);
+	}
+	m_stats.m_times.save = seconds_since( t);
+}
+
+
+void WNQuery::_save_synset( Synset& syns, int lcnt)
+{
+	if (syns.empty())
+		return;
+	try {
+		// check if id already exists, print warning if yes
+		if (_dat(syns.pos).find(syns.id) != _dat(syns.pos).end()) {
+			std::ostringstream os;
+			os << "Warning W01: synset with this id (" << syns.id << ") already exists (input line " << lcnt << ")";
+			m_logger.addLog( os.str(), 3);
+			m_stats.m_counts.warnings[0]++;
+			return;
+		}
+		// store synset
+		tdat::iterator it = _dat(syns.pos).insert( std::make_pair( syns.id, Synset())).first;
+		it->second = syns;
+		m_stats.m_counts.synsets++;
+		m_stats.m_counts.relations += syns.ilrs.size();
+		// index literals
+		add_senses( it->first, it->second, _senses(syns.pos));
+	}
+	catch (const InvalidPOSException& e) {
+		std::ostringstream os;
+		os << "Warning W02: "<< e.msg() << " for synset in input line " << lcnt;
+		m_logger.addLog( os.str(), 3);
+		m_stats.m_counts.warnings[1]++;
+	}
+}
+
+
+void WNQuery::invert_relations()
+{
+	// create inversion table
+	std::map<std::string,std::string> inv;
+	_invRelTable( inv);
+
+	// nouns
+	m_logger.addLog("Inverting relations for nouns...", 3);
+	_inv_rel_pos( m_ndat, inv);
+	// verbs
+	m_logger.addLog("Inverting relations for verbs...", 3);
+	_inv_rel_pos( m_vdat, inv);
+	// adjectives
+	m_logger.addLog("Inverting relations for adjectives...", 3);
+	_inv_rel_pos( m_adat, inv);
+	// adverbs
+	m_logger.addLog("Inverting relations for adverbs...", 3);
+	_inv_rel_pos( m_bdat, inv);
+}
+
+void WNQuery::build_indices( bool trie)
+{
+	m_logger.addLog("Building relation graphs...", 3);
+	std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+	m_ngraph.build( m_ndat, m_nsenses);
+	m_vgraph.build( m_vdat, m_vsenses);
+	m_agraph.build( m_adat, m_asenses);
+	m_bgraph.build( m_bdat, m_bsenses);
+	if (trie) {
+		m_logger.addLog("Building literal trie...", 3);
+		m_trie.build( m_ngraph, m_vgraph, m_agraph, m_bgraph);
+	}
+	{
+		// (the old folded index is deleted here while queries might hold a reference to it, which is safe only
+		// because changing the content is never concurrent with queries, see the class doc)
+		std::lock_guard<std::mutex> lock( m_mutex);
+		delete m_folded.exchange( NULL);
+		for (int p=0; p!=4; p++)
+			m_idx[p].reset();
+	}
+	m_generation.fetch_add( 1, std::memory_order_release);
+	m_stats.m_times.graphs = seconds_since( t);
+}
+
+
+void WNQuery::_inv_rel_pos( tdat& dat, std::map<std::string,std::string>& inv)
+{
+	// for all synsets
+	for (tdat::iterator it=dat.begin(); it!=dat.end(); it++) {
+		// for all relations stated by synset (not the inverses added to it, a symmetric one would be inverted back)
+		const size_t nstated = it->second.ilrs.size() - it->second.inverted;
+		for (size_t i=0; i!=nstated; i++) {
+			// check if invertable
+			std::map<std::string,std::string>::iterator invr = inv.find(it->second.ilrs[i].second);
+			if (invr != inv.end()) {
+				// check if target exists
+				tdat::iterator tt = dat.find( it->second.ilrs[i].first);
+				if (tt == dat.end()) {
+					std::ostringstream os;
+					os  << "Warning W03: synset " << it->second.ilrs[i].first << " is missing ('" << invr->first << "' target from synset " << it->first << ")";
+					m_logger.addLog( os.str(), 3);
+					m_stats.m_counts.warnings[2]++;
+				}
+				else {
+					// check wether target is not the same as source
+					if (tt->second.id == it->second.id) {
+						std::ostringstream os;
+						os  << "Warning W04: self-referencing relation '" << invr->second << "' for synset "  << it->second.id;
+						m_logger.addLog( os.str(), 3);
+						m_stats.m_counts.warnings[3]++;
+					}
+					else {
+						// add inverse to target synset
+						tt->second.ilrs.push_back( std::make_pair(it->first, invr->second));
+						tt->second.inverted++;
+						m_stats.m_counts.inverted++;
+						//std::ostringstream os;
+						//os  << "Added inverted relation (target=" << it->first << ",type=" << invr->second << ") to synset " << tt->second.id;
+						//m_logger.addLog( os.str(), 3);
+					} // if target and source are not the same
+				} // if target exists
+			} // if invertible
+		} // for all relations
+	} // for all synsets
+}
+
+
+namespace {
+
+/// Check whether a synset of a patch deletes the synset with its id (it has nothing but an id and a POS)
+bool is_deletion( const Synset& syns)
+{
+	return syns.synonyms.empty() && syns.ilrs.empty() && syns.def.empty() && syns.bcs.empty() && syns.usages.empty()
+		&& syns.snotes.empty() && syns.stamp.empty() && syns.domain.empty() && syns.sumolinks.empty() && syns.nl.empty()
+		&& syns.tnl.empty() && syns.elrs.empty() && syns.ekszlinks.empty() && syns.vframelinks.empty();
+}
+
+/// Check whether two synsets have the same literals (in any order)
+bool same_literals( const Synset& s1, const Synset& s2)
+{
+	if (s1.synonyms.size() != s2.synonyms.size())
+		return false;
+	std::vector<std::string> l1, l2;
+	for (size_t i=0; i!=s1.synonyms.size(); i++) {
+		l1.push_back( s1.synonyms[i].literal);
+		l2.push_back( s2.synonyms[i].literal);
+	}
+	std::sort( l1.begin(), l1.end());
+	std::sort( l2.begin(), l2.end());
+	return l1 == l2;
+}
+
+/// Compares the source id of an inverted relation
+struct SourceLess
+{
+	bool operator()( const std::string& id, const std::pair<std::string, std::string>& r) const	{ return id < r.first; }
+};
+
+/// Add an inverted relation of type from source to synset (see Synset::inverted), after the ones from sources with
+/// lower or equal ids (the order _inv_rel_pos() adds them in)
+void insert_inverted( Synset& syns, const std::string& source, const std::string& type)
+{
+	Synset::tPtrVect::iterator first = syns.ilrs.end() - syns.inverted;
+	syns.ilrs.insert( std::upper_bound( first, syns.ilrs.end(), source, SourceLess()), std::make_pair( source, type));
+	syns.inverted++;
+}
+
+/// Remove an inverted relation of synset to target of type (see Synset::inverted), return false if there is none
+bool remove_inverted( Synset& syns, const std::string& target, const std::string& type)
+{
+	const size_t first = syns.ilrs.size() - syns.inverted;
+	for (size_t i=syns.ilrs.size(); i!=first; ) {
+		i--;
+		if (syns.ilrs[i].first == target && syns.ilrs[i].second == type) {
+			syns.ilrs.erase( syns.ilrs.begin() + i);
+			syns.inverted--;
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace {
+
+
+WNQuery::PatchCounts WNQuery::applyPatch( const std::string& patchfilename)
+{
+	// open file
+	std::ifstream inf( patchfilename.c_str());
+	if (!inf) {
+		ML_THROW_EXC( "Could not open file: " << patchfilename, WNQueryException);
+	}
+
+	// parse the whole patch first, so that the WordNet is not changed if it's invalid
+	m_logger.addLog("Reading patch...", 3);
+	std::vector<Synset> patch;
+	std::vector<int> lines;
+	WNXMLParser psr( m_encoding);
+	psr.setBlockSize( WNXMLParser::DefaultBlockSize);
+	Synset syns;
+	int lcnt = 0;
+	while (!inf.eof() || psr.hasBuffered()) {
+		psr.parseXMLSynset( inf, syns, lcnt);
+		if (!syns.empty()) {
+			patch.push_back( syns);
+			lines.push_back( lcnt);
+		}
+	}
+	psr.finishParsing();
+	while (psr.hasBuffered()) {
+		psr.parseXMLSynset( inf, syns, lcnt);
+		if (!syns.empty()) {
+			patch.push_back( syns);
+			lines.push_back( lcnt);
+		}
+	}
+	return _apply_patch( patch, &lines);
+}
+
+
+WNQuery::PatchCounts WNQuery::applyPatch( const std::vector<Synset>& patch)
+{
+	return _apply_patch( patch, NULL);
+}
+
+
+WNQuery::PatchCounts WNQuery::_apply_patch( const std::vector<Synset>& patch, const std::vector<int>* lines)
+{
+	// the synsets of the patch by POS and id, and in the order of the patch
+	const char* const posnames[4] = { "n", "v", "a", "b" };
+	std::map<std::string, const Synset*> edits[4];
+	std::vector<const Synset*> order[4];
+	for (size_t i=0; i!=patch.size(); i++) {
+		const Synset& ps = patch[i];
+		std::ostringstream at; // position in the patch, for warnings
+		if (lines != NULL)
+			at << "patch line " << (*lines)[i];
+		else
+			at << "patch synset #" << i + 1;
+		int p = 0;
+		while (p != 4 && ps.pos != posnames[p])
+			p++;
+		if (p == 4) {
+			std::ostringstream os;
+			os << "Warning W02: Invalid POS '" << ps.pos << "' for synset in " << at.str();
+			m_logger.addLog( os.str(), 3);
+			m_stats.m_counts.warnings[1]++;
+		}
+		else if (!edits[p].insert( std::make_pair( ps.id, &ps)).second) {
+			std::ostringstream os;
+			os << "Warning W01: synset with this id (" << ps.id << ") is already in the patch (" << at.str() << ")";
+			m_logger.addLog( os.str(), 3);
+			m_stats.m_counts.warnings[0]++;
+		}
+		else
+			order[p].push_back( &ps);
+	}
+
+	// apply, updating the graphs in place, unless most of a POS changes (or most of its nodes are phantoms left
+	// by deletions): then its graph is built again
+	std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+	std::map<std::string,std::string> inv;
+	_invRelTable( inv);
+	PatchCounts counts = { 0, 0, 0 };
+	std::vector<LiteralTrie::Count> litcounts;
+	for (int p=0; p!=4; p++) {
+		if (edits[p].empty())
+			continue;
+		tdat& dat = _dat( posnames[p]);
+		WNGraph& g = _graph( posnames[p]);
+		bool inplace = 2 * edits[p].size() <= dat.size() && 2 * g.synsetCount() >= g.size();
+		std::set<std::string> literals;
+		_patch_pos( dat, _senses( posnames[p]), g, inplace, order[p], edits[p], inv, counts, literals);
+		if (!inplace) {
+			m_logger.addLog("Building relation graphs...", 3);
+			g.build( dat, senses( posnames[p]));
+		}
+		for (std::set<std::string>::const_iterator l=literals.begin(); l!=literals.end(); l++) {
+			LiteralTrie::Count c = { *l, p, unsigned( g.senses( *l).size()) };
+			litcounts.push_back( c);
+		}
+	}
+
+	// derived indices: the literals changed in the trie (and the folded index), the others dropped
+	std::vector<unsigned> added;
+	bool inserted = m_trie.update( litcounts, added);
+	{
+		// (the old folded index is deleted here while queries might hold a reference to it, which is safe only
+		// because changing the content is never concurrent with queries, see the class doc)
+		std::lock_guard<std::mutex> lock( m_mutex);
+		FoldedIndex* folded = m_folded.load( std::memory_order_relaxed);
+		if (!inserted)
+			delete m_folded.exchange( NULL);
+		else if (folded != NULL)
+			for (size_t i=0; i!=added.size(); i++)
+				folded->insert( added[i], m_trie.literal( added[i]), m_trie.length( added[i]));
+		for (int p=0; p!=4; p++)
+			m_idx[p].reset();
+	}
+	m_generation.fetch_add( 1, std::memory_order_release);
+	m_stats.m_times.graphs = seconds_since( t);
+	return counts;
+}
+
+
+void WNQuery::_patch_pos( tdat& dat, tsenses& senses, WNGraph& g, bool inplace, const std::vector<const Synset*>& order,
+						  const std::map<std::string, const Synset*>& edits, std::map<std::string,std::string>& inv,
+						  PatchCounts& counts, std::set<std::string>& literals)
+{
+	typedef std::map<std::string, const Synset*> tedits;
+
+	// the inverse relations the other synsets made to the synsets of the patch: the inverted relations of the old
+	// synsets made by synsets not in the patch (the ones in it make theirs again below), and for added synsets the
+	// inverses of the relations already pointing at them, found through the reverse edges of the graph
+	// (the graph points into the synsets, so this is done before changing them); both in the order of the ids
+	// of their sources, as _inv_rel_pos() makes them
+	std::map<std::string, Synset::tPtrVect> kept;
+	for (tedits::const_iterator e=edits.begin(); e!=edits.end(); e++) {
+		tdat::const_iterator old = dat.find( e->first);
+		if (is_deletion( *e->second)) {
+			// relations of the other synsets left pointing at it (as when loading a file with them)
+			WNGraph::tnode n = g.find( e->first);
+			std::set<std::string> srcids;
+			for (unsigned rel=0; n!=WNGraph::npos && old!=dat.end() && rel!=g.relationCount(); rel++) {
+				WNGraph::Targets src = g.sources( rel, n);
+				for (const WNGraph::tnode* s=src.first; s!=src.last; s++)
+					if (*s != n && edits.find( g.id( *s)) == edits.end())
+						srcids.insert( g.id( *s));
+			}
+			for (std::set<std::string>::const_iterator sid=srcids.begin(); sid!=srcids.end(); sid++) {
+				tdat::const_iterator st = dat.find( *sid);
+				if (st == dat.end())
+					continue;
+				const Synset& src = st->second;
+				for (size_t i=0; i!=src.ilrs.size() - src.inverted; i++)
+					if (src.ilrs[i].first == e->first) {
+						std::ostringstream os;
+						os  << "Warning W03: synset " << e->first << " is missing ('" << src.ilrs[i].second << "' target from synset " << *sid << ")";
+						m_logger.addLog( os.str(), 3);
+						m_stats.m_counts.warnings[2]++;
+					}
+			}
+			continue;
+		}
+		if (old != dat.end()) {
+			const Synset::tPtrVect& ilrs = old->second.ilrs;
+			for (size_t i=ilrs.size() - old->second.inverted; i!=ilrs.size(); i++)
+				if (edits.find( ilrs[i].first) == edits.end())
+					kept[e->first].push_back( ilrs[i]);
+			continue;
+		}
+		WNGraph::tnode n = g.find( e->first);
+		if (n == WNGraph::npos)
+			continue;
+		std::set<std::string> srcids;
+		for (unsigned rel=0; rel!=g.relationCount(); rel++) {
+			if (inv.find( g.relationName( rel)) == inv.end())
+				continue;
+			WNGraph::Targets src = g.sources( rel, n);
+			for (const WNGraph::tnode* s=src.first; s!=src.last; s++)
+				if (*s != n && edits.find( g.id( *s)) == edits.end())
+					srcids.insert( g.id( *s));
+		}
+		for (std::set<std::string>::const_iterator sid=srcids.begin(); sid!=srcids.end(); sid++) {
+			tdat::const_iterator st = dat.find( *sid);
+			if (st == dat.end())
+				continue;
+			const Synset& src = st->second;
+			for (size_t i=0; i!=src.ilrs.size() - src.inverted; i++) {
+				std::map<std::string,std::string>::iterator invr = inv.find( src.ilrs[i].second);
+				if (src.ilrs[i].first == e->first && invr != inv.end())
+					kept[e->first].push_back( std::make_pair( *sid, invr->second));
+			}
+		}
+	}
+
+	// the literals whose senses change (the trie holds their numbers of senses), and the old synsets out of the graph
+	// (its literal index points into them)
+	for (tedits::const_iterator e=edits.begin(); e!=edits.end(); e++) {
+		tdat::const_iterator old = dat.find( e->first);
+		if (old != dat.end() && !is_deletion( *e->second) && same_literals( old->second, *e->second))
+			continue;
+		for (size_t i=0; old!=dat.end() && i!=old->second.synonyms.size(); i++)
+			literals.insert( old->second.synonyms[i].literal);
+		for (size_t i=0; i!=e->second->synonyms.size(); i++)
+			literals.insert( e->second->synonyms[i].literal);
+	}
+	if (inplace)
+		for (tedits::const_iterator e=edits.begin(); e!=edits.end(); e++)
+			g.detach( e->first, is_deletion( *e->second));
+
+	// the word senses of the old synsets out (they point into them), with the places of the modified ones
+	std::map<const std::string*, bool> oldids; // -> deleted
+	for (tedits::const_iterator e=edits.begin(); e!=edits.end(); e++) {
+		tdat::const_iterator old = dat.find( e->first);
+		if (old != dat.end())
+			oldids.insert( std::make_pair( &old->first, is_deletion( *e->second)));
+	}
+	std::vector< std::pair<size_t, const std::string*> > places; // (position among the senses left, id)
+	size_t nsenses = 0;
+	for (size_t i=0; i!=senses.size(); i++) {
+		std::map<const std::string*, bool>::const_iterator o = oldids.find( senses[i].id);
+		if (o == oldids.end())
+			senses[nsenses++] = senses[i];
+		else if (!o->second && (places.empty() || places.back().second != o->first))
+			places.push_back( std::make_pair( nsenses, o->first));
+	}
+	senses.resize( nsenses);
+
+	// remove the old synsets, with the inverse relations made from the relations they stated
+	// (the synsets of the patch get all of theirs again below)
+	std::set<std::string> touched; // synsets not in the patch whose inverse relations change
+	for (tedits::const_iterator e=edits.begin(); e!=edits.end(); e++) {
+		tdat::iterator old = dat.find( e->first);
+		if (old == dat.end()) {
+			if (is_deletion( *e->second)) {
+				std::ostringstream os;
+				os << "Warning W05: synset to delete (" << e->first << ") not found";
+				m_logger.addLog( os.str(), 3);
+				m_stats.m_counts.warnings[4]++;
+			}
+			continue;
+		}
+		const Synset::tPtrVect& ilrs = old->second.ilrs;
+		const size_t nstated = ilrs.size() - old->second.inverted;
+		for (size_t i=0; i!=nstated; i++) {
+			std::map<std::string,std::string>::iterator invr = inv.find( ilrs[i].second);
+			if (invr == inv.end() || ilrs[i].first == e->first || edits.find( ilrs[i].first) != edits.end())
+				continue;
+			tdat::iterator tt = dat.find( ilrs[i].first);
+			if (tt != dat.end() && remove_inverted( tt->second, e->first, invr->second)) {
+				m_stats.m_counts.inverted--;
+				touched.insert( tt->first);
+			}
+		}
+		m_stats.m_counts.relations -= nstated;
+		m_stats.m_counts.inverted -= old->second.inverted;
+		if (is_deletion( *e->second)) {
+			dat.erase( old);
+			m_stats.m_counts.synsets--;
+			counts.deleted++;
+		}
+		else
+			counts.modified++;
+	}
+
+	// store the new synsets, with the inverse relations kept
+	for (tedits::const_iterator e=edits.begin(); e!=edits.end(); e++) {
+		if (is_deletion( *e->second))
+			continue;
+		tdat::iterator it = dat.insert( std::make_pair( e->first, Synset())).first;
+		Synset& syns = it->second;
+		if (syns.empty()) {
+			m_stats.m_counts.synsets++;
+			counts.added++;
+		}
+		syns = *e->second;
+		m_stats.m_counts.relations += syns.ilrs.size();
+		const Synset::tPtrVect& k = kept[e->first];
+		syns.ilrs.insert( syns.ilrs.end(), k.begin(), k.end());
+		syns.inverted += k.size();
+		m_stats.m_counts.inverted += k.size();
+	}
+
+	// the inverse relations made from the relations of the new synsets
+	for (tedits::const_iterator e=edits.begin(); e!=edits.end(); e++) {
+		const Synset::tPtrVect& ilrs = e->second->ilrs;
+		for (size_t i=0; i!=ilrs.size(); i++) {
+			std::map<std::string,std::string>::iterator invr = inv.find( ilrs[i].second);
+			if (invr == inv.end())
+				continue;
+			tdat::iterator tt = dat.find( ilrs[i].first);
+			if (tt == dat.end()) {
+				std::ostringstream os;
+				os  << "Warning W03: synset " << ilrs[i].first << " is missing ('" << invr->first << "' target from synset " << e->first << ")";
+				m_logger.addLog( os.str(), 3);
+				m_stats.m_counts.warnings[2]++;
+			}
+			else if (tt->first == e->first) {
+				std::ostringstream os;
+				os  << "Warning W04: self-referencing relation '" << invr->second << "' for synset "  << e->first;
+				m_logger.addLog( os.str(), 3);
+				m_stats.m_counts.warnings[3]++;
+			}
+			else {
+				insert_inverted( tt->second, e->first, invr->second);
+				m_stats.m_counts.inverted++;
+				if (edits.find( tt->first) == edits.end())
+					touched.insert( tt->first);
+			}
+		}
+	}
+
+	// word senses as in a file with the patch applied: the ones of the modified synsets where they were, the ones of
+	// the added synsets (and of the ones that had none) at the end, in the order of the patch
+	tsenses merged;
+	merged.reserve( senses.size() + places.size());
+	for (size_t i=0, j=0; i<=senses.size(); i++) {
+		for (; j!=places.size() && places[j].first == i; j++)
+			add_senses( *places[j].second, dat.find( *places[j].second)->second, merged);
+		if (i != senses.size())
+			merged.push_back( senses[i]);
+	}
+	std::set<const std::string*> placed;
+	for (size_t j=0; j!=places.size(); j++)
+		placed.insert( places[j].second);
+	for (size_t i=0; i!=order.size(); i++) {
+		tdat::iterator it = dat.find( order[i]->id);
+		if (it != dat.end() && placed.find( &it->first) == placed.end())
+			add_senses( it->first, it->second, merged);
+	}
+	senses.swap( merged);
+
+	// the graph: the synsets of the patch (their new senses ranked in the same order), then the targets of their relations
+	if (inplace) {
+		for (size_t i=0; i!=order.size(); i++) {
+			tdat::iterator it = dat.find( order[i]->id);
+			if (it != dat.end())
+				g.update( it->first, it->second);
+		}
+		for (std::set<std::string>::const_iterator id=touched.begin(); id!=touched.end(); id++) {
+			tdat::iterator it = dat.find( *id);
+			g.update( it->first, it->second);
+		}
+	}
+}
+
+
+const Synset* WNQuery::findID( const char* id, size_t idlen, const std::string& pos) const
+{
+	const WNGraph& g = graph( pos);
+	WNGraph::tnode n = g.find( id, idlen);
+	return n == WNGraph::npos ? NULL : g.synset( n);
+}
+
+
+WNQuery::LiteralMatches WNQuery::findLiteral( const char* literal, size_t literallen, const std::string& pos) const
+{
+	const WNGraph& g = graph( pos);
+	return LiteralMatches( &g, g.senses( literal, literallen));
+}
+
+
+WNQuery::LiteralMatches WNQuery::findLiteral( const std::string& literal, const std::string& pos) const
+{
+	return findLiteral( literal.data(), literal.size(), pos);
+}
+
+
+WNQuery::LiteralMatches WNQuery::findLiteral( const char* literal, const std::string& pos) const
+{
+	return findLiteral( literal, strlen( literal), pos);
+}
+
+
+
+const Synset* WNQuery::findSense( const std::string& literal, const int sensenum, const std::string& pos) const
+{
+	LiteralMatches m = findLiteral( literal, pos);
+	for (LiteralMatches::const_iterator it=m.begin(); it!=m.end(); it++) {
+		for (size_t j=0; j!=it->synonyms.size(); j++) {
+			if (it->synonyms[j].literal == literal && atoi(it->synonyms[j].sense.c_str()) == sensenum)
+				return &*it;
+		}
+	}
+	return NULL;
+}
+
+
+bool WNQuery::lookUpID( const std::string& id, const std::string& pos, Synset& syns) const
+{
+	WNStats::Timer timer( m_stats, WNStats::LookUpID);
+	const Synset* s = findID( id, pos);
+	if (s == NULL) {
+		syns.clear();
+		return false;
+	}
+	else {
+		syns = *s;
+		return true;
+	}
+}
+
+
+bool WNQuery::lookUpLiteral( const std::string& literal, const std::string& pos, std::vector<Synset>& res) const
+{
+	WNStats::Timer timer( m_stats, WNStats::LookUpLiteral);
+	res.clear();
+	LiteralMatches m = findLiteral( literal, pos);
+	if (m.empty())
+		return false;
+	res.reserve( m.size());
+	for (LiteralMatches::const_iterator it=m.begin(); it!=m.end(); it++)
+		res.push_back( *it);
+	return true;
+}
+
+
+bool WNQuery::lookUpLiteral( const std::string& literal, const std::string& pos, std::vector<std::string>& res) const
+{
+	WNStats::Timer timer( m_stats, WNStats::LookUpLiteral);
+	literal_ids( literal, pos, res);
+	return !res.empty();
+}
+
+
+void WNQuery::literal_ids( const std::string& literal, const std::string& pos, std::vector<std::string>& res) const
+{
+	res.clear();
+	LiteralMatches m = findLiteral( literal, pos);
+	for (LiteralMatches::const_iterator it=m.begin(); it!=m.end(); it++)
+		res.push_back( it.id());
+}
+
+
+bool WNQuery::lookUpSense( const std::string& literal, const int sensenum, const std::string& pos, Synset& syns) const
+{
+	WNStats::Timer timer( m_stats, WNStats::LookUpSense);
+	const Synset* s = findSense( literal, sensenum, pos);
+	if (s == NULL) {
+		syns.clear();
+		return false;
+	}
+	syns = *s;
+	return true;
+}
+
+
+void WNQuery::lookUpRelation( const std::string& id, const std::string& pos, const std::string& relation, std::vector<std::string>& targetIDs) const throw(InvalidPOSException)
+{
+	WNStats::Timer timer( m_stats, WNStats::LookUpRelation);
+	targetIDs.clear();
+	// look up current synset
+	const WNGraph& g = graph( pos);
+	WNGraph::tnode n = g.find( id);
+	if (n == WNGraph::npos) // not found
+		return;
+	// get relation targets
+	WNGraph::Targets t = g.targets( g.relation( relation), n);
+	for (const WNGraph::tnode* p=t.first; p!=t.last; p++)
+		targetIDs.push_back( g.id( *p));
+}
+
+
+void WNQuery::traceRelation( const std::string& id, const std::string& pos, const std::string& relation, std::vector<std::string>& result, int maxDepth) const
+{
+	WNStats::Timer timer( m_stats, WNStats::TraceRelation);
+	result.clear();
+	const WNGraph& g = graph( pos);
+	WNGraph::tnode n = g.find( id);
+	if (n == WNGraph::npos) // not found
+		return;
+	unsigned rel = g.relation( relation);
+	GraphWalker w( g, rel, n, GraphWalker::VisitOnce, maxDepth);
+	int depth;
+	while (w.next( n, depth))
+		if (!g.targets( rel, n).empty()) // save synsets having children
+			result.push_back( g.id( n));
+}
+
+
+void WNQuery::traceRelationOS( const std::string& id, const std::string& pos, const std::string& relation, std::ostream& os, int maxDepth) const
+{
+	WNStats::Timer timer( m_stats, WNStats::TraceRelation);
+	const WNGraph& g = graph( pos);
+	WNGraph::tnode n = g.find( id);
+	if (n == WNGraph::npos) // not found
+		return;
+	unsigned rel = g.relation( relation);
+	GraphWalker w( g, rel, n, GraphWalker::VisitTree, maxDepth);
+	int lev;
+	while (w.next( n, lev)) {
+		const Synset* syns = g.synset( n);
+		if (syns == NULL) // missing target
+			continue;
+		// print current synset
+		for (int i=0; i<lev; i++) os << "  "; // indent
+		os << syns->id << "  {";
+		for (size_t i=0; i!=syns->synonyms.size(); i++) {
+			os << syns->synonyms[i].literal << ":" << syns->synonyms[i].sense;
+			if (i != syns->synonyms.size()-1)
+				os << ", ";
+		}
+		os << "}  (" << syns->def << ")";
+		if (w.repeated() && !g.targets( rel, n).empty()) // the synsets under it were printed above
+			os << "  ...";
+		os << "\n";
+	}
+}
+
+
+bool WNQuery::isIDConnectedWith( const std::string& id, const std::string& pos, const std::string& relation, const std::set<std::string>& target_ids,  std::string& foundTargetID, int maxDepth) const
+{
+	WNStats::Timer timer( m_stats, WNStats::IsIDConnectedWith);
+	return id_connected_with( id, pos, relation, target_ids, foundTargetID, maxDepth);
+}
+
+
+bool WNQuery::id_connected_with( const std::string& id, const std::string& pos, const std::string& relation, const std::set<std::string>& target_ids,  std::string& foundTargetID, int maxDepth) const
+{
+	foundTargetID = "";
+	const WNGraph& g = graph( pos);
+	// check if starting synset is any of the searched ids (it may not even exist)
+	if (target_ids.count( id) != 0) {
+		foundTargetID = id;
+		return true;
+	}
+	WNGraph::tnode n = g.find( id);
+	if (n == WNGraph::npos)
+		return false;
+	// search for the nodes of the targets (those not in the graph can't be reached)
+	std::vector<WNGraph::tnode> targets;
+	for (std::set<std::string>::const_iterator it=target_ids.begin(); it!=target_ids.end(); it++) {
+		WNGraph::tnode t = g.find( *it);
+		if (t != WNGraph::npos)
+			targets.push_back( t);
+	}
+	std::sort( targets.begin(), targets.end());
+	unsigned rel = g.relation( relation);
+	if (maxDepth < 0) {
+		// check targets with the reachability index; only if several are reachable is the walk
+		// needed, to return the one found first
+		const IntervalIndex& reach = g.intervalIndex( rel);
+		size_t nfound = 0;
+		WNGraph::tnode found = WNGraph::npos;
+		for (size_t i=0; i!=targets.size(); i++)
+			if (reach.reaches( n, targets[i])) {
+				nfound++;
+				found = targets[i];
+			}
+		if (nfound == 0)
+			return false;
+		if (nfound == 1) {
+			foundTargetID = g.id( found);
+			return true;
+		}
+	}
+	// check if any synset on the paths is any of the searched ones
+	GraphWalker w( g, rel, n, GraphWalker::VisitOnce, maxDepth);
+	int depth;
+	while (w.next( n, depth))
+		if (std::binary_search( targets.begin(), targets.end(), n)) { // found it
+			foundTargetID = g.id( n);
+			return true;
+		}
+	return false;
+}
+
+
+bool WNQuery::isLiteralConnectedWith( const std::string& literal, const std::string& pos, const std::string& relation, const std::set<std::string>& targ_ids, std::string& foundID, std::string& foundTargetID) const
+{
+	WNStats::Timer timer( m_stats, WNStats::IsLiteralConnectedWith);
+	foundID = "";
+	foundTargetID = "";
+	std::vector<std::string> ids;
+	literal_ids( literal, pos, ids);
+	for (size_t i=0; i!=ids.size(); i++)
+		if (id_connected_with( ids[i], pos, relation, targ_ids, foundTargetID, -1)) {
+			foundID = ids[i];
+			return true;
+		}
+	return false;
+}
+
+
+bool WNQuery::isLiteralCompatibleWithSynset( const std::string& literal, const std::string& pos, const std::string id, bool hyponyms) const
+{
+	WNStats::Timer timer( m_stats, WNStats::IsLiteralCompatibleWithSynset);
+	return literal_compatible( literal, pos, id, hyponyms);
+}
+
+
+bool WNQuery::literal_compatible( const std::string& literal, const std::string& pos, const std::string& id, bool hyponyms) const
+{
+	const WNGraph& g = graph( pos);
+	WNGraph::tnode n = g.find( id);
+	if (n == WNGraph::npos)
+		return false;
+	if (hyponyms) {
+		// check if any sense of literal is the synset or one of its hyponyms
+		const IntervalIndex& reach = g.intervalIndex( g.relation( "hyponym"));
+		WNGraph::Targets senses = g.senses( literal);
+		for (const WNGraph::tnode* p=senses.first; p!=senses.last; p++)
+			if (reach.reaches( n, *p))
+				return true;
+		return false;
+	}
+	// check if synset contains literal
+	const Synset* syns = g.synset( n);
+	if (syns == NULL)
+		return false;
+	for (size_t i=0; i!=syns->synonyms.size(); i++)
+		if (syns->synonyms[i].literal == literal)
+			return true;
+	return false;
+}
+
+
+bool WNQuery::areSynonyms(	const std::string& literal1, 
+							const std::string& literal2,
+							const std::string& pos,
+							std::string& synsetid
+						)  const
+{
+	WNStats::Timer timer( m_stats, WNStats::AreSynonyms);
+	synsetid = "";
+
+	// get senses of input word1
+	std::vector<std::string> senses1;
+	literal_ids( literal1, pos, senses1);
+
+	// for each sense, check if it contains word2
+	for (size_t i=0; i<senses1.size(); i++)
+		if ( literal_compatible( literal2, pos, senses1[i], false)) {
+			synsetid = senses1[i];
+			return true;
+		}
+
+	// no common synset
+	return false;
+}
+
+
+void WNQuery::completeLiteral(	const std::string& prefix,
+								const std::string& pos,
+								size_t k,
+								tCompletions& results) const
+{
+	WNStats::Timer timer( m_stats, WNStats::CompleteLiteral);
+	results.clear();
+	int p = trie_pos( pos);
+	std::vector<unsigned> lits;
+	m_trie.complete( prefix.data(), prefix.size(), p, k, lits);
+	results.reserve( lits.size());
+	for (size_t i=0; i!=lits.size(); i++)
+		results.push_back( std::make_pair( std::string( m_trie.literal( lits[i]), m_trie.length( lits[i])), m_trie.senses( lits[i], p)));
+}
+
+
+void WNQuery::completeLiteralSynsets(	const std::string& prefix,
+										const std::string& pos,
+										size_t k,
+										std::vector< std::pair<std::string, std::string> >& results) const
+{
+	WNStats::Timer timer( m_stats, WNStats::CompleteLiteral);
+	results.clear();
+	int p = trie_pos( pos);
+	// (every literal has at least one sense, so k literals are enough)
+	std::vector<unsigned> lits;
+	m_trie.complete( prefix.data(), prefix.size(), p, k, lits);
+	std::set< std::pair<std::string, std::string> > seen;
+	for (size_t i=0; i!=lits.size() && results.size()<k; i++) {
+		for (int q=0; q!=4 && results.size()<k; q++) {
+			if ((p >= 0 && q != p) || m_trie.senses( lits[i], q) == 0)
+				continue;
+			std::string qpos( 1, TriePosNames[q]);
+			LiteralMatches m = findLiteral( m_trie.literal( lits[i]), m_trie.length( lits[i]), qpos);
+			for (LiteralMatches::const_iterator it=m.begin(); it!=m.end() && results.size()<k; it++)
+				if (seen.insert( std::make_pair( qpos, it.id())).second)
+					results.push_back( std::make_pair( qpos, it.id()));
+		}
+	}
+}
+
+
+void WNQuery::fuzzyLookUpLiteral(	const std::string& literal,
+									const std::string& pos,
+									unsigned maxDistance,
+									size_t k,
+									tFuzzyMatches& results) const
+{
+	WNStats::Timer timer( m_stats, WNStats::FuzzyLookUpLiteral);
+	results.clear();
+	std::vector< std::pair<unsigned, unsigned> > lits;
+	m_trie.approximate( literal.data(), literal.size(), maxDistance, trie_pos( pos), k, lits);
+	results.reserve( lits.size());
+	for (size_t i=0; i!=lits.size(); i++)
+		results.push_back( std::make_pair( std::string( m_trie.literal( lits[i].first), m_trie.length( lits[i].first)), lits[i].second));
+}
+
+
+const FoldedIndex& WNQuery::foldedIndex() const
+{
+	// double-checked: only the thread that builds the index takes the lock
+	FoldedIndex* f = m_folded.load( std::memory_order_acquire);
+	if (f == NULL) {
+		std::lock_guard<std::mutex> lock( m_mutex);
+		f = m_folded.load( std::memory_order_relaxed);
+		if (f == NULL) {
+			f = new FoldedIndex( m_trie, m_encoding);
+			m_folded.store( f, std::memory_order_release);
+		}
+	}
+	return *f;
+}
+
+
+void WNQuery::findFoldedLiterals( const std::string& literal, const std::string& pos, std::vector<std::string>& literals) const
+{
+	literals.clear();
+	int p = trie_pos( pos);
+	FoldedIndex::Literals lits = foldedIndex().find( literal.data(), literal.size());
+	for (const unsigned* l=lits.first; l!=lits.second; l++)
+		if (m_trie.senses( *l, p) != 0)
+			literals.push_back( std::string( m_trie.literal( *l), m_trie.length( *l)));
+}
+
+
+bool WNQuery::lookUpLiteralFolded( const std::string& literal, const std::string& pos, std::vector<Synset>& results) const
+{
+	WNStats::Timer timer( m_stats, WNStats::LookUpLiteralFolded);
+	results.clear();
+	int p = trie_pos( pos);
+	if (p < 0)
+		ML_THROW_EXC("Invalid POS '" << pos << "'", InvalidPOSException);
+	FoldedIndex::Literals lits = foldedIndex().find( literal.data(), literal.size());
+	std::set<std::string> seen;
+	for (const unsigned* l=lits.first; l!=lits.second; l++) {
+		if (m_trie.senses( *l, p) == 0)
+			continue;
+		LiteralMatches m = findLiteral( m_trie.literal( *l), m_trie.length( *l), pos);
+		for (LiteralMatches::const_iterator it=m.begin(); it!=m.end(); it++)
+			if (seen.insert( it.id()).second)
+				results.push_back( *it);
+	}
+	return !results.empty();
+}
+
+
+void WNQuery::writeStats( std::ostream& os) const
+{
+	os << "PoS       \t#synsets\t#word senses\n";
+	os << "Nouns     \t" << std::setw(8) << int(dat("n").size()) << "\t" << std::setw(11) << int(senses("n").size()) << std::endl;
+	os << "Verbs     \t" << std::setw(8) << int(dat("v").size()) << "\t" << std::setw(11) << int(senses("v").size()) << std::endl;
+	os << "Adjectives\t" << std::setw(8) << int(dat("a").size()) << "\t" << std::setw(11) << int(senses("a").size()) << std::endl;
+	os << "Adverbs   \t" << std::setw(8) << int(dat("b").size()) << "\t" << std::setw(11) <<  int(senses("b").size()) << std::endl;
+}
+
+
+const WNQuery::tdat& WNQuery::dat( const std::string& pos) const
+{
+	if (pos == "n")
+		return m_ndat;
+	else if (pos == "v")
+		return m_vdat;
+	else if (pos == "a")
+		return m_adat;
+	else if (pos == "b")
+		return m_bdat;
+	else {
+		ML_THROW_EXC("Invalid POS '" << pos << "'", InvalidPOSException);
+	}
+}
+
+
+const WNGraph&	WNQuery::graph( const std::string& pos) const
+{
+	if (pos == "n")
+		return m_ngraph;
+	else if (pos == "v")
+		return m_vgraph;
+	else if (pos == "a")
+		return m_agraph;
+	else if (pos == "b")
+		return m_bgraph;
+	else {
+		ML_THROW_EXC("Invalid POS '" << pos << "'", InvalidPOSException);
+	}
+}
+
+
+const WNQuery::tidx&	WNQuery::idx( const std::string& pos) const
+{
+	if (pos.empty()) {
+		ML_THROW_EXC("Invalid POS '" << pos << "'", InvalidPOSException);
+	}
+	int p = trie_pos( pos);
+	std::lock_guard<std::mutex> lock( m_mutex);
+	if (m_idx[p].get() == NULL) {
+		// inserting at end() keeps the order of equal keys
+		const tsenses& s = senses( pos);
+		m_idx[p].reset( new tidx());
+		for (size_t i=0; i!=s.size(); i++)
+			m_idx[p]->insert( m_idx[p]->end(), std::make_pair( *s[i].literal, *s[i].id));
+	}
+	return *m_idx[p];
+}
+
+
+WNQuery::tdat&	WNQuery::_dat( const std::string& pos)
+{
+	return const_cast<tdat&>( static_cast<const WNQuery*>( this)->dat( pos));
+}
+
+
+WNQuery::tsenses&	WNQuery::_senses( const std::string& pos)
+{
+	return const_cast<tsenses&>( static_cast<const WNQuery*>( this)->senses( pos));
+}
+
+
+WNGraph&	WNQuery::_graph( const std::string& pos)
+{
+	return const_cast<WNGraph&>( static_cast<const WNQuery*>( this)->graph( pos));
+}
+
+
+const WNQuery::tsenses&	WNQuery::senses( const std::string& pos) const
+{
+	if (pos == "n")
+		return m_nsenses;
+	else if (pos == "v")
+		return m_vsenses;
+	else if (pos == "a")
+		return m_asenses;
+	else if (pos == "b")
+		return m_bsenses;
+	else {
+		ML_THROW_EXC("Invalid POS '" << pos << "'", InvalidPOSException);
+	}
+}
+
+} // namespace LibWNXML {
@@ -1,245 +1,682 @@
-#ifndef __WNQUERY_H__
-#define __WNQUERY_H__
-
-#ifdef _MSC_VER
-#pragma warning( disable : 4290 )
-#endif // #ifdef _MSC_VER
-
-#include <iosfwd>
-#include <math.h>
-#include <map>
-#include <set>
-#include <string>
-#include "../MLUtils/Exception.h"
-#include "../MLUtils/Multilog.h"
-
-#include "Synset.h"
-
-namespace LibWNXML {
-
-/// Exception for errors (during initialization, query, ...).
-ML_EXCEPTION( WNQueryException);
-/// To indicate invalid part-of-speech.
-ML_EXCEPTION( InvalidPOSException);
-
-/// Constants for the Leacock-Chodorow similarity measure
-const int LeaCho_D = 20; ///< longest possible path from root to a node in WN
-const double LeaCho_synonym = - log10( 1.0 / (2.0 * LeaCho_D)); ///< similarity score for synonyms (maximum possible similarity value), equals to approx. 1.60206 when D=20
-const double LeaCho_noconnect = - 1.0; ///< similarity score for literals with no possible connecting path in WN (when similarity score is calculated with addArtificialTop = false option, see function header)
-
-/// Class for querying WordNet, read from VisDic XML file
-/// Character encoding of all results is ISO-8859-2 (Latin-2)
-class WNQuery
-{
-public:
-
-	/// Constructor. Create the object: read XML file, create internal indices, invert invertable relations etc.
-	/// @param wnxmlfilename file name of VisDic XML file holding the WordNet you want to query
-	/// @param logger ML::MultiLog for writing warnings (e.g. invalid POS etc.) to while loading. The default value creates a logger to stderr.
-	/// The following warnings may be produced:
-	/// Warning W01: synset with id already exists 
-	/// Warning W02: invalid PoS for synset (NOTE: these synsets are omitted)
-	/// Warning W03: synset is missing (the target synset, when checking when inverting relations)
-	/// Warning W04: self-referencing relation in synset
-	/// @exception WNQueryException thrown if input parsing error occurs
-	WNQuery( const std::string& wnxmlfilename, ML::MultiLog& logger )	throw(WNQueryException);
-
-	/// Get synset with given id.
-	/// @param id synset id to look up
-	/// @param pos POS of synset
-	/// @param syns the result synset. Empty if no synset found.
-	/// @return true if synset was found, false otherwise
-	/// @exception InvalidPOSException for invalid POS
-	bool lookUpID( const std::string& id, const std::string& pos, Synset& syns)	const throw(InvalidPOSException);
-
-	/// Get synsets containing given literal in given POS.
-	/// @param literal to look up (all senses)
-	/// @param pos POS of literal
-	/// @param results contains the Synsets with the id, empty if not found
-	/// @return true if liteal was found, false otherwise
-	/// @exception InvalidPOSException for invalid POS
-	bool lookUpLiteral( const std::string& literal, const std::string& pos, std::vector<Synset>& results) const throw(InvalidPOSException);
-
-	/// Get ids of synsets containing given literal in given POS.
-	bool lookUpLiteral( const std::string& literal, const std::string& pos, std::vector<std::string>& results) const throw(InvalidPOSException);
-
-	/// Get synset containing word sense (literal with given sense number) in given POS.
-	/// @param literal to look up
-	/// @param sensenum sense number of literal
-	/// @param pos POS of literal
-	/// @param syns the synset containing the word sense, empty if not found
-	/// @return true if word sense was found, false otherwise
-	/// @exception InvalidPOSException for invalid POS
-	bool lookUpSense( const std::string& literal, const int sensenum, const std::string& pos, Synset& syns) const throw(InvalidPOSException);
-
-	/// Get IDs of synsets reachable from synset by relation
-	/// @param id synset id to look relation from
-	/// @param pos POS of starting synset
-	/// @param relation name of relation to look up
-	/// @param targetIDs ids of synsets found go here (empty if starting synset was not found, or if no relation was found from it)
-	/// @exception InvalidPOSException for invalid POS
-	void lookUpRelation( const std::string& id, const std::string& pos, const std::string& relation, std::vector<std::string>& targetIDs) const throw(InvalidPOSException);
-	
-	/// Do a recursive trace from the given synset along the given relation.
-	/// @param id id of synset to start from
-	/// @param pos POS of search
-	/// @param relation name of relation to trace
-	/// @param result holds the ids of synsets found on the trace. It's empty if starting synset is not found, otherwise always holds at least the starting synset (so if starting synset has no relations of the searched type, result will only hold that synset)
-	/// @exception InvalidPOSException for invalid POS
-	void traceRelation( const std::string& id, const std::string& pos, const std::string& relation, std::vector<std::string>& result) const throw(InvalidPOSException);
-
-	/// Like TraceRelation, but output goes to output stream with pretty formatting.
-	void traceRelationOS( const std::string& id, const std::string& pos, const std::string& relation, std::ostream& os) const throw(InvalidPOSException);
-
-	/// Check if synset is connected with any of the given synsets on paths defined by relation starting from synset.
-	bool isIDConnectedWith( const std::string& id, const std::string& pos, const std::string& relation, const std::set<std::string>& targetIDs, std::string& foundTargetID) const throw(InvalidPOSException);
-
-	/// Check if any sense of literal in POS is connected with any of the specified synsets on paths defined by relation starting from that sense.
-	bool isLiteralConnectedWith( const std::string& literal, const std::string& pos, const std::string& relation, const std::set<std::string>& targetIDs, std::string& foundID, std::string& foundTargetID) const throw(InvalidPOSException);
-
-	/// Check if literal is in synset, or, if hyponyms is true, is in one of synset's hyponyms (recursive)
-	bool isLiteralCompatibleWithSynset( const std::string& literal, const std::string& pos, const std::string id, bool hyponyms) const  throw(InvalidPOSException);
-
-	/// Calculate Leacock-Chodorow similarity between two words using WN.
-	/// @param literal1, literal2 the two input words
-	/// @param pos PoS of the words (n,v,a,b)
-	/// @param relation the name of the relation to use for finding connecting paths
-	/// @param addArtificialTop if true, add an artificial top (root) node to ends of relation paths
-	/// so that the whole WN graph will be interconnected. If false, there can literals with zero connections (empty results map, see below).
-	/// @param results the results: for every pair of synset ids of all the senses of the input words, the similarity score,
-	/// or empty if either of the 2 words was not found in WN. For a score, first element of the pair of strings is the id of a sense of literal1,
-	/// second element is the id of a sense of literal 2. The map is cleared by the function first.
-	/// @exception InvalidPOSException for invalid POS	
-	/// Description of method:
-	/// We first look up all the senses of the 2 input words in the given PoS.
-	/// Then, for every possible pair (s1,s2) we calculate the formula:
-	/// sim(s1,s2) = - log ( length_of_shortest_path( s1, s2, relation) / 2 * D)
-	/// where D is a constant (should be at least as much as the longest path in WN using relation, see .cpp file for values)
-	/// length_of_shortest_path is the number of nodes found in the path connecting s1 and s2 with relation, so
-	/// if s1 = s2, length_of_shortest_path = 1, 
-	/// if s1 is hypernym of s2 (or vice versa), length_of_shortest_path = 2,
-	/// if s1 and s2 are sister nodes (have a common hypernym), length_of_shortest_path = 3, etc.
-	/// Note, when addArtificialTop is true, the formula returns a sim. score of 1.12494 (for path length 3) 
-	/// for invalid relation types (since since the path always contains the starting node, plus the artificial root node).
-	typedef std::map< double, std::pair<std::string,std::string> > tSims;
-	void similarityLeacockChodorow(	const std::string& literal1, 
-									const std::string& literal2,
-									const std::string& pos,
-									const std::string& relation,
-									const bool addArtificialTop,
-									tSims& results) const throw(InvalidPOSException);
-
-	/// Determine if two literals are synonyms in a PoS, also return id of a synset that contains both.
-	/// @param literal1 first word to be checked
-	/// @param literal2 second word to be checked
-	/// @param pos PoS of the words (n,v,a,b)
-	/// @param synsetid if there is a synset in 'pos' that contains both literal1 and literal2, its id is returned here.
-	/// Note, there may be more synsets containing these two words.
-	/// @return true if the two words are synonyms, false otherwise.
-	/// @exception InvalidPOSException for invalid POS
-	bool areSynonyms(	const std::string& literal1, 
-						const std::string& literal2,
-						const std::string& pos,
-						std::string& synsetid
-						)  const throw(InvalidPOSException);
-
-	/// Write statistics about number of synsets, word senses for each POS.
-	/// @param os the output stream to write to
-	void writeStats( std::ostream& os) const;
-
-public:
-
-	/// The following functions give access to the internal representation of
-	/// all the content read from the XML file.
-	/// Use at your own risk.
-
-	/// synset ids to synsets
-	typedef std::map<std::string, LibWNXML::Synset> tdat;
-
-	/// literals to synset ids
-	typedef std::multimap<std::string, std::string> tidx;
-
-	/// Get the appropriate synset-id-to-synset-map for the given POS.
-	/// @param pos part-of-speech: n|v|a|b
-	/// @exception WNQueryException if invalid POS
-	tdat&			dat( const std::string& pos)		throw(WNQueryException);
-	const	tdat&	dat( const std::string& pos) const	throw(WNQueryException);
-
-	/// Get the appropriate literal-to-synset-ids-multimap for the given POS.
-	/// @param pos part-of-speech: n|v|a|b
-	/// @exception WNQueryException if invalid POS
-	tidx&			idx( const std::string& pos)		throw(WNQueryException);
-	const	tidx&	idx( const std::string& pos) const	throw(WNQueryException);
-
-private:
-
-	void _save_synset( Synset& syns, int lcnt);
-	
-	void trace_rel_rec( const std::string& id, const std::string& pos, const std::string& relation, std::vector<std::string>& result) const;
-
-	void trace_rel_os_rec( const std::string& id, const std::string& pos, const std::string& relation, std::ostream& os, int level) const;
-
-	void is_id_connected_with_rec( const std::string& id, const std::string& pos, const std::string& relation, const std::set<std::string>& ancestor_ids, std::string& foundAncestorID) const throw(InvalidPOSException);
-
-	/// Create the inverse pairs of all reflexive relations in all POS.
-	/// Ie. if rel points from s1 to s2, mark inv(rel) from s2 to s1.
-	/// see body of _invRelTable().
-	void invert_relations();
-	void _inv_rel_pos( tdat& pdat, std::map<std::string,std::string>& invtbl);
-	void _invRelTable( std::map<std::string,std::string>& inv)
-	{
-		inv.clear();
-		inv["hypernym"]					= "hyponym";
-		inv["holo_member"]				= "mero_member";
-		inv["holo_part"]				= "mero_part";
-		inv["holo_portion"]				= "mero_portion";
-		inv["region_domain"]			= "region_member";
-		inv["usage_domain"]				= "usage_member";
-		inv["category_domain"]			= "category_member";
-		inv["near_antonym"]				= "near_antonym";
-		inv["middle"]					= "middle";
-		inv["verb_group"]				= "verb_group";
-		inv["similar_to"]				= "similar_to";
-		inv["also_see"]					= "also_see";
-		inv["be_in_state"]				= "be_in_state";
-		inv["eng_derivative"]			= "eng_derivative";
-		inv["is_consequent_state_of"]	= "has_consequent_state";
-		inv["is_preparatory_phase_of"]	= "has_preparatory_phase";
-		inv["is_telos_of"]				= "has_telos";
-		inv["subevent"]					= "has_subevent";
-		inv["causes"]					= "caused_by";
-	}
-
-	double WNQuery::simLeaCho(	const std::string& id1, 
-								const std::string& id2,
-								const std::string& pos,
-								const std::string& relation,
-								const bool addArtificialTop) const;
-
-	void getReach(	const std::string& id,
-					const std::string& pos,
-					const std::string& rel,
-					std::vector< std::pair< std::string, int > >& res,
-					int dist,
-					const bool addArtificialTop) const;
-
-private:
-
-	ML::MultiLog&	m_logger;
-
-	tdat		m_ndat; ///< nouns
-	tdat		m_vdat;
-	tdat		m_adat;
-	tdat		m_bdat;
-
-	tidx		m_nidx; ///< nouns
-	tidx		m_vidx;
-	tidx		m_aidx;
-	tidx		m_bidx;
-
-};
-
-
-} // namespace LibWNXML {
-
-#endif // #ifndef __WNQUERY_H__
+#ifndef __WNQUERY_H__
+#define __WNQUERY_H__
+
+#ifdef _MSC_VER
+#pragma warning( disable : 4290 )
+#endif // #ifdef _MSC_VER
+
+#include <atomic>
+#include <iosfwd>
+#include <iterator>
+#include <math.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include "../MLUtils/Exception.h"
+#include "../MLUtils/Multilog.h"
+
+#include "FoldedIndex.h"
+#include "LiteralTrie.h"
+#include "Synset.h"
+#include "WNGraph.h"
+#include "WNStats.h"
+
+namespace LibWNXML {
+
+/// Exception for errors (during initialization, query, ...).
+ML_EXCEPTION( WNQueryException);
+/// To indicate invalid part-of-speech.
+ML_EXCEPTION( InvalidPOSException);
+
+/// Constants for the Leacock-Chodorow similarity measure
+const int LeaCho_D = 20; ///< longest possible path from root to a node in WN
+const double LeaCho_synonym = - log10( 1.0 / (2.0 * LeaCho_D)); ///< similarity score for synonyms (maximum possible similarity value), equals to approx. 1.60206 when D=20
+const double LeaCho_noconnect = - 1.0; ///< similarity score for literals with no possible connecting path in WN (when similarity score is calculated with addArtificialTop = false option, see function header)
+const double LeaCho_notfound = - 2.0; ///< similarity score in similarity matrices for literals / synsets not found in WN
+
+class ThreadPool;
+
+/// Class for querying WordNet, read from VisDic XML file
+/// Character encoding of all results is the one given at loading (default: ISO-8859-2, Latin-2), see encoding()
+/// The const member functions (all queries) can be called from several threads at the same time
+/// (indices built at first use are built under a lock); changing the content (applyPatch())
+/// must not be done concurrently with anything else.
+class WNQuery
+{
+public:
+
+	/// Constructor. Create the object: read XML file, create internal indices, invert invertable relations etc.
+	/// @param wnxmlfilename file name of VisDic XML file holding the WordNet you want to query
+	/// @param logger ML::MultiLog for writing warnings (e.g. invalid POS etc.) to while loading. The default value creates a logger to stderr.
+	/// @param nthreads number of threads to parse the file with. If more than 1, the file is read into memory,
+	/// split into chunks at SYNSET boundaries, and the chunks are parsed in parallel, each with its own parser.
+	/// Synsets are stored in input order afterwards, so the result and the warnings are the same as with 1 thread.
+	/// 0 means the number of hardware threads.
+	/// @param encoding character encoding of the strings of the loaded WordNet (all query results), e.g. "UTF-8"
+	/// (no conversion is done then). For valid names, see CharConverter/EncodingNames.cpp
+	/// The following warnings may be produced:
+	/// Warning W01: synset with id already exists 
+	/// Warning W02: invalid PoS for synset (NOTE: these synsets are omitted)
+	/// Warning W03: synset is missing (the target synset, when checking when inverting relations)
+	/// Warning W04: self-referencing relation in synset
+	/// @exception WNQueryException thrown if input parsing error occurs, or for an unknown encoding
+	WNQuery( const std::string& wnxmlfilename, ML::MultiLog& logger, unsigned nthreads = 1, const std::string& encoding = "ISO-8859-2")	throw(WNQueryException);
+
+	~WNQuery();
+
+	/// Create the object from a binary snapshot written by saveSnapshot().
+	/// No XML parsing or relation inverting is done: the synsets, the word senses and the literal trie are read
+	/// from the file as they were saved (it is memory-mapped while loading), and the relation graphs and hash
+	/// indices are built from them, as after parsing. So a snapshot is faster to load than the XML, but
+	/// the content is copied out of the file, it's not shared by processes loading the same snapshot.
+	/// @param snapshotfilename file name of snapshot
+	/// @param logger ML::MultiLog for writing messages to
+	/// @exception WNQueryException thrown if the file can't be read, has an unsupported version or a bad checksum
+	static std::auto_ptr<WNQuery> createFromSnapshot( const std::string& snapshotfilename, ML::MultiLog& logger)	throw(WNQueryException);
+
+	/// Write all content (synsets with inverted relations, literal indices) to a versioned, checksummed binary snapshot file,
+	/// which can be loaded with createFromSnapshot().
+	/// @param snapshotfilename file to (over)write
+	/// @exception WNQueryException thrown if file can't be written
+	void saveSnapshot( const std::string& snapshotfilename) const	throw(WNQueryException);
+
+	/// Check if file looks like a snapshot (only its magic number is checked).
+	static bool isSnapshot( const std::string& filename);
+
+	/// Character encoding of all strings (synset content) returned by queries (given at loading, or saved in the snapshot).
+	const std::string& encoding() const
+	{ return m_encoding; }
+
+	/// Get synset with given id.
+	/// @param id synset id to look up
+	/// @param pos POS of synset
+	/// @param syns the result synset. Empty if no synset found.
+	/// @return true if synset was found, false otherwise
+	/// @exception InvalidPOSException for invalid POS
+	bool lookUpID( const std::string& id, const std::string& pos, Synset& syns)	const throw(InvalidPOSException);
+
+	/// Get synsets containing given literal in given POS.
+	/// @param literal to look up (all senses)
+	/// @param pos POS of literal
+	/// @param results contains the Synsets with the id, empty if not found
+	/// @return true if liteal was found, false otherwise
+	/// @exception InvalidPOSException for invalid POS
+	bool lookUpLiteral( const std::string& literal, const std::string& pos, std::vector<Synset>& results) const throw(InvalidPOSException);
+
+	/// Get ids of synsets containing given literal in given POS.
+	bool lookUpLiteral( const std::string& literal, const std::string& pos, std::vector<std::string>& results) const throw(InvalidPOSException);
+
+	/// Non-copying lookups.
+	/// The synsets returned by the find... functions are not copied, they point into this object:
+	/// pointers, ranges and iterators stay valid as long as the WNQuery object exists
+	/// and its content is not changed by applyPatch().
+	/// Ids and literals are looked up in hash tables, they can be given as (pointer, length)
+	/// (or as std::string_view when compiling for C++17), so no std::string has to be built.
+
+	/// Get synset with given id, NULL if not found.
+	/// @exception InvalidPOSException for invalid POS
+	const Synset* findID( const char* id, size_t idlen, const std::string& pos) const throw(InvalidPOSException);
+	const Synset* findID( const std::string& id, const std::string& pos) const throw(InvalidPOSException)
+	{ return findID( id.data(), id.size(), pos); }
+	const Synset* findID( const char* id, const std::string& pos) const throw(InvalidPOSException)
+	{ return findID( id, strlen( id), pos); }
+#ifdef LIBWNXML_STRING_VIEW
+	const Synset* findID( std::string_view id, const std::string& pos) const throw(InvalidPOSException)
+	{ return findID( id.data(), id.size(), pos); }
+#endif
+
+	/// Get synsets containing given literal in given POS (same ones, in the same order as lookUpLiteral()).
+	/// The range is empty if the literal was not found.
+	/// @exception InvalidPOSException for invalid POS
+	class LiteralMatches;
+	LiteralMatches findLiteral( const char* literal, size_t literallen, const std::string& pos) const throw(InvalidPOSException);
+	LiteralMatches findLiteral( const std::string& literal, const std::string& pos) const throw(InvalidPOSException);
+	LiteralMatches findLiteral( const char* literal, const std::string& pos) const throw(InvalidPOSException);
+#ifdef LIBWNXML_STRING_VIEW
+	LiteralMatches findLiteral( std::string_view literal, const std::string& pos) const throw(InvalidPOSException);
+#endif
+
+	/// Get synset containing word sense (literal with given sense number) in given POS, NULL if not found.
+	/// @exception InvalidPOSException for invalid POS
+	const Synset* findSense( const std::string& literal, const int sensenum, const std::string& pos) const throw(InvalidPOSException);
+
+	/// Get synset containing word sense (literal with given sense number) in given POS.
+	/// @param literal to look up
+	/// @param sensenum sense number of literal
+	/// @param pos POS of literal
+	/// @param syns the synset containing the word sense, empty if not found
+	/// @return true if word sense was found, false otherwise
+	/// @exception InvalidPOSException for invalid POS
+	bool lookUpSense( const std::string& literal, const int sensenum, const std::string& pos, Synset& syns) const throw(InvalidPOSException);
+
+	/// Get IDs of synsets reachable from synset by relation
+	/// @param id synset id to look relation from
+	/// @param pos POS of starting synset
+	/// @param relation name of relation to look up
+	/// @param targetIDs ids of synsets found go here (empty if starting synset was not found, or if no relation was found from it)
+	/// @exception InvalidPOSException for invalid POS
+	void lookUpRelation( const std::string& id, const std::string& pos, const std::string& relation, std::vector<std::string>& targetIDs) const throw(InvalidPOSException);
+	
+	/// Do a recursive trace from the given synset along the given relation.
+	/// Relation paths are followed depth-first; every synset is listed once, even if it can be reached on several paths
+	/// (cyclic relations like near_antonym can be traced too).
+	/// @param id id of synset to start from
+	/// @param pos POS of search
+	/// @param relation name of relation to trace
+	/// @param result holds the ids of synsets found on the trace that have relations of the searched type. It's empty if starting synset is not found or has no relations of the searched type.
+	/// @param maxDepth don't follow relation paths longer than this, -1 for no limit
+	/// @exception InvalidPOSException for invalid POS
+	void traceRelation( const std::string& id, const std::string& pos, const std::string& relation, std::vector<std::string>& result, int maxDepth = -1) const throw(InvalidPOSException);
+
+	/// Like TraceRelation, but output goes to output stream with pretty formatting:
+	/// a tree, where synsets reachable on several paths appear under each of them.
+	/// The synsets under a synset are only listed at its first occurrence, later ones are marked with "..."
+	/// (this also cuts paths that would return to a synset already on the path), so the output is at most
+	/// as long as the number of relations reachable, not the number of paths.
+	void traceRelationOS( const std::string& id, const std::string& pos, const std::string& relation, std::ostream& os, int maxDepth = -1) const throw(InvalidPOSException);
+
+	/// Check if synset is connected with any of the given synsets on paths defined by relation starting from synset.
+	/// Paths are searched depth-first, up to maxDepth steps (-1 for no limit), the first target found is returned.
+	/// Without a depth limit, the targets are checked with the reachability index of the relation
+	/// (see WNGraph::intervalIndex()), and paths are only searched if several targets are reachable.
+	bool isIDConnectedWith( const std::string& id, const std::string& pos, const std::string& relation, const std::set<std::string>& targetIDs, std::string& foundTargetID, int maxDepth = -1) const throw(InvalidPOSException);
+
+	/// Check if any sense of literal in POS is connected with any of the specified synsets on paths defined by relation starting from that sense.
+	bool isLiteralConnectedWith( const std::string& literal, const std::string& pos, const std::string& relation, const std::set<std::string>& targetIDs, std::string& foundID, std::string& foundTargetID) const throw(InvalidPOSException);
+
+	/// Check if literal is in synset, or, if hyponyms is true, is in one of synset's hyponyms (recursive).
+	/// The hyponyms are not searched: the senses of literal are checked with the reachability index of "hyponym".
+	bool isLiteralCompatibleWithSynset( const std::string& literal, const std::string& pos, const std::string id, bool hyponyms) const  throw(InvalidPOSException);
+
+	/// Calculate Leacock-Chodorow similarity between two words using WN.
+	/// @param literal1, literal2 the two input words
+	/// @param pos PoS of the words (n,v,a,b)
+	/// @param relation the name of the relation to use for finding connecting paths
+	/// @param addArtificialTop if true, add an artificial top (root) node to ends of relation paths
+	/// so that the whole WN graph will be interconnected. If false, there can literals with zero connections (empty results map, see below).
+	/// @param results the results: for every pair of synset ids of all the senses of the input words, the similarity score,
+	/// or empty if either of the 2 words was not found in WN. For a score, first element of the pair of strings is the id of a sense of literal1,
+	/// second element is the id of a sense of literal 2. The map is cleared by the function first.
+	/// @exception InvalidPOSException for invalid POS	
+	/// Description of method:
+	/// We first look up all the senses of the 2 input words in the given PoS.
+	/// Then, for every possible pair (s1,s2) we calculate the formula:
+	/// sim(s1,s2) = - log ( length_of_shortest_path( s1, s2, relation) / 2 * D)
+	/// where D is a constant (should be at least as much as the longest path in WN using relation, see .cpp file for values)
+	/// length_of_shortest_path is the number of nodes found in the path connecting s1 and s2 with relation, so
+	/// if s1 = s2, length_of_shortest_path = 1, 
+	/// if s1 is hypernym of s2 (or vice versa), length_of_shortest_path = 2,
+	/// if s1 and s2 are sister nodes (have a common hypernym), length_of_shortest_path = 3, etc.
+	/// Note, when addArtificialTop is true, the formula returns a sim. score of 1.12494 (for path length 3) 
+	/// for invalid relation types (since since the path always contains the starting node, plus the artificial root node).
+	typedef std::map< double, std::pair<std::string,std::string> > tSims;
+	void similarityLeacockChodorow(	const std::string& literal1, 
+									const std::string& literal2,
+									const std::string& pos,
+									const std::string& relation,
+									const bool addArtificialTop,
+									tSims& results) const throw(InvalidPOSException);
+
+	/// Calculate Leacock-Chodorow similarity for every pair of words from two lists (see similarityLeacockChodorow()).
+	/// The score of a pair of words is the highest score of their senses (LeaCho_noconnect if there's no connection,
+	/// LeaCho_notfound if either of the words is not found in WN).
+	/// The senses of all words are looked up once, and the synsets reachable from each of them are collected once.
+	/// @param literals1, literals2 the words (the same list can be given twice, for a symmetric matrix)
+	/// @param pos PoS of the words (n,v,a,b)
+	/// @param relation the name of the relation to use for finding connecting paths
+	/// @param addArtificialTop see similarityLeacockChodorow()
+	/// @param results the results: results[i][j] is the score of literals1[i] and literals2[j]
+	/// @param pool threads to compute with, NULL to compute in the calling thread only
+	/// @exception InvalidPOSException for invalid POS
+	typedef std::vector< std::vector<double> > tSimMatrix;
+	void similarityMatrix(	const std::vector<std::string>& literals1,
+							const std::vector<std::string>& literals2,
+							const std::string& pos,
+							const std::string& relation,
+							const bool addArtificialTop,
+							tSimMatrix& results,
+							ThreadPool* pool = NULL) const throw(InvalidPOSException);
+
+	/// Like similarityMatrix(), but for synsets (given by ids) instead of words.
+	void similarityMatrixIDs(	const std::vector<std::string>& ids1,
+								const std::vector<std::string>& ids2,
+								const std::string& pos,
+								const std::string& relation,
+								const bool addArtificialTop,
+								tSimMatrix& results,
+								ThreadPool* pool = NULL) const throw(InvalidPOSException);
+
+	/// Find the synsets most similar to a synset by Leacock-Chodorow similarity (see similarityLeacockChodorow()).
+	/// Instead of scoring every synset of the POS, the search goes outward from the synset: up along the relation
+	/// to the common nodes, then down against it to the other synsets, in the order of the length of the
+	/// connecting path, and stops when the k best synsets are known.
+	/// For repeated queries see NeighborTable, which holds the results precomputed for every synset.
+	/// @param id id of the synset
+	/// @param pos PoS of the synset (n,v,a,b)
+	/// @param relation the name of the relation to use for finding connecting paths
+	/// @param k number of synsets to return (fewer if fewer synsets are connected with it)
+	/// @param addArtificialTop see similarityLeacockChodorow()
+	/// @param results the results: ids of the synsets with their scores (as similarityLeacockChodorow() scores the pair), best first,
+	/// synsets with equal scores in id order. The synset itself and synsets with no connection are not included.
+	/// Empty if the synset was not found. The vector is cleared by the function first.
+	/// @exception InvalidPOSException for invalid POS
+	typedef std::vector< std::pair<std::string, double> > tNeighbors;
+	void nearestNeighbors(	const std::string& id,
+							const std::string& pos,
+							const std::string& relation,
+							size_t k,
+							const bool addArtificialTop,
+							tNeighbors& results) const throw(InvalidPOSException);
+
+	/// Get the literals starting with a prefix (e.g. to complete a word as it's typed), best first:
+	/// the prefix itself if it's a literal, then the others by decreasing number of senses,
+	/// literals with the same number of senses in byte order.
+	/// The literals are looked up in a compact trie (see LiteralTrie), which keeps the highest number of senses
+	/// under each of its nodes, so only the nodes that can hold the best k literals are visited.
+	/// @param prefix beginning of the literals (an empty prefix matches all literals)
+	/// @param pos PoS of the literals (n,v,a,b): only literals with senses in it, ranked by these; empty for all PoS
+	/// @param k maximum number of literals to return
+	/// @param results the literals with their number of senses (in pos, or in all PoS), cleared first
+	/// @exception InvalidPOSException for invalid POS
+	typedef std::vector< std::pair<std::string, unsigned> > tCompletions;
+	void completeLiteral(	const std::string& prefix,
+							const std::string& pos,
+							size_t k,
+							tCompletions& results) const throw(InvalidPOSException);
+
+	/// Like completeLiteral(), but get the synsets of the senses of the best literals (at most k synsets):
+	/// the senses of the best literal first, in PoS order n, v, a, b, and in the order of lookUpLiteral() within a PoS.
+	/// A synset containing several of the literals is listed once.
+	/// @param results (PoS, synset id) pairs, cleared first
+	/// @exception InvalidPOSException for invalid POS
+	void completeLiteralSynsets(	const std::string& prefix,
+									const std::string& pos,
+									size_t k,
+									std::vector< std::pair<std::string, std::string> >& results) const throw(InvalidPOSException);
+
+	/// Get the literals nearest to a (possibly misspelled) word, e.g. to suggest corrections when lookUpLiteral() finds nothing:
+	/// the k literals at the smallest Levenshtein distances from it (number of characters inserted, deleted or replaced),
+	/// at most maxDistance, nearest first, literals at the same distance by decreasing number of senses, then in byte order.
+	/// A dropped accent counts as one replaced character. The distances are of the encoded strings, so of characters
+	/// in single-byte encodings (like the ISO-8859-2 of HuWN), and of bytes in UTF-8.
+	/// The literal trie (see LiteralTrie) is walked with the rows of the distances, so only the branches within maxDistance
+	/// of the prefixes of the word are visited, not the whole vocabulary.
+	/// @param literal the word to look up
+	/// @param pos PoS of the literals (n,v,a,b): only literals with senses in it; empty for all PoS
+	/// @param maxDistance the largest distance allowed (1 or 2 are fast, larger ones visit much of the trie)
+	/// @param k maximum number of literals to return
+	/// @param results the literals with their distances, cleared first (a literal that is found has distance 0)
+	/// @exception InvalidPOSException for invalid POS
+	typedef std::vector< std::pair<std::string, unsigned> > tFuzzyMatches;
+	void fuzzyLookUpLiteral(	const std::string& literal,
+								const std::string& pos,
+								unsigned maxDistance,
+								size_t k,
+								tFuzzyMatches& results) const throw(InvalidPOSException);
+
+	/// Look up a literal ignoring case and accents: get the synsets of all literals whose folded form
+	/// (lowercase, without diacritics, see FoldedIndex) is the same as that of the given one, e.g. the synsets
+	/// of "kutya" for "KUTYA". The literals are taken in byte order, the synsets of each in the order of lookUpLiteral();
+	/// a synset containing several of them is listed once.
+	/// The folded index is built at the first call; applyPatch() inserts the literals it adds (or has it built again at the next call).
+	/// @param literal the word to look up
+	/// @param pos PoS of the synsets (n,v,a,b)
+	/// @param results the synsets found, cleared first
+	/// @return true if any synset was found
+	/// @exception InvalidPOSException for invalid POS
+	bool lookUpLiteralFolded( const std::string& literal, const std::string& pos, std::vector<Synset>& results) const throw(InvalidPOSException);
+
+	/// Get the literals with the same folded form as the given one (see lookUpLiteralFolded()), in byte order.
+	/// @param pos PoS of the literals (n,v,a,b): only literals with senses in it; empty for all PoS
+	/// @param literals the literals found (the given one too, if it's a literal), cleared first
+	/// @exception InvalidPOSException for invalid POS
+	void findFoldedLiterals( const std::string& literal, const std::string& pos, std::vector<std::string>& literals) const throw(InvalidPOSException);
+
+	/// Determine if two literals are synonyms in a PoS, also return id of a synset that contains both.
+	/// @param literal1 first word to be checked
+	/// @param literal2 second word to be checked
+	/// @param pos PoS of the words (n,v,a,b)
+	/// @param synsetid if there is a synset in 'pos' that contains both literal1 and literal2, its id is returned here.
+	/// Note, there may be more synsets containing these two words.
+	/// @return true if the two words are synonyms, false otherwise.
+	/// @exception InvalidPOSException for invalid POS
+	bool areSynonyms(	const std::string& literal1, 
+						const std::string& literal2,
+						const std::string& pos,
+						std::string& synsetid
+						)  const throw(InvalidPOSException);
+
+	/// Write statistics about number of synsets, word senses for each POS.
+	/// @param os the output stream to write to
+	void writeStats( std::ostream& os) const;
+
+public:
+
+	/// The following functions give access to the internal representation of
+	/// all the content read from the XML file.
+	/// Use at your own risk.
+
+	/// synset ids to synsets
+	typedef std::map<std::string, LibWNXML::Synset> tdat;
+
+	/// literals to synset ids
+	typedef std::multimap<std::string, std::string> tidx;
+
+	/// word senses (literals of synsets, pointing into tdat), in the order they were loaded
+	typedef std::vector<WNGraph::Sense> tsenses;
+
+	/// Get the appropriate synset-id-to-synset-map for the given POS.
+	/// It's read-only, since the graphs, the word senses and the trie point into the synsets: to change the content,
+	/// pass the new synsets to applyPatch(), which updates these too.
+	/// (Up to now the map could be modified, and rebuildGraphs() called afterwards. Such code should collect the
+	/// synsets changed or added, and a synset with only the id and the POS for each one deleted, and apply them
+	/// with applyPatch( const std::vector<Synset>&); the inverse relations are made by applyPatch() then.)
+	/// @param pos part-of-speech: n|v|a|b
+	/// @exception WNQueryException if invalid POS
+	const	tdat&	dat( const std::string& pos) const	throw(WNQueryException);
+
+	/// Get the appropriate literal-to-synset-ids-multimap for the given POS.
+	/// The literal index is kept as the list of word senses (see senses()) and the hash index of the graph,
+	/// this multimap is only a copy made from them at the first call (under a lock), and dropped when the content is changed.
+	/// It's read-only: the literal index follows the synonyms of the synsets (see applyPatch()).
+	/// @param pos part-of-speech: n|v|a|b
+	/// @exception WNQueryException if invalid POS
+	const	tidx&	idx( const std::string& pos) const	throw(WNQueryException);
+
+	/// Get the word senses of the given POS, in the order they were loaded (this is the order of the synsets
+	/// returned for a literal).
+	/// @param pos part-of-speech: n|v|a|b
+	/// @exception WNQueryException if invalid POS
+	const	tsenses&	senses( const std::string& pos) const	throw(WNQueryException);
+
+	/// Get the relation graph for the given POS (used by all relation queries).
+	/// @param pos part-of-speech: n|v|a|b
+	/// @exception WNQueryException if invalid POS
+	const	WNGraph&	graph( const std::string& pos) const	throw(WNQueryException);
+
+	/// Get the trie of the literals of all POS (used by completeLiteral()).
+	const	LiteralTrie&	literalTrie() const		{ return m_trie; }
+
+	/// Get the index of the literals by their folded forms (used by lookUpLiteralFolded()), built at the first call
+	/// (later calls take no lock). It is valid until the content is changed (applyPatch()).
+	const	FoldedIndex&	foldedIndex() const;
+
+	/// Numbers of synsets changed by applyPatch()
+	struct PatchCounts
+	{
+		unsigned	added;
+		unsigned	modified;
+		unsigned	deleted;
+	};
+
+	/// Apply a patch to the loaded WordNet without reloading it. The patch is a WNXML file of synsets to add, modify or delete:
+	/// a synset replaces the one with the same id and POS, or is added if there is none; a synset with nothing but
+	/// an ID and a POS (no other element) deletes it. Warnings are issued for invalid POS (W02), missing relation targets (W03,
+	/// also for the relations of other synsets to the synsets deleted, which are kept), self-references (W04), and synsets
+	/// to delete that don't exist (W05), the second synset of the same id in the patch is ignored (W01), as when loading.
+	///
+	/// The result is the same as loading a file with the patch applied: the modified synsets where they were, the deleted
+	/// ones left out, and the added ones at the end, in the order of the patch (the synsets of a literal are returned in
+	/// this order; a synset that had no literals gets its senses ranked as if it was added).
+	/// Each synset knows which of its relations are inverses made from the relations of other synsets
+	/// (see Synset::inverted), so only the synsets of the patch and the ones their relations point at are changed:
+	/// - the literal index entries of the old synsets are replaced by those of the new ones;
+	/// - the inverse relations made from the relations the old synsets stated are removed from their targets,
+	///   the ones made from the relations of the new synsets are added among the others in the order of their sources' ids,
+	///   as loading makes them (for symmetric relations like near_antonym the copies the other synset stated itself are kept);
+	/// - the inverse relations other synsets made to the synsets of the patch are kept (also for added synsets,
+	///   if they were already pointed at, these are found through the reverse edges of the graphs).
+	/// The graphs, their hash indices, the literal trie and the folded index are updated in place for these synsets
+	/// (see WNGraph::update(), LiteralTrie::update()), so the cost of a patch is about linear in its size, plus
+	/// moving the arrays of the word senses and of the trie (only if literals are added). A POS that the patch
+	/// mostly changes gets its graph built again instead; the derived indices of the graphs are built again at first use.
+	/// The WordNet is not changed if the patch can't be read or parsed.
+	/// Must not be called while queries are running on other threads.
+	/// @param patchfilename WNXML file of the synsets changed
+	/// @exception WNQueryException if the file can't be opened
+	/// @exception WNXMLParserException for XML errors
+	PatchCounts	applyPatch( const std::string& patchfilename);
+
+	/// Apply the given synsets as a patch (see above). This is how the content is changed from code:
+	/// the synsets, the inverse relations, the literal index, the graphs and the trie are kept consistent.
+	/// The synsets are applied in the order given (the warnings refer to their positions in the vector).
+	/// Must not be called while queries are running on other threads.
+	PatchCounts	applyPatch( const std::vector<Synset>& patch);
+
+	/// Statistics of loading (time of the phases, counts of content and warnings) and latencies of queries.
+	/// Query latencies are recorded by all query functions (unless turned off with statistics().setQueryTiming( false)),
+	/// they can be read while queries are running.
+	const WNStats&	statistics() const	{ return m_stats; }
+	WNStats&		statistics()		{ return m_stats; }
+
+	/// Time spent in the phases of loading, in seconds (see WNStats::LoadTimes)
+	typedef WNStats::LoadTimes LoadTimes;
+	const LoadTimes&	loadTimes() const	{ return m_stats.loadTimes(); }
+
+	/// Number of times the graphs were (re)built. Objects derived from the content (e.g. TargetSet)
+	/// compare it with the value they were built at, to notice changes.
+	/// It can be read from any thread (it's atomic, incremented after the new content is complete), but content
+	/// read after seeing a new value is only consistent if the rebuild was not concurrent with queries, as required.
+	unsigned long	generation() const	{ return m_generation.load( std::memory_order_acquire); }
+
+private:
+	friend class NeighborTable; // uses nearest_nodes()
+	friend class TargetSet; // uses id_connected_with()
+
+	/// Create empty object (used by createFromSnapshot)
+	WNQuery( ML::MultiLog& logger)
+		: m_logger(logger)
+		, m_folded(NULL)
+		, m_generation(0)
+	{}
+
+	void _load_serial( const std::string& wnxmlfilename);
+	void _load_parallel( const std::string& wnxmlfilename, unsigned nthreads);
+	void _save_synset( Synset& syns, int lcnt);
+	tdat&		_dat( const std::string& pos);
+	tsenses&	_senses( const std::string& pos);
+	WNGraph&	_graph( const std::string& pos);
+
+	/// Build the relation graphs and hash indices, and the literal trie if trie is true
+	/// (the folded index is dropped, and built again when it's used)
+	void build_indices( bool trie);
+	
+	/// Create the inverse pairs of all reflexive relations in all POS.
+	/// Ie. if rel points from s1 to s2, mark inv(rel) from s2 to s1.
+	/// see body of _invRelTable().
+	void invert_relations();
+	void _inv_rel_pos( tdat& pdat, std::map<std::string,std::string>& invtbl);
+
+	/// Apply the synsets of a patch (see applyPatch()), lines are their line numbers in the patch file (NULL if not from a file)
+	PatchCounts	_apply_patch( const std::vector<Synset>& patch, const std::vector<int>* lines);
+
+	/// Apply the synsets of a patch in one POS (see applyPatch()), g is the graph of the POS.
+	/// @param inplace update g for the synsets changed (else it's left as it was before the patch, to be built again)
+	/// @param order the synsets of edits in the order of the patch
+	/// @param literals gets the literals whose senses changed
+	void _patch_pos( tdat& pdat, tsenses& psenses, WNGraph& g, bool inplace, const std::vector<const Synset*>& order,
+					 const std::map<std::string, const Synset*>& edits, std::map<std::string,std::string>& invtbl,
+					 PatchCounts& counts, std::set<std::string>& literals);
+	void _invRelTable( std::map<std::string,std::string>& inv)
+	{
+		inv.clear();
+		inv["hypernym"]					= "hyponym";
+		inv["holo_member"]				= "mero_member";
+		inv["holo_part"]				= "mero_part";
+		inv["holo_portion"]				= "mero_portion";
+		inv["region_domain"]			= "region_member";
+		inv["usage_domain"]				= "usage_member";
+		inv["category_domain"]			= "category_member";
+		inv["near_antonym"]				= "near_antonym";
+		inv["middle"]					= "middle";
+		inv["verb_group"]				= "verb_group";
+		inv["similar_to"]				= "similar_to";
+		inv["also_see"]					= "also_see";
+		inv["be_in_state"]				= "be_in_state";
+		inv["eng_derivative"]			= "eng_derivative";
+		inv["is_consequent_state_of"]	= "has_consequent_state";
+		inv["is_preparatory_phase_of"]	= "has_preparatory_phase";
+		inv["is_telos_of"]				= "has_telos";
+		inv["subevent"]					= "has_subevent";
+		inv["causes"]					= "caused_by";
+	}
+
+	/// Queries run by other queries, not recorded in the statistics (so only the query called from
+	/// outside is): see lookUpLiteral(), isIDConnectedWith(), isLiteralCompatibleWithSynset()
+	void literal_ids( const std::string& literal, const std::string& pos, std::vector<std::string>& res) const;
+	bool id_connected_with( const std::string& id, const std::string& pos, const std::string& relation, const std::set<std::string>& targetIDs, std::string& foundTargetID, int maxDepth) const;
+	bool literal_compatible( const std::string& literal, const std::string& pos, const std::string& id, bool hyponyms) const;
+
+	double WNQuery::simLeaCho(	const std::string& id1, 
+								const std::string& id2,
+								const std::string& pos,
+								const std::string& relation,
+								const bool addArtificialTop) const;
+
+	/// Synsets reachable from node n by relation rel (breadth-first), each once with its shortest distance
+	/// (plus dist, the distance of n). The artificial top is WNGraph::npos.
+	void getReach(	const WNGraph& g,
+					WNGraph::tnode n,
+					unsigned rel,
+					std::vector< std::pair< WNGraph::tnode, int > >& res,
+					int dist,
+					const bool addArtificialTop) const;
+
+	/// Jobs of sim_matrix() (see similarity.cpp)
+	struct ReachJob;
+	struct ScoreJob;
+
+	/// Similarity matrix of lists of synset nodes (see similarityMatrix())
+	void sim_matrix(	const WNGraph& g,
+						const std::vector< std::vector<WNGraph::tnode> >& senses1,
+						const std::vector< std::vector<WNGraph::tnode> >& senses2,
+						unsigned rel,
+						const bool addArtificialTop,
+						tSimMatrix& results,
+						ThreadPool* pool) const;
+
+	/// k nearest neighbors of synset node n (see nearestNeighbors()): nodes with scores, best first
+	void nearest_nodes(	const WNGraph& g,
+						WNGraph::tnode n,
+						unsigned rel,
+						size_t k,
+						const bool addArtificialTop,
+						std::vector< std::pair< WNGraph::tnode, double > >& res) const;
+
+	/// Shortest connection of two synsets through a common node reachable from both by relation rel
+	/// (or through the artificial top). Searches from both synsets at the same time, level by level,
+	/// and stops as soon as no shorter connection can be found.
+	/// @return sum of the distances of the common node from n1 and n2 (each counted from 1),
+	/// 2*LeaCho_D if there's no connection shorter than that
+	int meetReach(	const WNGraph& g,
+					WNGraph::tnode n1,
+					WNGraph::tnode n2,
+					unsigned rel,
+					const bool addArtificialTop) const;
+
+private:
+
+	ML::MultiLog&	m_logger;
+
+	std::string	m_encoding; ///< output encoding of the parser (encoding of all data)
+
+	tdat		m_ndat; ///< nouns
+	tdat		m_vdat;
+	tdat		m_adat;
+	tdat		m_bdat;
+
+	tsenses		m_nsenses; ///< nouns
+	tsenses		m_vsenses;
+	tsenses		m_asenses;
+	tsenses		m_bsenses;
+
+	mutable std::auto_ptr<tidx>	m_idx[4]; ///< multimaps made by idx() (n, v, a, b), NULL if not made
+
+	WNGraph		m_ngraph; ///< nouns
+	WNGraph		m_vgraph;
+	WNGraph		m_agraph;
+	WNGraph		m_bgraph;
+
+	LiteralTrie	m_trie; ///< literals of all POS
+
+	mutable std::mutex					m_mutex; ///< guards building m_folded, and m_idx
+	mutable std::atomic<FoldedIndex*>	m_folded; ///< see foldedIndex(), NULL if not built yet (owned)
+
+	std::atomic<unsigned long>	m_generation; ///< see generation()
+	WNStats			m_stats; ///< see statistics()
+
+};
+
+
+/// Range of synsets containing a literal, see WNQuery::findLiteral().
+class WNQuery::LiteralMatches
+{
+public:
+
+	/// Forward iterator over the synsets
+	class const_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag	iterator_category;
+		typedef Synset						value_type;
+		typedef std::ptrdiff_t				difference_type;
+		typedef const Synset*				pointer;
+		typedef const Synset&				reference;
+
+		const_iterator()
+			: m_graph( NULL), m_node( NULL)
+		{}
+
+		reference			operator*() const		{ return *m_graph->synset( *m_node); }
+		pointer				operator->() const		{ return m_graph->synset( *m_node); }
+
+		/// Id of current synset
+		const std::string&	id() const				{ return m_graph->id( *m_node); }
+
+		const_iterator&		operator++()			{ ++m_node; return *this; }
+		const_iterator		operator++( int)		{ const_iterator r = *this; ++m_node; return r; }
+
+		bool	operator==( const const_iterator& o) const	{ return m_node == o.m_node; }
+		bool	operator!=( const const_iterator& o) const	{ return m_node != o.m_node; }
+
+	private:
+		friend class LiteralMatches;
+
+		const_iterator( const WNGraph* graph, const WNGraph::tnode* node)
+			: m_graph( graph), m_node( node)
+		{}
+
+		const WNGraph*			m_graph;
+		const WNGraph::tnode*	m_node;
+	};
+
+	const_iterator	begin() const	{ return const_iterator( m_graph, m_nodes.first); }
+	const_iterator	end() const		{ return const_iterator( m_graph, m_nodes.last); }
+	bool			empty() const	{ return m_nodes.empty(); }
+	size_t			size() const	{ return m_nodes.size(); }
+
+private:
+	friend class WNQuery;
+
+	LiteralMatches( const WNGraph* graph, WNGraph::Targets nodes)
+		: m_graph( graph), m_nodes( nodes)
+	{}
+
+	const WNGraph*		m_graph;
+	WNGraph::Targets	m_nodes;
+};
+
+
+#ifdef LIBWNXML_STRING_VIEW
+inline WNQuery::LiteralMatches WNQuery::findLiteral( std::string_view literal, const std::string& pos) const
+{
+	return findLiteral( literal.data(), literal.size(), pos);
+}
+#endif
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __WNQUERY_H__
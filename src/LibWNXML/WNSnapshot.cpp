@@ -0,0 +1,514 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "LiteralTrie.h"
+#include "WNSnapshot.h"
+#include "WNQuery.h"
+
+namespace LibWNXML {
+
+
+namespace {
+
+const unsigned	ByteOrderMark = 0x01020304;
+
+/// File header, followed by the section directory
+struct SnapshotHeader
+{
+	char				magic[8];
+	unsigned			version;
+	unsigned			byteorder;
+	unsigned			nsections;
+	unsigned			reserved;
+	unsigned long long	payloadsize; ///< size of everything after the header
+	unsigned long long	checksum; ///< snapshotChecksum() of everything after the header
+	unsigned long long	reserved2;
+};
+
+struct SnapshotDirEntry
+{
+	unsigned			tag;
+	unsigned			reserved;
+	unsigned long long	offset; ///< from start of file
+	unsigned long long	size; ///< in bytes
+};
+
+const unsigned	TagStrings = snapshotTag( 'S','T','R','S');
+const unsigned	TagMeta = snapshotTag( 'M','E','T','A');
+
+size_t align8( size_t n)
+{ return (n + 7) & ~size_t(7); }
+
+} // namespace {
+
+
+unsigned long long snapshotChecksum( const char* data, size_t size)
+{
+	const unsigned long long prime = 1099511628211ULL;
+	unsigned long long h = 14695981039346656037ULL;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		unsigned long long w;
+		memcpy( &w, data + i, 8);
+		h = (h ^ w) * prime;
+	}
+	for (; i < size; i++)
+		h = (h ^ (unsigned char)data[i]) * prime;
+	return h;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MappedFile
+
+MappedFile::MappedFile( const std::string& filename)
+	: m_data( NULL)
+	, m_size( 0)
+{
+#ifdef _WIN32
+	m_file = m_mapping = NULL;
+	HANDLE f = CreateFileA( filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (f == INVALID_HANDLE_VALUE) {
+		ML_THROW_EXC( "Could not open file: " << filename, WNSnapshotException);
+	}
+	LARGE_INTEGER sz;
+	if (!GetFileSizeEx( f, &sz)) {
+		CloseHandle( f);
+		ML_THROW_EXC( "Could not get size of file: " << filename, WNSnapshotException);
+	}
+	m_file = f;
+	m_size = size_t( sz.QuadPart);
+	if (m_size == 0)
+		return;
+	m_mapping = CreateFileMappingA( f, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapping != NULL)
+		m_data = (const char*) MapViewOfFile( m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_data == NULL) {
+		if (m_mapping != NULL)
+			CloseHandle( m_mapping);
+		CloseHandle( f);
+		ML_THROW_EXC( "Could not map file: " << filename, WNSnapshotException);
+	}
+#else
+	int fd = open( filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		ML_THROW_EXC( "Could not open file: " << filename, WNSnapshotException);
+	}
+	struct stat st;
+	if (fstat( fd, &st) != 0) {
+		close( fd);
+		ML_THROW_EXC( "Could not get size of file: " << filename, WNSnapshotException);
+	}
+	m_size = size_t( st.st_size);
+	if (m_size != 0) {
+		void* p = mmap( NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED) {
+			close( fd);
+			ML_THROW_EXC( "Could not map file: " << filename, WNSnapshotException);
+		}
+		m_data = (const char*) p;
+	}
+	close( fd); // the mapping stays valid
+#endif
+}
+
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if (m_data != NULL)
+		UnmapViewOfFile( m_data);
+	if (m_mapping != NULL)
+		CloseHandle( m_mapping);
+	if (m_file != NULL)
+		CloseHandle( m_file);
+#else
+	if (m_data != NULL)
+		munmap( (void*) m_data, m_size);
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// SnapshotWriter
+
+SnapshotWriter::SnapshotWriter()
+{
+	// reference 0 is always the empty string
+	m_pool.push_back( '\0');
+	m_poolidx[""] = 0;
+}
+
+
+unsigned SnapshotWriter::addString( const std::string& str)
+{
+	std::map<std::string, unsigned>::iterator it = m_poolidx.find( str);
+	if (it != m_poolidx.end())
+		return it->second;
+	if (m_pool.size() + str.size() + 1 > 0xFFFFFFFFUL) {
+		ML_THROW_EXC( "Snapshot string pool exceeds 4 GB", WNSnapshotException);
+	}
+	unsigned ref = unsigned( m_pool.size());
+	m_pool.append( str);
+	m_pool.push_back( '\0');
+	m_poolidx.insert( std::make_pair( str, ref));
+	return ref;
+}
+
+
+void SnapshotWriter::beginSection( unsigned tag)
+{
+	m_sections.push_back( std::make_pair( tag, std::vector<unsigned>()));
+}
+
+
+void SnapshotWriter::write( const std::string& filename) const
+{
+	// lay out sections: string pool first, then the others in the order they were added
+	size_t nsect = m_sections.size() + 1;
+	std::vector<SnapshotDirEntry> dir( nsect);
+	size_t off = align8( sizeof(SnapshotHeader) + nsect * sizeof(SnapshotDirEntry));
+	dir[0].tag = TagStrings;
+	dir[0].reserved = 0;
+	dir[0].offset = off;
+	dir[0].size = m_pool.size();
+	off = align8( off + m_pool.size());
+	for (size_t i=0; i!=m_sections.size(); i++) {
+		dir[i+1].tag = m_sections[i].first;
+		dir[i+1].reserved = 0;
+		dir[i+1].offset = off;
+		dir[i+1].size = m_sections[i].second.size() * sizeof(unsigned);
+		off = align8( off + size_t( dir[i+1].size));
+	}
+
+	// assemble payload (everything after the header) to checksum it
+	// (offsets in the directory are from start of file, hence the "- hs")
+	const size_t hs = sizeof(SnapshotHeader);
+	std::string payload( off - hs, '\0');
+	memcpy( &payload[0], &dir[0], nsect * sizeof(SnapshotDirEntry));
+	memcpy( &payload[size_t( dir[0].offset) - hs], m_pool.data(), m_pool.size());
+	for (size_t i=0; i!=m_sections.size(); i++)
+		if (!m_sections[i].second.empty())
+			memcpy( &payload[size_t( dir[i+1].offset) - hs], &m_sections[i].second[0], size_t( dir[i+1].size));
+
+	SnapshotHeader hdr;
+	memset( &hdr, 0, sizeof(hdr));
+	memcpy( hdr.magic, SnapshotMagic, sizeof(hdr.magic));
+	hdr.version = SnapshotVersion;
+	hdr.byteorder = ByteOrderMark;
+	hdr.nsections = unsigned( nsect);
+	hdr.payloadsize = payload.size();
+	hdr.checksum = snapshotChecksum( payload.data(), payload.size());
+
+	std::ofstream outf( filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!outf) {
+		ML_THROW_EXC( "Could not open file for writing: " << filename, WNSnapshotException);
+	}
+	outf.write( (const char*) &hdr, sizeof(hdr));
+	outf.write( payload.data(), std::streamsize( payload.size()));
+	outf.close();
+	if (!outf) {
+		ML_THROW_EXC( "Error writing file: " << filename, WNSnapshotException);
+	}
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// SnapshotReader
+
+SnapshotReader::SnapshotReader( const std::string& filename)
+	: m_filename( filename)
+	, m_file( filename)
+	, m_pool( NULL)
+	, m_poolsize( 0)
+{
+	const char* data = m_file.data();
+	size_t size = m_file.size();
+
+	// check header
+	SnapshotHeader hdr;
+	if (size < sizeof(hdr)) {
+		ML_THROW_EXC( "Not a snapshot file (too short): " << filename, WNSnapshotException);
+	}
+	memcpy( &hdr, data, sizeof(hdr));
+	if (memcmp( hdr.magic, SnapshotMagic, sizeof(hdr.magic)) != 0) {
+		ML_THROW_EXC( "Not a snapshot file: " << filename, WNSnapshotException);
+	}
+	if (hdr.byteorder != ByteOrderMark) {
+		ML_THROW_EXC( "Snapshot was written on a machine with different byte order: " << filename, WNSnapshotException);
+	}
+	if (hdr.version != SnapshotVersion) {
+		ML_THROW_EXC( "Snapshot version " << hdr.version << " is not supported (expected " << SnapshotVersion << "): " << filename, WNSnapshotException);
+	}
+	if (hdr.payloadsize != size - sizeof(hdr)) {
+		ML_THROW_EXC( "Snapshot file is truncated or has trailing garbage: " << filename, WNSnapshotException);
+	}
+	if (hdr.checksum != snapshotChecksum( data + sizeof(hdr), size - sizeof(hdr))) {
+		ML_THROW_EXC( "Snapshot checksum mismatch, file is corrupt: " << filename, WNSnapshotException);
+	}
+
+	// read directory
+	if (sizeof(hdr) + size_t( hdr.nsections) * sizeof(SnapshotDirEntry) > size) {
+		ML_THROW_EXC( "Invalid snapshot section directory: " << filename, WNSnapshotException);
+	}
+	for (unsigned i=0; i!=hdr.nsections; i++) {
+		SnapshotDirEntry e;
+		memcpy( &e, data + sizeof(hdr) + i * sizeof(SnapshotDirEntry), sizeof(e));
+		if (e.offset % 8 != 0 || e.offset > size || e.size > size - e.offset) {
+			ML_THROW_EXC( "Invalid snapshot section directory: " << filename, WNSnapshotException);
+		}
+		m_sections[e.tag] = std::make_pair( size_t( e.offset), size_t( e.size));
+	}
+
+	// string pool
+	std::map< unsigned, std::pair<size_t, size_t> >::const_iterator sp = m_sections.find( TagStrings);
+	if (sp == m_sections.end() || sp->second.second == 0 || data[sp->second.first + sp->second.second - 1] != '\0') {
+		ML_THROW_EXC( "Missing or invalid string pool in snapshot: " << filename, WNSnapshotException);
+	}
+	m_pool = data + sp->second.first;
+	m_poolsize = sp->second.second;
+}
+
+
+bool SnapshotReader::isSnapshot( const std::string& filename)
+{
+	std::ifstream inf( filename.c_str(), std::ios::in | std::ios::binary);
+	char magic[sizeof(SnapshotMagic)];
+	if (!inf.read( magic, sizeof(magic)))
+		return false;
+	return memcmp( magic, SnapshotMagic, sizeof(magic)) == 0;
+}
+
+
+const unsigned* SnapshotReader::section( unsigned tag, size_t& nwords) const
+{
+	std::map< unsigned, std::pair<size_t, size_t> >::const_iterator it = m_sections.find( tag);
+	if (it == m_sections.end()) {
+		ML_THROW_EXC( "Missing section in snapshot: " << m_filename, WNSnapshotException);
+	}
+	nwords = it->second.second / sizeof(unsigned);
+	return (const unsigned*) (m_file.data() + it->second.first);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// WNQuery snapshot save/load
+
+namespace {
+
+const char* const	PosNames[] = { "n", "v", "a", "b" };
+
+void put_pairs( SnapshotWriter& w, const Synset::tPtrVect& v)
+{
+	w.put( unsigned( v.size()));
+	for (size_t i=0; i!=v.size(); i++) {
+		w.putString( v[i].first);
+		w.putString( v[i].second);
+	}
+}
+
+void get_pairs( SnapshotCursor& c, Synset::tPtrVect& v)
+{
+	unsigned n = c.get();
+	v.reserve( n);
+	for (unsigned i=0; i!=n; i++) {
+		std::string first = c.getString();
+		v.push_back( std::make_pair( first, c.getString()));
+	}
+}
+
+void put_strings( SnapshotWriter& w, const std::vector<std::string>& v)
+{
+	w.put( unsigned( v.size()));
+	for (size_t i=0; i!=v.size(); i++)
+		w.putString( v[i]);
+}
+
+void get_strings( SnapshotCursor& c, std::vector<std::string>& v)
+{
+	unsigned n = c.get();
+	v.reserve( n);
+	for (unsigned i=0; i!=n; i++)
+		v.push_back( c.getString());
+}
+
+// field order must match get_synset()
+void put_synset( SnapshotWriter& w, const Synset& syns)
+{
+	w.putString( syns.id);
+	w.putString( syns.pos);
+	w.put( unsigned( syns.synonyms.size()));
+	for (size_t i=0; i!=syns.synonyms.size(); i++) {
+		w.putString( syns.synonyms[i].literal);
+		w.putString( syns.synonyms[i].sense);
+		w.putString( syns.synonyms[i].lnote);
+		w.putString( syns.synonyms[i].nucleus);
+	}
+	put_pairs( w, syns.ilrs);
+	w.putString( syns.def);
+	w.putString( syns.bcs);
+	put_strings( w, syns.usages);
+	put_strings( w, syns.snotes);
+	w.putString( syns.stamp);
+	w.putString( syns.domain);
+	put_pairs( w, syns.sumolinks);
+	w.putString( syns.nl);
+	w.putString( syns.tnl);
+	put_pairs( w, syns.elrs);
+	put_pairs( w, syns.ekszlinks);
+	put_pairs( w, syns.vframelinks);
+}
+
+void get_synset( SnapshotCursor& c, Synset& syns)
+{
+	syns.id = c.getString();
+	syns.pos = c.getString();
+	unsigned n = c.get();
+	syns.synonyms.reserve( n);
+	for (unsigned i=0; i!=n; i++) {
+		std::string l = c.getString();
+		std::string s = c.getString();
+		std::string o = c.getString();
+		syns.synonyms.push_back( Synset::Synonym( l, s, o, c.getString()));
+	}
+	get_pairs( c, syns.ilrs);
+	syns.def = c.getString();
+	syns.bcs = c.getString();
+	get_strings( c, syns.usages);
+	get_strings( c, syns.snotes);
+	syns.stamp = c.getString();
+	syns.domain = c.getString();
+	get_pairs( c, syns.sumolinks);
+	syns.nl = c.getString();
+	syns.tnl = c.getString();
+	get_pairs( c, syns.elrs);
+	get_pairs( c, syns.ekszlinks);
+	get_pairs( c, syns.vframelinks);
+}
+
+} // namespace {
+
+
+void WNQuery::saveSnapshot( const std::string& filename) const
+{
+	try {
+		SnapshotWriter w;
+
+		w.beginSection( TagMeta);
+		w.putString( m_encoding);
+
+		for (int p=0; p!=4; p++) {
+			// synsets (already holding the inverted relations), in id order
+			const tdat& d = dat( PosNames[p]);
+			w.beginSection( snapshotTag( 'S','Y','N', PosNames[p][0]));
+			w.put( unsigned( d.size()));
+			for (tdat::const_iterator it=d.begin(); it!=d.end(); it++)
+				put_synset( w, it->second);
+			// number of inverted relations of the synsets
+			w.beginSection( snapshotTag( 'I','N','V', PosNames[p][0]));
+			for (tdat::const_iterator it=d.begin(); it!=d.end(); it++)
+				w.put( unsigned( it->second.inverted));
+			// literal index: the word senses, in their order, as (number of synset in the section above, number of synonym)
+			StringHashTable<unsigned> synsnum;
+			synsnum.reserve( d.size());
+			for (tdat::const_iterator it=d.begin(); it!=d.end(); it++)
+				synsnum.insert( it->first.data(), it->first.size(), unsigned( synsnum.size()));
+			const tsenses& x = senses( PosNames[p]);
+			w.beginSection( snapshotTag( 'I','D','X', PosNames[p][0]));
+			w.put( unsigned( x.size()));
+			for (size_t i=0; i!=x.size(); i++) {
+				const std::vector<Synset::Synonym>& syn = d.find( *x[i].id)->second.synonyms;
+				size_t j = 0;
+				while (&syn[j].literal != x[i].literal)
+					j++;
+				w.put( *synsnum.find( *x[i].id));
+				w.put( unsigned( j));
+			}
+		}
+
+		m_trie.save( w);
+
+		w.write( filename);
+	}
+	catch (const WNSnapshotException& e) {
+		ML_THROW_EXC( "Could not save snapshot: " << e.msg(), WNQueryException);
+	}
+}
+
+
+std::auto_ptr<WNQuery> WNQuery::createFromSnapshot( const std::string& filename, ML::MultiLog& logger)
+{
+	std::auto_ptr<WNQuery> wn( new WNQuery( logger));
+	std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+	try {
+		SnapshotReader rdr( filename);
+
+		SnapshotCursor meta( rdr, TagMeta);
+		wn->m_encoding = meta.getString();
+
+		for (int p=0; p!=4; p++) {
+			// synsets were written in id order, so inserting at end() is constant time
+			tdat& d = wn->_dat( PosNames[p]);
+			SnapshotCursor sc( rdr, snapshotTag( 'S','Y','N', PosNames[p][0]));
+			unsigned n = sc.get();
+			SnapshotCursor inv( rdr, snapshotTag( 'I','N','V', PosNames[p][0]));
+			std::vector<tdat::iterator> synsets;
+			synsets.reserve( n);
+			for (unsigned i=0; i!=n; i++) {
+				Synset syns;
+				get_synset( sc, syns);
+				syns.inverted = inv.get();
+				if (syns.inverted > syns.ilrs.size()) {
+					ML_THROW_EXC( "Invalid number of inverted relations in synset " << syns.id, WNSnapshotException);
+				}
+				wn->m_stats.m_counts.relations += syns.ilrs.size() - syns.inverted;
+				wn->m_stats.m_counts.inverted += syns.inverted;
+				tdat::iterator it = d.insert( d.end(), std::make_pair( syns.id, Synset()));
+				std::swap( it->second, syns);
+				synsets.push_back( it);
+			}
+			wn->m_stats.m_counts.synsets += n;
+			// literal index: the word senses point into the synsets
+			tsenses& x = wn->_senses( PosNames[p]);
+			SnapshotCursor ic( rdr, snapshotTag( 'I','D','X', PosNames[p][0]));
+			n = ic.get();
+			x.reserve( n);
+			for (unsigned i=0; i!=n; i++) {
+				unsigned s = ic.get();
+				unsigned j = ic.get();
+				if (s >= synsets.size() || j >= synsets[s]->second.synonyms.size()) {
+					ML_THROW_EXC( "Invalid literal index entry " << s << " " << j, WNSnapshotException);
+				}
+				WNGraph::Sense ws = { &synsets[s]->second.synonyms[j].literal, &synsets[s]->first };
+				x.push_back( ws);
+			}
+		}
+
+		wn->m_trie.load( rdr);
+	}
+	catch (const WNSnapshotException& e) {
+		ML_THROW_EXC( "Could not load snapshot: " << e.msg(), WNQueryException);
+	}
+	wn->m_stats.m_times.parse = std::chrono::duration<double>( std::chrono::steady_clock::now() - t).count();
+	wn->build_indices( false);
+	return wn;
+}
+
+
+bool WNQuery::isSnapshot( const std::string& filename)
+{
+	return SnapshotReader::isSnapshot( filename);
+}
+
+
+} // namespace LibWNXML {
@@ -0,0 +1,156 @@
+#ifndef __WNSNAPSHOT_H__
+#define __WNSNAPSHOT_H__
+
+#include <map>
+#include <string>
+#include <vector>
+#include "../MLUtils/Exception.h"
+
+namespace LibWNXML {
+
+/// Exception for errors while reading or writing binary snapshot files.
+ML_EXCEPTION( WNSnapshotException);
+
+/// Binary snapshot file layout (all integers in native byte order, checked when loading):
+///
+///   header     magic "WNXMLSNP", version, byte order mark, section count,
+///              payload size and checksum of everything following the header
+///   directory  one entry (tag, offset, size) per section
+///   sections   each aligned to 8 bytes, so their words can be read directly from a
+///              read-only memory mapping of the file
+///
+/// Strings are stored once, NUL-terminated, in the "STRS" section, and are
+/// referenced everywhere else by 32-bit offsets into it.
+///
+/// Files of any other version than SnapshotVersion are rejected (snapshots are caches of the XML,
+/// they can be written again from it).
+const char		SnapshotMagic[8] = { 'W','N','X','M','L','S','N','P' };
+const unsigned	SnapshotVersion = 1;
+
+/// Make a section tag from 4 characters
+inline unsigned snapshotTag( char a, char b, char c, char d)
+{ return unsigned((unsigned char)a) | (unsigned((unsigned char)b) << 8) | (unsigned((unsigned char)c) << 16) | (unsigned((unsigned char)d) << 24); }
+
+/// Checksum used for snapshot payloads (FNV-1a, fed 8 bytes at a time).
+unsigned long long snapshotChecksum( const char* data, size_t size);
+
+
+/// Read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+	/// Map file. Throws WNSnapshotException if the file can't be opened or mapped.
+	MappedFile( const std::string& filename) throw(WNSnapshotException);
+	~MappedFile();
+
+	const char*	data() const	{ return m_data; }
+	size_t		size() const	{ return m_size; }
+
+private:
+	MappedFile( const MappedFile&);				// not copyable
+	MappedFile& operator=( const MappedFile&);
+
+	const char*	m_data;
+	size_t		m_size;
+#ifdef _WIN32
+	void*		m_file;
+	void*		m_mapping;
+#endif
+};
+
+
+/// Collects sections and a deduplicated string pool, then writes a snapshot file.
+class SnapshotWriter
+{
+public:
+	SnapshotWriter();
+
+	/// Add string to the pool (if not there yet), return its reference.
+	unsigned	addString( const std::string& str);
+
+	/// Start a new section, subsequent put() calls append to it.
+	void		beginSection( unsigned tag);
+
+	/// Append a 32-bit word to the current section.
+	void		put( unsigned word)
+	{ m_sections.back().second.push_back( word); }
+
+	/// Append a string reference to the current section.
+	void		putString( const std::string& str)
+	{ put( addString( str)); }
+
+	/// Write out the file. Throws WNSnapshotException on I/O errors.
+	void		write( const std::string& filename) const throw(WNSnapshotException);
+
+private:
+	std::string											m_pool;
+	std::map<std::string, unsigned>						m_poolidx;
+	std::vector< std::pair< unsigned, std::vector<unsigned> > >	m_sections;
+};
+
+
+/// Validates a mapped snapshot file and gives access to its sections.
+class SnapshotReader
+{
+public:
+	/// Map and validate file (magic, version, byte order, size, checksum).
+	/// Throws WNSnapshotException if any of them doesn't match.
+	SnapshotReader( const std::string& filename) throw(WNSnapshotException);
+
+	/// Check whether the file starts with the snapshot magic (no other validation is done).
+	static bool isSnapshot( const std::string& filename);
+
+	/// Get section with given tag as an array of 32-bit words.
+	/// Throws WNSnapshotException if the section is missing.
+	const unsigned* section( unsigned tag, size_t& nwords) const throw(WNSnapshotException);
+
+	/// Get pooled string by reference (pointer into the mapping, valid while the reader lives)
+	const char* str( unsigned ref) const throw(WNSnapshotException)
+	{
+		if (ref >= m_poolsize) {
+			ML_THROW_EXC( "Invalid string reference " << ref << " in snapshot " << m_filename, WNSnapshotException);
+		}
+		return m_pool + ref;
+	}
+
+private:
+	std::string											m_filename;
+	MappedFile											m_file;
+	std::map< unsigned, std::pair<size_t, size_t> >		m_sections; ///< tag -> (offset, size in bytes)
+	const char*											m_pool;
+	size_t												m_poolsize;
+};
+
+
+/// Sequential reader over the 32-bit words of a section, with bounds checking.
+class SnapshotCursor
+{
+public:
+	SnapshotCursor( const SnapshotReader& rdr, unsigned tag) throw(WNSnapshotException)
+		: m_rdr( rdr), m_pos( 0)
+	{ m_data = rdr.section( tag, m_size); }
+
+	bool		atEnd() const	{ return m_pos == m_size; }
+
+	unsigned	get() throw(WNSnapshotException)
+	{
+		if (m_pos >= m_size) {
+			ML_THROW_EXC( "Unexpected end of snapshot section", WNSnapshotException);
+		}
+		return m_data[m_pos++];
+	}
+
+	std::string	getString() throw(WNSnapshotException)
+	{ return std::string( m_rdr.str( get())); }
+
+private:
+	const SnapshotReader&	m_rdr;
+	const unsigned*			m_data;
+	size_t					m_size;
+	size_t					m_pos;
+};
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __WNSNAPSHOT_H__
@@ -0,0 +1,191 @@
+#include <math.h>
+#include <ostream>
+#include "WNStats.h"
+
+namespace LibWNXML {
+
+
+namespace {
+
+const char* const QueryNames[WNStats::QueryTypes] = {
+	"lookUpID",
+	"lookUpLiteral",
+	"lookUpSense",
+	"lookUpRelation",
+	"traceRelation",
+	"isIDConnectedWith",
+	"isLiteralConnectedWith",
+	"isLiteralCompatibleWithSynset",
+	"areSynonyms",
+	"similarityLeacockChodorow",
+	"similarityMatrix",
+	"nearestNeighbors",
+	"completeLiteral",
+	"fuzzyLookUpLiteral",
+	"lookUpLiteralFolded"
+};
+
+const char* const PhaseNames[4] = { "parse", "save", "invert", "graphs" };
+
+/// Shard of the calling thread (threads get the shards in turn)
+unsigned shard_index()
+{
+	static std::atomic<unsigned> next( 0);
+	thread_local unsigned shard = next.fetch_add( 1, std::memory_order_relaxed) % WNStats::Shards;
+	return shard;
+}
+
+} // namespace {
+
+
+WNStats::WNStats()
+	: m_times()
+	, m_counts()
+	, m_timing( true)
+{
+	for (unsigned s=0; s!=Shards; s++)
+		for (size_t q=0; q!=QueryTypes; q++) {
+			m_shards[s].hist[q].sum.store( 0);
+			for (unsigned b=0; b!=Buckets; b++)
+				m_shards[s].hist[q].buckets[b].store( 0);
+		}
+}
+
+
+const char* WNStats::queryName( QueryType q)
+{
+	return QueryNames[q];
+}
+
+
+void WNStats::totals( QueryType q, Totals& t) const
+{
+	t.count = 0;
+	t.sum = 0;
+	for (unsigned b=0; b!=Buckets; b++)
+		t.buckets[b] = 0;
+	for (unsigned s=0; s!=Shards; s++) {
+		const Histogram& h = m_shards[s].hist[q];
+		t.sum += h.sum.load( std::memory_order_relaxed);
+		for (unsigned b=0; b!=Buckets; b++)
+			t.buckets[b] += h.buckets[b].load( std::memory_order_relaxed);
+	}
+	for (unsigned b=0; b!=Buckets; b++)
+		t.count += t.buckets[b];
+}
+
+
+unsigned long long WNStats::queryCount( QueryType q) const
+{
+	unsigned long long n = 0;
+	for (unsigned s=0; s!=Shards; s++)
+		for (unsigned b=0; b!=Buckets; b++)
+			n += m_shards[s].hist[q].buckets[b].load( std::memory_order_relaxed);
+	return n;
+}
+
+
+double WNStats::queryTime( QueryType q) const
+{
+	unsigned long long ns = 0;
+	for (unsigned s=0; s!=Shards; s++)
+		ns += m_shards[s].hist[q].sum.load( std::memory_order_relaxed);
+	return double( ns) * 1e-9;
+}
+
+
+unsigned long long WNStats::queryBucket( QueryType q, unsigned b) const
+{
+	unsigned long long n = 0;
+	for (unsigned s=0; s!=Shards; s++)
+		n += m_shards[s].hist[q].buckets[b].load( std::memory_order_relaxed);
+	return n;
+}
+
+
+double WNStats::bucketLimit( unsigned b)
+{
+	return ldexp( 1e-9, int( b));
+}
+
+
+double WNStats::queryPercentile( QueryType q, double p) const
+{
+	Totals t;
+	totals( q, t);
+	if (t.count == 0)
+		return 0.0;
+	unsigned long long rank = (unsigned long long) ceil( p / 100.0 * double( t.count));
+	unsigned long long cum = 0;
+	for (unsigned b=0; b!=Buckets; b++) {
+		cum += t.buckets[b];
+		if (cum >= rank && cum != 0)
+			return bucketLimit( b);
+	}
+	return bucketLimit( Buckets - 1);
+}
+
+
+void WNStats::record( QueryType q, unsigned long long ns) const
+{
+	// bucket: smallest b with ns <= 2^b, i.e. the number of significant bits of ns-1 (0 for ns <= 1)
+	unsigned b = 0;
+	unsigned long long x = ns == 0 ? 0 : ns - 1;
+	while (b < Buckets - 1 && (x >> b) != 0)
+		b++;
+	Histogram& h = m_shards[shard_index()].hist[q];
+	h.sum.fetch_add( ns, std::memory_order_relaxed);
+	h.buckets[b].fetch_add( 1, std::memory_order_relaxed);
+}
+
+
+void WNStats::write( std::ostream& os) const
+{
+	os << "# HELP wnxml_load_seconds Time spent in the phases of loading.\n";
+	os << "# TYPE wnxml_load_seconds gauge\n";
+	const double* times[4] = { &m_times.parse, &m_times.save, &m_times.invert, &m_times.graphs };
+	for (size_t i=0; i!=4; i++)
+		os << "wnxml_load_seconds{phase=\"" << PhaseNames[i] << "\"} " << *times[i] << "\n";
+
+	os << "# HELP wnxml_load_synsets Synsets stored.\n";
+	os << "# TYPE wnxml_load_synsets gauge\n";
+	os << "wnxml_load_synsets " << m_counts.synsets << "\n";
+	os << "# HELP wnxml_load_relations Relations of the synsets stored, as read.\n";
+	os << "# TYPE wnxml_load_relations gauge\n";
+	os << "wnxml_load_relations " << m_counts.relations << "\n";
+	os << "# HELP wnxml_load_inverted_relations Inverse relations added.\n";
+	os << "# TYPE wnxml_load_inverted_relations gauge\n";
+	os << "wnxml_load_inverted_relations " << m_counts.inverted << "\n";
+	os << "# HELP wnxml_load_warnings Warnings issued while loading, by code.\n";
+	os << "# TYPE wnxml_load_warnings gauge\n";
+	for (size_t i=0; i!=5; i++)
+		os << "wnxml_load_warnings{code=\"W0" << i + 1 << "\"} " << m_counts.warnings[i] << "\n";
+
+	// the shards are added up once, so each histogram is consistent (its count is the sum of its buckets);
+	// buckets are written up to the last one not empty of any query type, to keep the output short
+	Totals t[QueryTypes];
+	unsigned last = 0;
+	for (size_t q=0; q!=QueryTypes; q++) {
+		totals( QueryType( q), t[q]);
+		for (unsigned b=0; b!=Buckets; b++)
+			if (t[q].buckets[b] != 0 && b > last)
+				last = b;
+	}
+
+	os << "# HELP wnxml_query_duration_seconds Latency of queries, by query type.\n";
+	os << "# TYPE wnxml_query_duration_seconds histogram\n";
+	for (size_t q=0; q!=QueryTypes; q++) {
+		const char* name = QueryNames[q];
+		unsigned long long cum = 0;
+		for (unsigned b=0; b<=last && b!=Buckets-1; b++) {
+			cum += t[q].buckets[b];
+			os << "wnxml_query_duration_seconds_bucket{query=\"" << name << "\",le=\"" << bucketLimit( b) << "\"} " << cum << "\n";
+		}
+		os << "wnxml_query_duration_seconds_bucket{query=\"" << name << "\",le=\"+Inf\"} " << t[q].count << "\n";
+		os << "wnxml_query_duration_seconds_sum{query=\"" << name << "\"} " << double( t[q].sum) * 1e-9 << "\n";
+		os << "wnxml_query_duration_seconds_count{query=\"" << name << "\"} " << t[q].count << "\n";
+	}
+}
+
+
+} // namespace LibWNXML {
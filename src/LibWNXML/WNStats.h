@@ -0,0 +1,164 @@
+#ifndef __WNSTATS_H__
+#define __WNSTATS_H__
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+
+namespace LibWNXML {
+
+/// Instrumentation of a WNQuery (see WNQuery::statistics()): time of the loading phases, counts of
+/// the content loaded and of the warnings issued, and latency histograms of the queries by type.
+///
+/// Query latencies are counted in buckets of powers of 2 nanoseconds, so recording a query costs two clock
+/// readings and two relaxed atomic additions. The counters are sharded: each thread records into one of
+/// Shards sets of counters (assigned to the threads in turn, at least a cache line apart), and the readers
+/// add them up, so threads running queries at the same time don't write the same cache lines (unless there
+/// are more threads than shards). Only the queries called from outside are recorded, not the ones they run
+/// (e.g. isIDConnectedWith() by isLiteralConnectedWith()).
+class WNStats
+{
+public:
+
+	/// Time spent in the phases of loading, in seconds
+	struct LoadTimes
+	{
+		double	parse;		///< reading and parsing the XML (or reading the snapshot)
+		double	save;		///< storing the synsets read (WNQuery::_save_synset())
+		double	invert;		///< creating the inverse pairs of relations (WNQuery::invert_relations())
+		double	graphs;		///< building the relation graphs and hash indices (at loading), or updating them (by the last WNQuery::applyPatch())
+	};
+
+	/// Counts of the content loaded, patches included (warnings are not counted when loading a snapshot)
+	struct LoadCounts
+	{
+		unsigned long	synsets;		///< synsets stored
+		unsigned long	relations;		///< relations of the synsets stored, as read
+		unsigned long	inverted;		///< inverse relations added
+		unsigned long	warnings[5];	///< warnings W01 (duplicate id), W02 (invalid POS), W03 (missing relation target), W04 (self-reference),
+										///< W05 (synset to delete not found, see WNQuery::applyPatch())
+	};
+
+	/// Types of queries recorded
+	enum QueryType
+	{
+		LookUpID,
+		LookUpLiteral,
+		LookUpSense,
+		LookUpRelation,
+		TraceRelation,					///< traceRelation(), traceRelationOS()
+		IsIDConnectedWith,
+		IsLiteralConnectedWith,
+		IsLiteralCompatibleWithSynset,
+		AreSynonyms,
+		SimilarityLeacockChodorow,
+		SimilarityMatrix,				///< similarityMatrix(), similarityMatrixIDs()
+		NearestNeighbors,
+		CompleteLiteral,				///< completeLiteral(), completeLiteralSynsets()
+		FuzzyLookUpLiteral,
+		LookUpLiteralFolded,
+		QueryTypes						///< number of query types
+	};
+
+	/// Number of latency buckets: bucket b counts latencies of at most 2^b ns (and not in bucket b-1), the last one all the rest
+	static const unsigned	Buckets = 40;
+
+	/// Number of sets of counters the recording threads are distributed to
+	static const unsigned	Shards = 16;
+
+	WNStats();
+
+	const LoadTimes&	loadTimes() const	{ return m_times; }
+	const LoadCounts&	loadCounts() const	{ return m_counts; }
+
+	/// Name of query type (the name of the WNQuery function)
+	static const char*	queryName( QueryType q);
+
+	/// Number of queries of type q recorded
+	unsigned long long	queryCount( QueryType q) const;
+
+	/// Total time of queries of type q recorded, in seconds
+	double				queryTime( QueryType q) const;
+
+	/// Number of queries of type q in latency bucket b
+	unsigned long long	queryBucket( QueryType q, unsigned b) const;
+
+	/// Upper limit of the latencies of bucket b, in seconds
+	static double		bucketLimit( unsigned b);
+
+	/// Estimate of the p-th percentile latency of queries of type q (0 <= p <= 100): upper limit of the bucket
+	/// it falls in, in seconds (0 if no queries were recorded)
+	double				queryPercentile( QueryType q, double p) const;
+
+	/// Turn recording of query latencies on (default) or off
+	void	setQueryTiming( bool on)	{ m_timing.store( on, std::memory_order_relaxed); }
+	bool	queryTiming() const			{ return m_timing.load( std::memory_order_relaxed); }
+
+	/// Record a query of type q that took ns nanoseconds
+	void	record( QueryType q, unsigned long long ns) const;
+
+	/// Write all statistics in the Prometheus text format (metric names start with wnxml_)
+	void	write( std::ostream& os) const;
+
+	/// Records a query from construction to destruction (if query timing is on)
+	class Timer
+	{
+	public:
+		Timer( const WNStats& stats, QueryType q)
+			: m_stats( stats.queryTiming() ? &stats : NULL)
+			, m_type( q)
+		{
+			if (m_stats != NULL)
+				m_start = std::chrono::steady_clock::now();
+		}
+
+		~Timer()
+		{
+			if (m_stats != NULL)
+				m_stats->record( m_type, (unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - m_start).count());
+		}
+
+	private:
+		const WNStats*							m_stats;
+		QueryType								m_type;
+		std::chrono::steady_clock::time_point	m_start;
+	};
+
+private:
+	WNStats( const WNStats&);				// not copyable
+	WNStats& operator=( const WNStats&);
+
+	friend class WNQuery; // fills in m_times, m_counts while loading
+
+	struct Histogram
+	{
+		std::atomic<unsigned long long>	sum;		///< nanoseconds
+		std::atomic<unsigned long long>	buckets[Buckets];
+	};
+
+	/// Counters of one shard, followed by a cache line of padding
+	struct Shard
+	{
+		Histogram	hist[QueryTypes];
+		char		pad[64];
+	};
+
+	/// Histogram of a query type added up over the shards (the count is the sum of the buckets)
+	struct Totals
+	{
+		unsigned long long	count;
+		unsigned long long	sum;
+		unsigned long long	buckets[Buckets];
+	};
+	void	totals( QueryType q, Totals& t) const;
+
+	LoadTimes			m_times;
+	LoadCounts			m_counts;
+	std::atomic<bool>	m_timing;
+	mutable Shard		m_shards[Shards];
+};
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __WNSTATS_H__
@@ -0,0 +1,274 @@
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include "WNXMLGenerator.h"
+
+namespace LibWNXML {
+
+
+namespace {
+
+const size_t npos = size_t( -1);
+
+const char* const PosNames[4] = { "n", "v", "a", "b" };
+
+/// Symmetric relation of each POS
+const char* const SymmetricRelations[4] = { "near_antonym", "near_antonym", "similar_to", "near_antonym" };
+
+/// Syllables of literals (32 of them, some with ISO-8859-2 accented letters)
+const char* const Syllables[32] = {
+	"ka", "to", "ma", "ne", "ri", "lo", "se", "bu",
+	"da", "fe", "gi", "ho", "ja", "ko", "le", "mi",
+	"no", "pa", "re", "si", "ta", "vo", "za", "ber",
+	"\xe1l", "\xe9k", "\xf6r", "\xfcn", "k\xf5", "t\xfb", "r\xed", "s\xf3"
+};
+
+/// Upper limit of uniformly distributed counts with the given mean (counts are 1..limit)
+size_t count_limit( double mean)
+{
+	return std::max( size_t( 1), size_t( 2.0 * mean - 1.0 + 0.5));
+}
+
+} // namespace {
+
+
+/// Random number generator (splitmix64): the same numbers on every platform
+class WNXMLGenerator::Random
+{
+public:
+	explicit Random( unsigned long long seed)
+		: m_state( seed)
+	{}
+
+	unsigned long long	next()
+	{
+		unsigned long long z = (m_state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	/// Uniform in 0..n-1 (n > 0)
+	size_t	below( size_t n)	{ return size_t( next() % n); }
+
+	/// Uniform in [0,1)
+	double	uniform()			{ return double( next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+	unsigned long long	m_state;
+};
+
+
+WNXMLGenerator::Params::Params()
+	: maxDepth( 12)
+	, fanout( 4.0)
+	, multiParent( 0.02)
+	, symmetric( 0.05)
+	, synonyms( 1.8)
+	, sensesExponent( 3.0)
+	, maxSenses( 50)
+	, glossWords( 10.0)
+	, seed( 1)
+	, idPrefix( "SYN")
+{
+	synsets[0] = 30000;
+	synsets[1] = 8000;
+	synsets[2] = 3500;
+	synsets[3] = 600;
+}
+
+
+WNXMLGenerator::WNXMLGenerator( const Params& params)
+	: m_params( params)
+	, m_scramble( 0)
+{
+	if (params.fanout < 1.0 || params.synonyms < 1.0 || params.maxSenses < 1) {
+		ML_THROW_EXC( "fanout, synonyms and maxSenses must be at least 1", WNXMLGeneratorException);
+	}
+	if (params.multiParent < 0.0 || params.multiParent > 1.0 || params.symmetric < 0.0 || params.symmetric > 1.0) {
+		ML_THROW_EXC( "multiParent and symmetric must be between 0 and 1", WNXMLGeneratorException);
+	}
+	if (params.sensesExponent < 0.0 || params.glossWords < 0.0) {
+		ML_THROW_EXC( "sensesExponent and glossWords must not be negative", WNXMLGeneratorException);
+	}
+
+	// sense counts
+	double sum = 0.0;
+	for (unsigned k=1; k<=params.maxSenses; k++) {
+		sum += pow( double( k), -params.sensesExponent);
+		m_senses.push_back( sum);
+	}
+
+	// word numbers: at most one literal per literal slot of a POS
+	size_t maxwords = 1;
+	for (size_t p=0; p!=4; p++)
+		maxwords = std::max( maxwords, params.synsets[p] * count_limit( params.synonyms));
+	while (m_scramble < 62 && (size_t( 1) << m_scramble) < maxwords)
+		m_scramble++;
+
+	// words of definitions: Zipf distribution (exponent 1) over a vocabulary of literals
+	size_t nglosswords = std::min( maxwords, size_t( 50000));
+	sum = 0.0;
+	for (size_t r=1; r<=nglosswords; r++) {
+		sum += 1.0 / double( r);
+		m_glosswords.push_back( sum);
+	}
+}
+
+
+void WNXMLGenerator::write( std::ostream& os) const
+{
+	os << "<?xml version=\"1.0\" encoding=\"ISO-8859-2\"?>\n<WNXML>\n";
+	for (size_t p=0; p!=4; p++) {
+		// (each POS has its own random numbers, so changing the size of one doesn't change the others)
+		Random rnd( m_params.seed * 4 + p);
+		write_pos( p, rnd, os);
+	}
+	os << "</WNXML>\n";
+}
+
+
+void WNXMLGenerator::write( const std::string& filename) const
+{
+	std::ofstream os( filename.c_str(), std::ios::out | std::ios::binary);
+	if (!os) {
+		ML_THROW_EXC( "Could not open file: " << filename, WNXMLGeneratorException);
+	}
+	write( os);
+	os.close();
+	if (!os) {
+		ML_THROW_EXC( "Error writing file: " << filename, WNXMLGeneratorException);
+	}
+}
+
+
+void WNXMLGenerator::write_pos( size_t p, Random& rnd, std::ostream& os) const
+{
+	const size_t n = m_params.synsets[p];
+	if (n == 0)
+		return;
+
+	// hypernym forest, breadth-first (synsets are numbered in the order they are created,
+	// so hypernyms always have lower numbers, and a level not below those of their hyponyms)
+	std::vector<unsigned> level( n, 0);
+	std::vector<size_t> parent( n, npos), parent2( n, npos), sym( n, npos);
+	const size_t maxhypo = count_limit( m_params.fanout);
+	size_t next = 0, head = 0;
+	while (next != n) {
+		if (head == next) { // nothing to extend: new top synset
+			next++;
+			continue;
+		}
+		size_t h = head++;
+		if (level[h] >= m_params.maxDepth)
+			continue;
+		size_t k = 1 + rnd.below( maxhypo);
+		for (size_t j=0; j!=k && next!=n; j++, next++) {
+			level[next] = level[h] + 1;
+			parent[next] = h;
+		}
+	}
+
+	// second hypernyms from a level above, symmetric relations
+	for (size_t i=0; i!=n; i++) {
+		if (parent[i] != npos && rnd.uniform() < m_params.multiParent) {
+			for (int tries=0; tries!=8; tries++) {
+				size_t j = rnd.below( i);
+				if (level[j] < level[i] && j != parent[i]) {
+					parent2[i] = j;
+					break;
+				}
+			}
+		}
+		if (n > 1 && rnd.uniform() < m_params.symmetric) {
+			size_t j = rnd.below( n - 1);
+			sym[i] = j < i ? j : j + 1;
+		}
+	}
+
+	// literals: draw the number of senses of each word, and spread the senses over the literal slots of the synsets
+	const size_t maxsyn = count_limit( m_params.synonyms);
+	std::vector<size_t> nlits( n);
+	size_t nslots = 0;
+	for (size_t i=0; i!=n; i++)
+		nslots += nlits[i] = 1 + rnd.below( maxsyn);
+	std::vector<size_t> slots;
+	slots.reserve( nslots);
+	for (size_t w=0; slots.size() != nslots; w++) {
+		size_t k = 1 + draw( m_senses, rnd);
+		for (size_t j=0; j!=k && slots.size()!=nslots; j++)
+			slots.push_back( w);
+	}
+	for (size_t i=nslots-1; i>0; i--)
+		std::swap( slots[i], slots[rnd.below( i + 1)]);
+
+	// write synsets
+	const size_t maxgloss = count_limit( m_params.glossWords);
+	std::vector<unsigned> senses( nslots, 0);
+	std::vector<size_t> lits;
+	std::string w;
+	char fill = os.fill( '0');
+	size_t slot = 0;
+	for (size_t i=0; i!=n; i++) {
+		os << "<SYNSET><ID>" << m_params.idPrefix << "-" << std::setw( 8) << i << "-" << PosNames[p]
+			<< "</ID><POS>" << PosNames[p] << "</POS><SYNONYM>";
+		lits.clear();
+		for (size_t j=0; j!=nlits[i]; j++, slot++) {
+			// a literal can occur only once in a synset: swap with a later slot
+			for (int tries=0; tries!=4 && slot+1 != nslots && std::find( lits.begin(), lits.end(), slots[slot]) != lits.end(); tries++)
+				std::swap( slots[slot], slots[slot + 1 + rnd.below( nslots - slot - 1)]);
+			size_t l = slots[slot];
+			if (std::find( lits.begin(), lits.end(), l) != lits.end())
+				continue;
+			lits.push_back( l);
+			word( l, w);
+			os << "<LITERAL>" << w << "<SENSE>" << ++senses[l] << "</SENSE></LITERAL>";
+		}
+		os << "</SYNONYM>";
+		if (parent[i] != npos)
+			os << "<ILR>" << m_params.idPrefix << "-" << std::setw( 8) << parent[i] << "-" << PosNames[p] << "<TYPE>hypernym</TYPE></ILR>";
+		if (parent2[i] != npos)
+			os << "<ILR>" << m_params.idPrefix << "-" << std::setw( 8) << parent2[i] << "-" << PosNames[p] << "<TYPE>hypernym</TYPE></ILR>";
+		if (sym[i] != npos)
+			os << "<ILR>" << m_params.idPrefix << "-" << std::setw( 8) << sym[i] << "-" << PosNames[p] << "<TYPE>" << SymmetricRelations[p] << "</TYPE></ILR>";
+		if (m_params.glossWords > 0.0) {
+			os << "<DEF>";
+			size_t nwords = 1 + rnd.below( maxgloss);
+			for (size_t j=0; j!=nwords; j++) {
+				word( draw( m_glosswords, rnd), w);
+				if (j != 0)
+					os << ' ';
+				os << w;
+			}
+			os << "</DEF>";
+		}
+		os << "</SYNSET>\n";
+	}
+	os.fill( fill);
+}
+
+
+void WNXMLGenerator::word( size_t i, std::string& w) const
+{
+	// scramble the number (multiplying by an odd number is a permutation of 0..2^bits-1),
+	// so that frequent words don't all start the same, then write its base 32 digits as syllables
+	unsigned long long mask = (1ULL << m_scramble) - 1;
+	unsigned long long x = ((i + 1) * 0x9E3779B97F4A7C15ULL) & mask;
+	// (at least two syllables; the syllables can be told apart from left to right, so different numbers give different words)
+	w.clear();
+	for (unsigned s=0; s<2 || x!=0; s++, x >>= 5)
+		w += Syllables[x & 31];
+}
+
+
+size_t WNXMLGenerator::draw( const std::vector<double>& cumulative, Random& rnd)
+{
+	double u = rnd.uniform() * cumulative.back();
+	size_t r = size_t( std::upper_bound( cumulative.begin(), cumulative.end(), u) - cumulative.begin());
+	return std::min( r, cumulative.size() - 1);
+}
+
+
+} // namespace LibWNXML {
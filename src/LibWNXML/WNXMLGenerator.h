@@ -0,0 +1,81 @@
+#ifndef __WNXMLGENERATOR_H__
+#define __WNXMLGENERATOR_H__
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "../MLUtils/Exception.h"
+
+namespace LibWNXML {
+
+/// Exception for invalid generator parameters and output errors
+ML_EXCEPTION( WNXMLGeneratorException);
+
+/// Writes a synthetic WordNet in the WNXML format read by WNQuery, for testing and benchmarking
+/// at sizes the real wordnets don't have.
+///
+/// Every POS gets a hypernym forest built breadth-first: each synset above maxDepth gets 1..2*fanout-1
+/// hyponyms, and a new top synset is started when there is no synset left to extend. A fraction of the synsets
+/// get a second hypernym from a level above their own (so the hierarchy stays acyclic), and a fraction get
+/// a symmetric relation (near_antonym, similar_to for adjectives) to a random synset. Only one direction of the
+/// relations is written, WNQuery adds the inverses when loading.
+/// The number of senses of literals follows a power law (P(k) ~ k^-sensesExponent, up to maxSenses), so most
+/// literals have one sense and a few have many, as in real wordnets; the senses are spread over the synsets
+/// at random. Definitions are made of words drawn with a Zipf distribution.
+///
+/// The output depends only on the parameters (including the seed): the random numbers are generated
+/// by the class itself, not by the standard library, whose distributions differ between implementations.
+class WNXMLGenerator
+{
+public:
+
+	struct Params
+	{
+		size_t				synsets[4];		///< number of synsets of each POS: nouns, verbs, adjectives, adverbs
+		unsigned			maxDepth;		///< number of hypernym levels below the top synsets
+		double				fanout;			///< mean number of hyponyms of synsets above maxDepth (at least 1)
+		double				multiParent;	///< fraction of synsets with a second hypernym (0..1)
+		double				symmetric;		///< fraction of synsets with a symmetric relation (0..1)
+		double				synonyms;		///< mean number of literals of a synset (at least 1)
+		double				sensesExponent;	///< exponent of the distribution of the number of senses of literals (0: uniform)
+		unsigned			maxSenses;		///< maximum number of senses of a literal (at least 1)
+		double				glossWords;		///< mean number of words of definitions (0: no definitions)
+		unsigned long long	seed;
+		std::string			idPrefix;		///< ids are <idPrefix>-<8 digit number>-<pos>
+
+		/// Default parameters: about the size and shape of HuWN
+		Params();
+	};
+
+	/// @exception WNXMLGeneratorException for invalid parameters
+	explicit WNXMLGenerator( const Params& params) throw(WNXMLGeneratorException);
+
+	/// Write the WordNet (ISO-8859-2 encoded XML) to os
+	void	write( std::ostream& os) const;
+
+	/// Write the WordNet to file
+	/// @exception WNXMLGeneratorException if the file can't be written
+	void	write( const std::string& filename) const throw(WNXMLGeneratorException);
+
+private:
+	class Random;
+
+	/// Write the synsets of a POS
+	void	write_pos( size_t p, Random& rnd, std::ostream& os) const;
+
+	/// Word number i (different i give different words)
+	void	word( size_t i, std::string& w) const;
+
+	/// Draw from a distribution given by cumulative weights: index of the weight
+	static size_t	draw( const std::vector<double>& cumulative, Random& rnd);
+
+	Params				m_params;
+	std::vector<double>	m_senses;		///< cumulative weights of sense counts 1..maxSenses
+	std::vector<double>	m_glosswords;	///< cumulative Zipf weights of the words of definitions
+	unsigned			m_scramble;		///< bits of the permutation scrambling word numbers
+};
+
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __WNXMLGENERATOR_H__
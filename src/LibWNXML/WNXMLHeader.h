@@ -1,13 +1,13 @@
-#ifndef __WNXMLHEADER__H__	
-#define __WNXMLHEADER__H__	
-
-#include <string>
-
-namespace LibWNXML {
-
-const std::string XMLdecl = "<?xml version=\"1.0\" encoding=\"ISO-8859-2\"?>\n";
-const std::string XMLdoctypedecl = "<!DOCTYPE WNXML SYSTEM \"wnxml.dtd\">\n";
-
-} // namespace LibWNXML {
-
-#endif // #ifndef __WNXMLHEADER__H__	
+#ifndef __WNXMLHEADER__H__	
+#define __WNXMLHEADER__H__	
+
+#include <string>
+
+namespace LibWNXML {
+
+const std::string XMLdecl = "<?xml version=\"1.0\" encoding=\"ISO-8859-2\"?>\n";
+const std::string XMLdoctypedecl = "<!DOCTYPE WNXML SYSTEM \"wnxml.dtd\">\n";
+
+} // namespace LibWNXML {
+
+#endif // #ifndef __WNXMLHEADER__H__	
@@ -1,380 +1,547 @@
-#include "../CharConverter/CharConverter.h"
-#include "../CharConverter/EncodingNames.h"
-
-#include "WNXMLParser.h"
-
-namespace LibWNXML {
-
-
-WNXMLParser::WNXMLParser( std::string OutCharEnc)
-	: m_startroot( false)
-	, m_endroot(false)
-{
-	// Set up character encoding converter
-	// set output encoding
-	ML::CharEncoding outenc;
-	outenc.ext = ML::CharEncoding::XT_CHREF_NORM;
-	outenc.enc = ML::EncodingNames::getEncoding( OutCharEnc.c_str());
-	// check it
-	if (outenc.enc == ML::CharEncoding::UNKNOWN) {
-		ML_THROW_EXC( "Unknown character encoding '" << OutCharEnc << "' passed to WNXMLParser::WNXMLParser", WNXMLParserException);
-	}
-	// input encoding (UTF-8)
-	ML::CharEncoding inenc;
-	inenc.ext = ML::CharEncoding::XT_NONE;
-	inenc.enc = ML::CharEncoding::UTF_8;
-	// create enc. converter
-	m_cconv = ML::CharConverter::create( inenc, outenc);
-}
-
-
-void WNXMLParser::parseXMLSynset( std::istream& is, Synset& syns, int& linenum)
-{
-	m_done = -1;
-	m_syns = &syns;
-	m_syns->clear();
-	
-	m_lcnt = linenum;
-	while (!is.eof() && (m_done != 1)) {
-		std::getline( is, m_line);
-		m_lcnt++;
-		linenum = m_lcnt;
-		// VisDic XML format fault tolerance (no root tag):
-		if (!m_startroot && m_line.find("<WNXML>") != m_line.npos)
-			m_startroot = true;
-		if (!m_startroot && m_line.find("<SYNSET>") != m_line.npos) {
-			parse_chunk( "<WNXML>"); // fool parser
-			m_startroot = true;
-		}
-		if (m_line.find("</WNXML>") != m_line.npos)
-			m_endroot = true;
-		// call the libxml++ SaxParser for this line
-		try {
-			parse_chunk( m_line);
-		}
-		catch (const WNXMLParserException& e) {
-			ML_THROW_EXC( "Parser error on input line # " << linenum << ":\n" << m_line << std::endl << e.what(), WNXMLParserException);
-		}
-	}
-	
-	if (m_done == 0) // reached eof before end of segment
-		ML_THROW_EXC( "Warning: end of file reached before </SYNSET>, possibly corrupt input", 
-						WNXMLParserException);
-
-}
-
-
-void	WNXMLParser::finishParsing()
-{ 
-	// VisDic XML format fault tolerance (no root tag):
-	if (!m_endroot)
-		parse_chunk("</WNXML>"); // fool parser
-	// this has to be called for whatever reason (see libxml++ API doc)
-	finish_chunk_parsing(); 
-}
-
-void WNXMLParser::on_start_element(const std::string& name,
-                                   const AttributeList& attrs)
-{
-#ifdef _LOGPARSE
-	std::cout << m_lcnt << ": ";
-	print_path( std::cout);
-	std::cout << "/START: " << name << std::endl;
-#endif
-
-	m_ppath.push_back( name);
-
-	if (m_done == 1) // already parsed a synset
-		return;
-
-	std::string parent   = getParent();
-	std::string gparent  = getNParent( getPos()-2);
- 
-	if (name == "SYNSET")
-		m_done = 0;
-
-	else
-	if (name == "LITERAL" && parent == "SYNONYM" && gparent == "SYNSET")
-		m_syns->synonyms.push_back( Synset::Synonym( "", "", ""));
-
-	else
-	if (name == "ILR" && parent == "SYNSET")
-		m_syns->ilrs.push_back( std::make_pair( "", ""));
-
-	else
-	if (name == "USAGE" && parent == "SYNSET")
-		m_syns->usages.push_back( "");
-
-	else
-	if (name == "SNOTE" && parent == "SYNSET")
-		m_syns->snotes.push_back( "");
-
-	else
-	if (name == "SUMO" && parent == "SYNSET")
-		m_syns->sumolinks.push_back( std::make_pair( "", ""));
-
-	else
-	if (name == "EQ_NEAR_SYNONYM" && parent == "SYNSET")
-		m_syns->elrs.push_back( std::make_pair( "", "eq_near_synonym"));		
-
-	else
-	if (name == "EQ_HYPERNYM" && parent == "SYNSET")
-		m_syns->elrs.push_back( std::make_pair( "", "eq_has_hypernym"));
-
-	else
-	if (name == "EQ_HYPONYM" && parent == "SYNSET")
-		m_syns->elrs.push_back( std::make_pair( "", "eq_has_hyponym"));
-
-	else
-	if (name == "ELR" && parent == "SYNSET")
-		m_syns->elrs.push_back( std::make_pair( "", ""));
-
-	else
-	if (name == "EKSZ" && parent == "SYNSET")
-		m_syns->ekszlinks.push_back( std::make_pair( "", ""));
-
-	else
-	if (name == "VFRAME" && parent == "SYNSET")
-		m_syns->vframelinks.push_back( std::make_pair( "", ""));
-
-}
-
-
-void WNXMLParser::on_characters(const std::string& _text)
-{
-	// convert from UTF-8 to user-specified enc.
-	std::string text;
-	m_cconv->convert( _text, text);
-
-#ifdef _LOGPARSE
-	std::cout << m_lcnt << ": ";
-	print_path( std::cout);	
-	std::cout << "/#PCDATA: " << text << std::endl;
-#endif
-
-	if (m_done == 1 || m_done == -1)
-		return;
-
-	m_ppath.push_back( "#PCDATA");
-
-	std::string parent   = getParent();
-	std::string gparent  = getNParent( getPos()-2);
-	std::string ggparent = getNParent( getPos()-3);
-
-	if (parent == "ID" && gparent == "SYNSET") { // SYNSET/ID
-		m_syns->id += text;
-	}
-
-	else
-	if (parent == "POS" && gparent == "SYNSET") { // SYNSET/POS
-		m_syns->pos += text;
-	}
-
-	else
-	if (parent == "LITERAL" && gparent == "SYNONYM") { // SYNSET/SYNONYM/LITERAL
-		if (m_syns->synonyms.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: synonyms empty at LITERAL tag", WNXMLParserException);
-		}
-		m_syns->synonyms.back().literal += text;
-	}
-
-	else
-	if (parent == "SENSE" && gparent == "LITERAL" && ggparent == "SYNONYM") { // SYNSET/SYNONYM/LITERAL/SENSE
-		if (m_syns->synonyms.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: synonyms empty at SENSE tag", WNXMLParserException);
-		}
-		m_syns->synonyms.back().sense += text;
-	}
-
-	else
-	if (parent == "LNOTE" && gparent == "LITERAL" && ggparent == "SYNONYM") { // SYNSET/SYNONYM/LITERAL/LNOTE
-		if (m_syns->synonyms.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: synonyms empty at LNOTE tag", WNXMLParserException);
-		}
-		m_syns->synonyms.back().lnote += text;
-	}
-
-	else
-	if (parent == "NUCLEUS" && gparent == "LITERAL" && ggparent == "SYNONYM") { // SYNSET/SYNONYM/LITERAL/NUCLEUS
-		if (m_syns->synonyms.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: synonyms empty at NUCLEUS tag", WNXMLParserException);
-		}
-		m_syns->synonyms.back().nucleus += text;
-	}
-
-	else
-	if (parent == "ILR" && gparent == "SYNSET") { // SYNSET/ILR
-		if (m_syns->ilrs.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: ilrs empty at ILR tag", WNXMLParserException);
-		}
-		m_syns->ilrs.back().first += text;
-	}
-
-	else
-	if (parent == "TYPE" && gparent == "ILR") { // SYNSET/ILR/TYPE
-		if (m_syns->ilrs.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: ilrs empty at ILR/TYPE tag", WNXMLParserException);
-		}
-		m_syns->ilrs.back().second += text;
-	}
-
-	else
-	if (parent == "DEF" && gparent == "SYNSET") // SYNSET/DEF
-		m_syns->def += text;
-
-	else
-	if (parent == "BCS" && gparent == "SYNSET") { // SYNSET/BCS
-		m_syns->bcs += text;
-	}
-
-	else
-	if (parent == "USAGE" && gparent == "SYNSET") { // SYNSET/USAGE 
-		if (m_syns->usages.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: usages empty at USAGE tag", WNXMLParserException);
-		}
-		m_syns->usages.back() += text;
-	}
-
-	else
-	if (parent == "SNOTE" && gparent == "SYNSET") { // SYNSET/SNOTE 
-		if (m_syns->snotes.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: snotes empty at SNOTE tag", WNXMLParserException);
-		}
-		m_syns->snotes.back() += text;
-	}
-
-	else
-	if (parent == "STAMP" && gparent == "SYNSET") { // SYNSET/STAMP 
-		m_syns->stamp += text;
-	}
-
-	else
-	if (parent == "DOMAIN" && gparent == "SYNSET") { // SYNSET/STAMP 
-		m_syns->domain += text;
-	}
-
-	else
-	if (parent == "SUMO" && gparent == "SYNSET") { // SYNSET/SUMO
-		if (m_syns->sumolinks.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: sumolinks empty at SUMO tag", WNXMLParserException);
-		}
-		m_syns->sumolinks.back().first += text;
-	}
-
-	else
-	if (parent == "TYPE" && gparent == "SUMO") { // SYNSET/SUMO/TYPE
-		if (m_syns->sumolinks.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: sumolinks empty at SUMO/TYPE tag", WNXMLParserException);
-		}
-		m_syns->sumolinks.back().second += text;
-	}
-
-	else
-	if (parent == "NL" && gparent == "SYNSET") { // SYNSET/NL 
-		m_syns->nl += text;
-	}
-
-	else
-	if (parent == "TNL" && gparent == "SYNSET") { // SYNSET/TNL 
-		m_syns->tnl += text;
-	}
-
-	else
-	if (parent == "EQ_NEAR_SYNONYM" && gparent == "SYNSET") { // SYNSET/EQ_NEAR_SYNONYM 
-		if (m_syns->elrs.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: elrs empty at EQ_NEAR_SYNONYM tag", WNXMLParserException);
-		}
-		m_syns->elrs.back().first += text;
-	}
-
-	else
-	if (parent == "EQ_HYPERNYM" && gparent == "SYNSET") { // SYNSET/EQ_HYPERNYM 
-		if (m_syns->elrs.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: elrs empty at EQ_HYPERNYM tag", WNXMLParserException);
-		}
-		m_syns->elrs.back().first += text;
-	}
-
-	else
-	if (parent == "EQ_HYPONYM" && gparent == "SYNSET") { // SYNSET/EQ_HYPONYM 
-		if (m_syns->elrs.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: elrs empty at EQ_HYPONYM tag", WNXMLParserException);
-		}		
-		m_syns->elrs.back().first += text;
-	}
-
-	else
-	if (parent == "ELR" && gparent == "SYNSET") { // SYNSET/ELR
-		if (m_syns->elrs.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: elrs empty at ELR tag", WNXMLParserException);
-		}
-		m_syns->elrs.back().first += text;
-	}
-
-	else
-		if (parent == "TYPE" && gparent == "ELR") { // SYNSET/ELR/TYPE
-		if (m_syns->elrs.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: elrs empty at ELR/TYPE tag", WNXMLParserException);
-		}
-		m_syns->elrs.back().second += text;
-	}
-
-	else
-	if (parent == "EKSZ" && gparent == "SYNSET") { // SYNSET/EKSZ
-		if (m_syns->ekszlinks.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: ekszlinks empty at EKSZ tag", WNXMLParserException);
-		}
-		m_syns->ekszlinks.back().first += text;
-	}
-
-	else
-		if (parent == "TYPE" && gparent == "EKSZ") { // SYNSET/EKSZ/TYPE
-		if (m_syns->ekszlinks.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: ekszlinks empty at EKSZ/TYPE tag", WNXMLParserException);
-		}
-		m_syns->ekszlinks.back().second += text;
-	}
-
-	else
-	if (parent == "VFRAME" && gparent == "SYNSET") { // SYNSET/VFRAME
-		if (m_syns->vframelinks.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: vframelinks empty at VFRAME tag", WNXMLParserException);
-		}
-		m_syns->vframelinks.back().first += text;
-	}
-
-	else
-		if (parent == "TYPE" && gparent == "VFRAME") { // SYNSET/VFRAME/TYPE
-		if (m_syns->vframelinks.empty()) {
-			ML_THROW_EXC( "WNXMLParser internal error: vframelinks empty at VFRAME/TYPE tag", WNXMLParserException);
-		}
-		m_syns->vframelinks.back().second += text;
-	}
-
-	m_ppath.pop_back();
-}
-
-
-void WNXMLParser::on_end_element(const std::string& name)
-{
-#ifdef _LOGPARSE
-	std::cout << m_lcnt << ": ";
-	print_path( std::cout);	
-	std::cout << "/END: " << name << std::endl;
-#endif
-
-	if (m_done  == 1)
-		return;
-
-	if (name == "SYNSET") { // SYNSET
-		if (m_done == -1) {
-			ML_THROW_EXC( "This is impossible!\nThe parser should've caught this error: 'SYNSET' end tag without previous begin tag", WNXMLParserException);
-		}
-		m_done = 1;
-	}
-
-	m_ppath.pop_back();
-}
-
-
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+#include "../CharConverter/CharConverter.h"
+#include "../CharConverter/EncodingNames.h"
+
+#include "WNXMLParser.h"
+
+namespace LibWNXML {
+
+
+WNXMLParser::WNXMLParser( std::string OutCharEnc)
+	: m_lcnt( 0)
+	, m_blocksize( 0)
+	, m_blockstarted( false)
+	, m_blocklines( 0)
+	, m_blockstart( 1)
+	, m_done( -1)
+	, m_syns( NULL)
+	, m_utf8out( false)
+	, m_field( NULL)
+	, m_startroot( false)
+	, m_endroot(false)
+{
+	// Set up character encoding converter
+	// set output encoding
+	ML::CharEncoding outenc;
+	outenc.ext = ML::CharEncoding::XT_CHREF_NORM;
+	outenc.enc = ML::EncodingNames::getEncoding( OutCharEnc.c_str());
+	// check it
+	if (outenc.enc == ML::CharEncoding::UNKNOWN) {
+		ML_THROW_EXC( "Unknown character encoding '" << OutCharEnc << "' passed to WNXMLParser::WNXMLParser", WNXMLParserException);
+	}
+	// input encoding (UTF-8)
+	ML::CharEncoding inenc;
+	inenc.ext = ML::CharEncoding::XT_NONE;
+	inenc.enc = ML::CharEncoding::UTF_8;
+	// create enc. converter
+	m_cconv = ML::CharConverter::create( inenc, outenc);
+	m_utf8out = (outenc.enc == ML::CharEncoding::UTF_8);
+}
+
+
+bool WNXMLParser::isASCII( const char* text, size_t len)
+{
+	size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	// 16 bytes at a time: movemask collects the high bits
+	for (; i + 16 <= len; i += 16)
+		if (_mm_movemask_epi8( _mm_loadu_si128( (const __m128i*) (text + i))) != 0)
+			return false;
+#endif
+	// 8 bytes at a time
+	const unsigned long long high = 0x8080808080808080ULL;
+	for (; i + 8 <= len; i += 8) {
+		unsigned long long w;
+		memcpy( &w, text + i, 8);
+		if (w & high)
+			return false;
+	}
+	for (; i < len; i++)
+		if ((unsigned char) text[i] & 0x80)
+			return false;
+	return true;
+}
+
+
+void WNXMLParser::parseXMLSynset( std::istream& is, Synset& syns, int& linenum)
+{
+	if (m_blocksize != 0) { // block-buffered mode
+		syns.clear();
+		if (!m_blockstarted) {
+			m_blockstarted = true;
+			m_lcnt = linenum;
+			m_done = -1;
+			m_cur.clear();
+			m_syns = &m_cur; // the SAX callbacks fill this, completed synsets are moved to m_ready
+		}
+		while (m_ready.empty() && !is.eof())
+			readBlock( is);
+		if (!m_ready.empty()) {
+			std::swap( syns, m_ready.front().first);
+			linenum = m_ready.front().second;
+			m_ready.pop_front();
+		}
+		else {
+			linenum = m_lcnt;
+			if (m_done == 0) // reached eof before end of segment
+				ML_THROW_EXC( "Warning: end of file reached before </SYNSET>, possibly corrupt input", 
+								WNXMLParserException);
+		}
+		return;
+	}
+
+	m_done = -1;
+	m_syns = &syns;
+	m_syns->clear();
+	
+	m_lcnt = linenum;
+	while (!is.eof() && (m_done != 1)) {
+		std::getline( is, m_line);
+		m_lcnt++;
+		linenum = m_lcnt;
+		// VisDic XML format fault tolerance (no root tag):
+		if (!m_startroot && m_line.find("<WNXML>") != m_line.npos)
+			m_startroot = true;
+		if (!m_startroot && m_line.find("<SYNSET>") != m_line.npos) {
+			parse_chunk( "<WNXML>"); // fool parser
+			m_startroot = true;
+		}
+		if (m_line.find("</WNXML>") != m_line.npos)
+			m_endroot = true;
+		// call the libxml++ SaxParser for this line
+		try {
+			parse_chunk( m_line);
+		}
+		catch (const WNXMLParserException& e) {
+			ML_THROW_EXC( "Parser error on input line # " << linenum << ":\n" << m_line << std::endl << e.what(), WNXMLParserException);
+		}
+	}
+	
+	if (m_done == 0) // reached eof before end of segment
+		ML_THROW_EXC( "Warning: end of file reached before </SYNSET>, possibly corrupt input", 
+						WNXMLParserException);
+
+}
+
+
+void WNXMLParser::readBlock( std::istream& is)
+{
+	// read a block, after what was left over from the previous one
+	std::string block;
+	block.swap( m_carry);
+	size_t old = block.size();
+	block.resize( old + m_blocksize);
+	is.read( &block[old], std::streamsize( m_blocksize));
+	block.resize( old + size_t( is.gcount()));
+
+	// cut after the last </SYNSET>, so that no synset (or tag) is split between blocks
+	if (!is.eof()) {
+		size_t p = block.rfind( "</SYNSET>");
+		if (p == block.npos) { // no complete synset yet, read on next time
+			m_carry.swap( block);
+			return;
+		}
+		m_carry.assign( block, p + 9, block.npos);
+		block.resize( p + 9);
+	}
+
+	// line numbers of the synset ends in this block (the SAX parser will reach them in this order)
+	int line = m_lcnt + 1;
+	size_t prev = 0;
+	for (size_t p = block.find( "</SYNSET>"); p != block.npos; p = block.find( "</SYNSET>", p + 9)) {
+		line += int( std::count( block.begin() + prev, block.begin() + p, '\n'));
+		prev = p;
+		m_endlines.push_back( line);
+	}
+	m_blocklines = line - m_lcnt - 1 + int( std::count( block.begin() + prev, block.end(), '\n'));
+
+	// VisDic XML format fault tolerance (no root tag):
+	size_t fool = block.npos; // where to insert a root tag
+	if (!m_startroot && block.find("<WNXML>") != block.npos)
+		m_startroot = true;
+	if (!m_startroot) {
+		fool = block.find("<SYNSET>");
+		if (fool != block.npos)
+			m_startroot = true;
+	}
+	if (block.find("</WNXML>") != block.npos)
+		m_endroot = true;
+
+	// call the libxml++ SaxParser for the whole block
+	m_blockstart = parserLine();
+	try {
+		if (fool != block.npos) {
+			if (fool != 0)
+				parse_chunk( block.substr( 0, fool));
+			parse_chunk( "<WNXML>"); // fool parser
+			parse_chunk( block.substr( fool));
+		}
+		else
+			parse_chunk( block);
+	}
+	catch (const WNXMLParserException& e) {
+		ML_THROW_EXC( "Parser error on " << where() << ":\n" << e.what(), WNXMLParserException);
+	}
+	m_lcnt += m_blocklines;
+}
+
+
+std::string WNXMLParser::where() const
+{
+	std::ostringstream os;
+	if (m_blocksize == 0)
+		os << "input line " << m_lcnt;
+	else
+		os << "input line " << m_lcnt + 1 + std::min( std::max( parserLine() - m_blockstart, 0), m_blocklines);
+	return os.str();
+}
+
+
+int WNXMLParser::parserLine() const
+{
+	if (context_ == NULL || context_->input == NULL)
+		return 1;
+	return context_->input->line;
+}
+
+
+void	WNXMLParser::finishParsing()
+{ 
+	// VisDic XML format fault tolerance (no root tag):
+	if (!m_endroot)
+		parse_chunk("</WNXML>"); // fool parser
+	// this has to be called for whatever reason (see libxml++ API doc)
+	finish_chunk_parsing(); 
+}
+
+
+const WNXMLParser::TagName WNXMLParser::TagNames[] = {
+	{ "BCS", T_BCS }, { "DEF", T_DEF }, { "DOMAIN", T_DOMAIN }, { "EKSZ", T_EKSZ }, { "ELR", T_ELR },
+	{ "EQ_HYPERNYM", T_EQ_HYPERNYM }, { "EQ_HYPONYM", T_EQ_HYPONYM }, { "EQ_NEAR_SYNONYM", T_EQ_NEAR_SYNONYM },
+	{ "ID", T_ID }, { "ILR", T_ILR }, { "LITERAL", T_LITERAL }, { "LNOTE", T_LNOTE }, { "NL", T_NL },
+	{ "NUCLEUS", T_NUCLEUS }, { "POS", T_POS }, { "SENSE", T_SENSE }, { "SNOTE", T_SNOTE }, { "STAMP", T_STAMP },
+	{ "SUMO", T_SUMO }, { "SYNONYM", T_SYNONYM }, { "SYNSET", T_SYNSET }, { "TNL", T_TNL }, { "TYPE", T_TYPE },
+	{ "USAGE", T_USAGE }, { "VFRAME", T_VFRAME }, { "WNXML", T_WNXML }
+};
+
+
+WNXMLParser::eTag WNXMLParser::tagID( const std::string& name)
+{
+	static_assert( sizeof(TagNames) / sizeof(TagNames[0]) == T_COUNT - 1, "TagNames must list every tag except T_OTHER");
+	const char* n = name.c_str();
+	size_t lo = 0, hi = T_COUNT - 1;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		int c = strcmp( n, TagNames[mid].name);
+		if (c == 0)
+			return TagNames[mid].tag;
+		if (c < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return T_OTHER;
+}
+
+
+const char* WNXMLParser::tagName( unsigned char tag)
+{
+	for (size_t i=0; i!=T_COUNT - 1; i++)
+		if (TagNames[i].tag == tag)
+			return TagNames[i].name;
+	return "#OTHER";
+}
+
+
+WNXMLParser::DispatchTables::DispatchTables()
+{
+	memset( start, S_NONE, sizeof(start));
+	memset( text, X_NONE, sizeof(text));
+
+	// start actions: [element][parent]
+	// (SYNSET starts a synset under any parent; LITERAL also needs SYNSET as grandparent, checked in on_start_element)
+	for (int p=0; p!=T_COUNT; p++)
+		start[T_SYNSET][p]			= S_SYNSET;
+	start[T_LITERAL][T_SYNONYM]			= S_LITERAL;
+	start[T_ILR][T_SYNSET]				= S_ILR;
+	start[T_USAGE][T_SYNSET]			= S_USAGE;
+	start[T_SNOTE][T_SYNSET]			= S_SNOTE;
+	start[T_SUMO][T_SYNSET]				= S_SUMO;
+	start[T_EQ_NEAR_SYNONYM][T_SYNSET]	= S_EQ_NEAR_SYNONYM;
+	start[T_EQ_HYPERNYM][T_SYNSET]		= S_EQ_HYPERNYM;
+	start[T_EQ_HYPONYM][T_SYNSET]		= S_EQ_HYPONYM;
+	start[T_ELR][T_SYNSET]				= S_ELR;
+	start[T_EKSZ][T_SYNSET]				= S_EKSZ;
+	start[T_VFRAME][T_SYNSET]			= S_VFRAME;
+
+	// character data: [current element][its parent]
+	// (SENSE, LNOTE, NUCLEUS also need SYNONYM as grandparent, checked in on_characters)
+	text[T_ID][T_SYNSET]				= X_ID;
+	text[T_POS][T_SYNSET]				= X_POS;
+	text[T_LITERAL][T_SYNONYM]			= X_LITERAL;
+	text[T_SENSE][T_LITERAL]			= X_SENSE;
+	text[T_LNOTE][T_LITERAL]			= X_LNOTE;
+	text[T_NUCLEUS][T_LITERAL]			= X_NUCLEUS;
+	text[T_ILR][T_SYNSET]				= X_ILR;
+	text[T_TYPE][T_ILR]					= X_ILR_TYPE;
+	text[T_DEF][T_SYNSET]				= X_DEF;
+	text[T_BCS][T_SYNSET]				= X_BCS;
+	text[T_USAGE][T_SYNSET]				= X_USAGE;
+	text[T_SNOTE][T_SYNSET]				= X_SNOTE;
+	text[T_STAMP][T_SYNSET]				= X_STAMP;
+	text[T_DOMAIN][T_SYNSET]			= X_DOMAIN;
+	text[T_SUMO][T_SYNSET]				= X_SUMO;
+	text[T_TYPE][T_SUMO]				= X_SUMO_TYPE;
+	text[T_NL][T_SYNSET]				= X_NL;
+	text[T_TNL][T_SYNSET]				= X_TNL;
+	text[T_EQ_NEAR_SYNONYM][T_SYNSET]	= X_EQ_NEAR_SYNONYM;
+	text[T_EQ_HYPERNYM][T_SYNSET]		= X_EQ_HYPERNYM;
+	text[T_EQ_HYPONYM][T_SYNSET]		= X_EQ_HYPONYM;
+	text[T_ELR][T_SYNSET]				= X_ELR;
+	text[T_TYPE][T_ELR]					= X_ELR_TYPE;
+	text[T_EKSZ][T_SYNSET]				= X_EKSZ;
+	text[T_TYPE][T_EKSZ]				= X_EKSZ_TYPE;
+	text[T_VFRAME][T_SYNSET]			= X_VFRAME;
+	text[T_TYPE][T_VFRAME]				= X_VFRAME_TYPE;
+}
+
+
+const WNXMLParser::DispatchTables& WNXMLParser::tables()
+{
+	static const DispatchTables t;
+	return t;
+}
+
+
+void WNXMLParser::on_start_element(const std::string& name,
+                                   const AttributeList& attrs)
+{
+	unsigned char tag = tagID( name);
+
+#ifdef _LOGPARSE
+	std::cout << m_lcnt << ": ";
+	print_path( std::cout);
+	std::cout << "/START: " << name << std::endl;
+#endif
+
+	m_ppath.push_back( tag);
+
+	if (m_done == 1) // already parsed a synset
+		return;
+
+	flushText(); // before the vectors holding the field may grow
+
+	switch (tables().start[tag][getParent()]) {
+		case S_SYNSET:
+			m_done = 0;
+			break;
+		case S_LITERAL:
+			if (getNParent( getPos()-2) == T_SYNSET)
+				m_syns->synonyms.push_back( Synset::Synonym( "", "", ""));
+			break;
+		case S_ILR:
+			m_syns->ilrs.push_back( std::make_pair( "", ""));
+			break;
+		case S_USAGE:
+			m_syns->usages.push_back( "");
+			break;
+		case S_SNOTE:
+			m_syns->snotes.push_back( "");
+			break;
+		case S_SUMO:
+			m_syns->sumolinks.push_back( std::make_pair( "", ""));
+			break;
+		case S_EQ_NEAR_SYNONYM:
+			m_syns->elrs.push_back( std::make_pair( "", "eq_near_synonym"));
+			break;
+		case S_EQ_HYPERNYM:
+			m_syns->elrs.push_back( std::make_pair( "", "eq_has_hypernym"));
+			break;
+		case S_EQ_HYPONYM:
+			m_syns->elrs.push_back( std::make_pair( "", "eq_has_hyponym"));
+			break;
+		case S_ELR:
+			m_syns->elrs.push_back( std::make_pair( "", ""));
+			break;
+		case S_EKSZ:
+			m_syns->ekszlinks.push_back( std::make_pair( "", ""));
+			break;
+		case S_VFRAME:
+			m_syns->vframelinks.push_back( std::make_pair( "", ""));
+			break;
+	}
+}
+
+
+namespace {
+
+template <class V>
+void check_not_empty( const V& v, const char* what)
+{
+	if (v.empty()) {
+		ML_THROW_EXC( "WNXMLParser internal error: " << what, WNXMLParserException);
+	}
+}
+
+} // namespace {
+
+
+std::string* WNXMLParser::textField( eTextAction action)
+{
+	switch (action) {
+		case X_ID:		return &m_syns->id;
+		case X_POS:		return &m_syns->pos;
+		case X_LITERAL:
+			check_not_empty( m_syns->synonyms, "synonyms empty at LITERAL tag");
+			return &m_syns->synonyms.back().literal;
+		case X_SENSE:
+			check_not_empty( m_syns->synonyms, "synonyms empty at SENSE tag");
+			return &m_syns->synonyms.back().sense;
+		case X_LNOTE:
+			check_not_empty( m_syns->synonyms, "synonyms empty at LNOTE tag");
+			return &m_syns->synonyms.back().lnote;
+		case X_NUCLEUS:
+			check_not_empty( m_syns->synonyms, "synonyms empty at NUCLEUS tag");
+			return &m_syns->synonyms.back().nucleus;
+		case X_ILR:
+			check_not_empty( m_syns->ilrs, "ilrs empty at ILR tag");
+			return &m_syns->ilrs.back().first;
+		case X_ILR_TYPE:
+			check_not_empty( m_syns->ilrs, "ilrs empty at ILR/TYPE tag");
+			return &m_syns->ilrs.back().second;
+		case X_DEF:		return &m_syns->def;
+		case X_BCS:		return &m_syns->bcs;
+		case X_USAGE:
+			check_not_empty( m_syns->usages, "usages empty at USAGE tag");
+			return &m_syns->usages.back();
+		case X_SNOTE:
+			check_not_empty( m_syns->snotes, "snotes empty at SNOTE tag");
+			return &m_syns->snotes.back();
+		case X_STAMP:	return &m_syns->stamp;
+		case X_DOMAIN:	return &m_syns->domain;
+		case X_SUMO:
+			check_not_empty( m_syns->sumolinks, "sumolinks empty at SUMO tag");
+			return &m_syns->sumolinks.back().first;
+		case X_SUMO_TYPE:
+			check_not_empty( m_syns->sumolinks, "sumolinks empty at SUMO/TYPE tag");
+			return &m_syns->sumolinks.back().second;
+		case X_NL:		return &m_syns->nl;
+		case X_TNL:		return &m_syns->tnl;
+		case X_EQ_NEAR_SYNONYM:
+			check_not_empty( m_syns->elrs, "elrs empty at EQ_NEAR_SYNONYM tag");
+			return &m_syns->elrs.back().first;
+		case X_EQ_HYPERNYM:
+			check_not_empty( m_syns->elrs, "elrs empty at EQ_HYPERNYM tag");
+			return &m_syns->elrs.back().first;
+		case X_EQ_HYPONYM:
+			check_not_empty( m_syns->elrs, "elrs empty at EQ_HYPONYM tag");
+			return &m_syns->elrs.back().first;
+		case X_ELR:
+			check_not_empty( m_syns->elrs, "elrs empty at ELR tag");
+			return &m_syns->elrs.back().first;
+		case X_ELR_TYPE:
+			check_not_empty( m_syns->elrs, "elrs empty at ELR/TYPE tag");
+			return &m_syns->elrs.back().second;
+		case X_EKSZ:
+			check_not_empty( m_syns->ekszlinks, "ekszlinks empty at EKSZ tag");
+			return &m_syns->ekszlinks.back().first;
+		case X_EKSZ_TYPE:
+			check_not_empty( m_syns->ekszlinks, "ekszlinks empty at EKSZ/TYPE tag");
+			return &m_syns->ekszlinks.back().second;
+		case X_VFRAME:
+			check_not_empty( m_syns->vframelinks, "vframelinks empty at VFRAME tag");
+			return &m_syns->vframelinks.back().first;
+		case X_VFRAME_TYPE:
+			check_not_empty( m_syns->vframelinks, "vframelinks empty at VFRAME/TYPE tag");
+			return &m_syns->vframelinks.back().second;
+		default:
+			return NULL;
+	}
+}
+
+
+void WNXMLParser::on_characters(const std::string& text)
+{
+#ifdef _LOGPARSE
+	std::cout << m_lcnt << ": ";
+	print_path( std::cout);	
+	std::cout << "/#PCDATA: " << text << std::endl;
+#endif
+
+	if (m_done == 1 || m_done == -1) // outside of synset, text is thrown away (not even converted)
+		return;
+
+	// current element, its parent and grandparent
+	unsigned char cur = getNParent( getPos());
+	unsigned char parent = getNParent( getPos()-1);
+
+	eTextAction action = eTextAction( tables().text[cur][parent]);
+	if ((action == X_SENSE || action == X_LNOTE || action == X_NUCLEUS) && getNParent( getPos()-2) != T_SYNONYM)
+		return;
+	std::string* field = textField( action);
+	if (field == NULL)
+		return;
+
+	// collect UTF-8 text, it is converted when the field is complete (or another field gets text)
+	if (field != m_field) {
+		flushText();
+		m_field = field;
+	}
+	m_text += text;
+}
+
+
+void WNXMLParser::flushText()
+{
+	if (m_field == NULL)
+		return;
+	// convert from UTF-8 to user-specified enc. (not needed if that's UTF-8 too, or if text is ASCII)
+	if (m_utf8out || isASCII( m_text.data(), m_text.size()))
+		*m_field += m_text;
+	else {
+		m_cconv->convert( m_text, m_conv);
+		*m_field += m_conv;
+	}
+	m_text.clear();
+	m_field = NULL;
+}
+
+
+void WNXMLParser::on_end_element(const std::string& name)
+{
+#ifdef _LOGPARSE
+	std::cout << m_lcnt << ": ";
+	print_path( std::cout);	
+	std::cout << "/END: " << name << std::endl;
+#endif
+
+	if (m_done  == 1)
+		return;
+
+	flushText();
+
+	if (!m_ppath.empty() && m_ppath.back() == T_SYNSET) { // SYNSET
+		if (m_done == -1) {
+			ML_THROW_EXC( "This is impossible!\nThe parser should've caught this error: 'SYNSET' end tag without previous begin tag", WNXMLParserException);
+		}
+		m_done = 1;
+		if (m_blocksize != 0) { // block-buffered mode: queue it, go on with the next one
+			m_ready.push_back( std::make_pair( Synset(), m_endlines.empty() ? m_lcnt : m_endlines.front()));
+			std::swap( m_ready.back().first, m_cur);
+			if (!m_endlines.empty())
+				m_endlines.pop_front();
+			m_cur.clear();
+			m_done = -1;
+		}
+	}
+
+	m_ppath.pop_back();
+}
+
+
 } // namespace LibWNXML {
\ No newline at end of file
@@ -1,105 +1,197 @@
-#ifndef __WNXMLPARSER_H__
-#define __WNXMLPARSER_H__
-
-#include <iostream>
-#include <memory>
-#include <string>
-#include <libxml++/libxml++.h>
-#include "../CharConverter/CharConverter.h"
-#include "../mlutils/Exception.h"
-#include "../mlutils/Throw.h"
-
-#include "Synset.h"
-
-//#define _LOGPARSE
-
-namespace LibWNXML {
-
-
-// This exception signals well-formedness or validity errors in the XML input, or other I/O errors
-ML_EXCEPTION( WNXMLParserException);
-
-
-class WNXMLParser : protected xmlpp::SaxParser
-{
-public:
-    
-	/// Constructor has 1 parameter:
-	/// the character encoding you want in the parser's output
-	/// default is UTF-8 (same as libxml's internal encoding)
-	/// For valid encoding names, see CharConverter/EncodingNames.cpp
-	WNXMLParser( std::string OutCharEnc = "UTF-8" );
-	
-	/// read xml input stream, parse one synset entry, then stop
-	void	parseXMLSynset( std::istream& is, Synset& syns, int& linenum);
-	
-	/// Call this when finished parsing the input.
-	void	finishParsing();
-
-protected:
-	// xmlpp::SaxParser overrides:
-
-	//virtual void on_start_document();
-	//virtual void on_end_document();
-	//virtual void on_comment(const std::string& text);
-	
-	virtual void on_start_element(const std::string& name,
-								  const AttributeList& properties);
-	virtual void on_end_element(const std::string& name);
-	virtual void on_characters(const std::string& characters);
-		
-	virtual void on_warning(const std::string& text)
-		{	std::cerr << "libxml++ warning (input line " << m_lcnt << "): " << text << std::endl << m_line << std::endl; }
-	virtual void on_error(const std::string& text)
-		{	ML_THROW_EXC( "XML parser error (input line " << m_lcnt << "): " << text << std::endl << m_line, WNXMLParserException); }
-	virtual void on_fatal_error(const std::string& text)
-		{	ML_THROW_EXC( "XML parser fatal error (input line " << m_lcnt << "): " << text << std::endl << m_line << std::endl, WNXMLParserException); }
-
-protected:
-
-	// get current position in parse tree (1=root level, 2=1st level, ...)
-	size_t getPos() 
-		{ return m_ppath.size(); }
-
-	// get name of ancestor at nth position in parse path 
-	// (1=root node, getPos()-1=parent node, getPos()=current node), if it doesn't exist, returns empty string
-	std::string getNParent(size_t n)
-		{
-			if (1 <= n && n <= m_ppath.size())
-				return m_ppath[n-1];
-			else
-				return "";
-		}
-	
-	// get the name of the parent node
-	std::string getParent() 
-		{ return getNParent( getPos()-1); }
-	
-	// for debugging
-	void print_path( std::ostream& os)
-		{
-			for (size_t i=1; i <= getPos(); i++)
-				os << "/" << getNParent( i);
-		}
-	
-protected:
-
-	int									m_lcnt;	// input line number
-	std::string							m_line;	// last line of input
-	std::vector<std::string>			m_ppath; // contains the XML path to the current node (names of the ancestors)
-	int									m_done;	// -1: not started synset yet, 0: inside synset, 1: done with synset
-	LibWNXML::Synset*						m_syns;	// points to the output struct
-	std::auto_ptr<ML::CharConverter>	m_cconv; // char. encoding converter (from UTF-8 to enc. specified in constructor)
-	bool								m_startroot; // was there a starting root tag?
-	bool								m_endroot; // was there an end root tag?
-
-};
-
-
-
-
-
-
-}; // namespace LibWNXML
-
-#endif // #ifndef __WNXMLPARSER_H__
+#ifndef __WNXMLPARSER_H__
+#define __WNXMLPARSER_H__
+
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <libxml++/libxml++.h>
+#include "../CharConverter/CharConverter.h"
+#include "../mlutils/Exception.h"
+#include "../mlutils/Throw.h"
+
+#include "Synset.h"
+
+//#define _LOGPARSE
+
+namespace LibWNXML {
+
+
+// This exception signals well-formedness or validity errors in the XML input, or other I/O errors
+ML_EXCEPTION( WNXMLParserException);
+
+
+class WNXMLParser : protected xmlpp::SaxParser
+{
+public:
+    
+	/// Constructor has 1 parameter:
+	/// the character encoding you want in the parser's output
+	/// default is UTF-8 (same as libxml's internal encoding)
+	/// For valid encoding names, see CharConverter/EncodingNames.cpp
+	WNXMLParser( std::string OutCharEnc = "UTF-8" );
+	
+	/// read xml input stream, parse one synset entry, then stop
+	/// In block-buffered mode (see setBlockSize()) more synsets may be parsed ahead, these are returned by the following calls.
+	/// linenum is the input line number the synset ended on (in block-buffered mode, its value on the first call is the starting line count).
+	void	parseXMLSynset( std::istream& is, Synset& syns, int& linenum);
+	
+	/// Call this when finished parsing the input.
+	/// In block-buffered mode, check hasBuffered() afterwards for synsets completed by finishing.
+	void	finishParsing();
+
+	/// Default block size for block-buffered input
+	static const size_t DefaultBlockSize = 65536;
+
+	/// Set input mode. 0 (default): input is read and passed to the SAX parser line by line.
+	/// Otherwise: input is read in blocks of (at least) blocksize bytes, cut after the last </SYNSET> tag,
+	/// and each block is passed to the SAX parser at once. Set it before the first call to parseXMLSynset().
+	void	setBlockSize( size_t blocksize)
+		{ m_blocksize = blocksize; }
+
+	/// In block-buffered mode: true if there are synsets parsed ahead, not yet returned by parseXMLSynset()
+	bool	hasBuffered() const
+		{ return !m_ready.empty(); }
+
+	/// Check if text is pure ASCII (then it's the same in UTF-8 and in all the supported output encodings)
+	static bool	isASCII( const char* text, size_t len);
+
+protected:
+	// xmlpp::SaxParser overrides:
+
+	//virtual void on_start_document();
+	//virtual void on_end_document();
+	//virtual void on_comment(const std::string& text);
+	
+	virtual void on_start_element(const std::string& name,
+								  const AttributeList& properties);
+	virtual void on_end_element(const std::string& name);
+	virtual void on_characters(const std::string& characters);
+		
+	virtual void on_warning(const std::string& text)
+		{	std::cerr << "libxml++ warning (" << where() << "): " << text << std::endl << m_line << std::endl; }
+	virtual void on_error(const std::string& text)
+		{	ML_THROW_EXC( "XML parser error (" << where() << "): " << text << std::endl << m_line, WNXMLParserException); }
+	virtual void on_fatal_error(const std::string& text)
+		{	ML_THROW_EXC( "XML parser fatal error (" << where() << "): " << text << std::endl << m_line << std::endl, WNXMLParserException); }
+
+protected:
+
+	// read next block of input and pass it to the SAX parser (block-buffered mode)
+	void readBlock( std::istream& is);
+
+	// input position for messages: current line (in block-buffered mode, the line the SAX parser is at)
+	std::string where() const;
+
+	// line number of the SAX parser in its input (1 before the first chunk)
+	int parserLine() const;
+
+	// element names known by the parser, interned once; anything else is T_OTHER
+	enum eTag {
+		T_OTHER = 0, T_WNXML, T_SYNSET, T_ID, T_POS, T_SYNONYM, T_LITERAL, T_SENSE, T_LNOTE, T_NUCLEUS,
+		T_ILR, T_TYPE, T_DEF, T_BCS, T_USAGE, T_SNOTE, T_STAMP, T_DOMAIN, T_SUMO, T_NL, T_TNL,
+		T_EQ_NEAR_SYNONYM, T_EQ_HYPERNYM, T_EQ_HYPONYM, T_ELR, T_EKSZ, T_VFRAME,
+		T_COUNT
+	};
+
+	// element name of each tag (except T_OTHER), sorted by name for binary search
+	struct TagName
+	{
+		const char*	name;
+		eTag		tag;
+	};
+	static const TagName TagNames[];
+
+	// what to do at the start of an element (depends on element and parent)
+	enum eStartAction {
+		S_NONE = 0, S_SYNSET, S_LITERAL, S_ILR, S_USAGE, S_SNOTE, S_SUMO,
+		S_EQ_NEAR_SYNONYM, S_EQ_HYPERNYM, S_EQ_HYPONYM, S_ELR, S_EKSZ, S_VFRAME
+	};
+
+	// which synset field character data goes to (depends on current element and its parent)
+	enum eTextAction {
+		X_NONE = 0, X_ID, X_POS, X_LITERAL, X_SENSE, X_LNOTE, X_NUCLEUS, X_ILR, X_ILR_TYPE,
+		X_DEF, X_BCS, X_USAGE, X_SNOTE, X_STAMP, X_DOMAIN, X_SUMO, X_SUMO_TYPE, X_NL, X_TNL,
+		X_EQ_NEAR_SYNONYM, X_EQ_HYPERNYM, X_EQ_HYPONYM, X_ELR, X_ELR_TYPE, X_EKSZ, X_EKSZ_TYPE,
+		X_VFRAME, X_VFRAME_TYPE
+	};
+
+	// transition tables, indexed by [element][parent]
+	struct DispatchTables
+	{
+		unsigned char start[T_COUNT][T_COUNT];
+		unsigned char text[T_COUNT][T_COUNT];
+		DispatchTables();
+	};
+	static const DispatchTables& tables();
+
+	// get id of element name
+	static eTag tagID( const std::string& name);
+
+	// get element name of id (for debugging)
+	static const char* tagName( unsigned char tag);
+
+	// get synset field for character data (checks that the vector holding it is not empty)
+	std::string* textField( eTextAction action);
+
+	// convert the character data collected for the current field and append it to the field
+	void flushText();
+
+	// get current position in parse tree (1=root level, 2=1st level, ...)
+	size_t getPos() 
+		{ return m_ppath.size(); }
+
+	// get id of ancestor at nth position in parse path 
+	// (1=root node, getPos()-1=parent node, getPos()=current node), if it doesn't exist, returns T_OTHER
+	unsigned char getNParent(size_t n)
+		{
+			if (1 <= n && n <= m_ppath.size())
+				return m_ppath[n-1];
+			else
+				return T_OTHER;
+		}
+	
+	// get the id of the parent node
+	unsigned char getParent() 
+		{ return getNParent( getPos()-1); }
+	
+	// for debugging
+	void print_path( std::ostream& os)
+		{
+			for (size_t i=1; i <= getPos(); i++)
+				os << "/" << tagName( getNParent( i));
+		}
+	
+protected:
+
+	int									m_lcnt;	// input line number (in block-buffered mode: number of lines before the current block)
+	std::string							m_line;	// last line of input (empty in block-buffered mode)
+	size_t								m_blocksize; // 0: line by line input, otherwise block size
+	bool								m_blockstarted; // was the first block read?
+	int									m_blocklines; // number of lines in current block
+	int									m_blockstart; // parserLine() at the start of the current block
+	std::string							m_carry; // input read after the last </SYNSET> of the last block
+	std::deque<int>						m_endlines; // line numbers of the </SYNSET> tags of the current block not yet reached by the SAX parser
+	std::deque< std::pair<Synset, int> >	m_ready; // synsets parsed ahead (with line numbers), waiting to be returned
+	Synset								m_cur; // synset being parsed in block-buffered mode
+	std::vector<unsigned char>			m_ppath; // contains the XML path to the current node (tag ids of the ancestors)
+	int									m_done;	// -1: not started synset yet, 0: inside synset, 1: done with synset
+	LibWNXML::Synset*						m_syns;	// points to the output struct
+	std::auto_ptr<ML::CharConverter>	m_cconv; // char. encoding converter (from UTF-8 to enc. specified in constructor)
+	bool								m_utf8out; // output encoding is UTF-8 (no conversion needed)
+	std::string*						m_field; // synset field the character data in m_text belongs to (NULL if none)
+	std::string							m_text; // character data (UTF-8) collected for m_field, converted at once when the field is complete
+	std::string							m_conv; // conversion buffer
+	bool								m_startroot; // was there a starting root tag?
+	bool								m_endroot; // was there an end root tag?
+
+};
+
+
+
+
+
+
+}; // namespace LibWNXML
+
+#endif // #ifndef __WNXMLPARSER_H__
@@ -1,121 +1,533 @@
-#include <iostream>
-#include "WNQuery.h"
-
-namespace LibWNXML {
-
-
-void WNQuery::similarityLeacockChodorow(	const std::string& literal1, 
-											const std::string& literal2,
-											const std::string& pos,
-											const std::string& relation,
-											const bool addArtificialTop,
-											tSims& results) const
-{
-	// clear output
-	results.clear();
-	
-	// get senses of input words
-	std::vector<std::string> senses1, senses2;
-	lookUpLiteral( literal1, pos, senses1);
-	lookUpLiteral( literal2, pos, senses2);
-	if (senses1.empty() || senses2.empty()) // either of words not found
-		return;
-
-	// for each synset pair, calc similarity & put into results
-	double s;
-	for (size_t i=0; i!=senses1.size(); i++)
-		for (size_t j=0; j!=senses2.size(); j++) {
-			s = simLeaCho( senses1[i], senses2[j], pos, relation, addArtificialTop);
-			results.insert( std::make_pair( s, std::make_pair( senses1[i], senses2[j])));
-		}
-
-}
-
-
-double WNQuery::simLeaCho(	const std::string& id1, 
-							const std::string& id2,
-							const std::string& pos,
-							const std::string& relation,
-							const bool addArtificialTop) const
-{
-	// get nodes reachable from id1, id2 by relation + their distances (starting with id1/2 with dist. 1)
-	std::vector< std::pair< std::string, int > > r1, r2;
-	int d = 1;
-	getReach( id1, pos, relation, r1, d, addArtificialTop);
-	d = 1;
-	getReach( id2, pos, relation, r2, d, addArtificialTop);
-
-	// find common node (O(n*m))
-	std::vector< std::pair< std::string, int > >::iterator ci_r1 = r1.end();
-	std::vector< std::pair< std::string, int > >::iterator ci_r2 = r2.end();
-	int path_length = 2*LeaCho_D;
-	for (std::vector< std::pair< std::string, int > >::iterator i1=r1.begin(); i1!=r1.end(); i1++) {
-		for (std::vector< std::pair< std::string, int > >::iterator i2=r2.begin(); i2!=r2.end(); i2++) {
-			if (i1->first == i2->first) {
-				if (i1->second + i2->second < path_length) {
-					ci_r1 = i1;
-					ci_r2 = i2;
-					path_length = i1->second + i2->second;
-				}
-			}
-		}
-	}
-	path_length = path_length - 1; // because the common node was counted twice
-
-	//// debug: print info
-	//std::cerr << "\nNodes in reach of " << id1 << ":\n";
-	//for (size_t i=0; i!=r1.size(); i++)
-	//	std::cerr << "  " << r1[i].first << "  " << r1[i].second << std::endl;
-	//std::cerr << "Nodes in reach of " << id2 << ":\n";
-	//for (size_t i=0; i!=r2.size(); i++)
-	//	std::cerr << "  " << r2[i].first << "  " << r2[i].second << std::endl;
-	//if (ci_r1 != r1.end() && ci_r2 != r2.end()) {
-	//	std::cerr << "Common nodes with shortest path:\n";
-	//	std::cerr << "  " << ci_r1->first << "  " << ci_r1->second << "\n";
-	//	std::cerr << "  " << ci_r2->first << "  " << ci_r2->second << "\n";
-	//	std::cerr << "Shortest path length:\n" << "  " << path_length << "\n";
-	//	std::cerr << "Similarity score:" << "  " << - log10( double(path_length) / (double(2.0) * double(LeaCho_D)) ) << "\n\n";
-	//
-	//}
-	//else {
-	//	std::cerr << "No common node found.\n\n";
-	//}
-
-	// return similarity score
-	if (ci_r1 != r1.end() && ci_r2 != r2.end()) // based on length of shortest connecting path
-		return (double(-1.0) * log10( double(path_length) / (double(2.0) * double(LeaCho_D)) ));
-	else // when no connecting path exists between synsets
-		return LeaCho_noconnect;
-}
-
-
-void WNQuery::getReach(	const std::string& id,
-						const std::string& pos,
-						const std::string& rel,
-						std::vector< std::pair< std::string, int > >& res,
-						int dist,
-						const bool addTop) const
-{
-	// look up current synset
-	tdat::const_iterator it = dat(pos).find( id);
-	if (it == dat(pos).end()) // not found
-		return;
-	// add current synset
-	res.push_back( std::make_pair( id, dist));
-	// recurse on children
-	dist++;
-	bool haschildren = false;
-	for (size_t i=0; i!=it->second.ilrs.size(); i++) // for all relations of synset
-		if (it->second.ilrs[i].second == rel) { // if it is the right type
-			haschildren = true;
-			getReach( it->second.ilrs[i].first, pos, rel, res, dist, addTop); // recurse on child
-		}
-	// if it has no "children" of this type (is terminal leaf or root level), add artificial "root" if requested
-	if (!haschildren && addTop) 
-		res.push_back( std::make_pair( "#TOP#", dist));
-}
-
-
-
-
-} // namespace LibWNXML {
+#include <algorithm>
+#include <iostream>
+#include "LCAIndex.h"
+#include "ThreadPool.h"
+#include "WNQuery.h"
+
+namespace LibWNXML {
+
+
+namespace {
+
+/// Similarity score for the sum of the distances of a common node from the two synsets
+/// (each counted from 1), LeaCho_noconnect if it's not less than 2*D
+double leacho_score( int sum)
+{
+	if (sum >= 2*LeaCho_D)
+		return LeaCho_noconnect;
+	int path_length = sum - 1; // because the common node was counted twice
+	return (double(-1.0) * log10( double(path_length) / (double(2.0) * double(LeaCho_D)) ));
+}
+
+/// Sum of the distances of the nearest common node of two chain nodes from them (see LCAIndex),
+/// 2*LeaCho_D if they are not connected
+int chain_sum( const LCAIndex& lca, WNGraph::tnode n1, WNGraph::tnode n2, const bool addTop)
+{
+	WNGraph::tnode c = lca.lca( n1, n2);
+	if (c != WNGraph::npos) // nearest common node
+		return (lca.depth( n1) - lca.depth( c) + 1) + (lca.depth( n2) - lca.depth( c) + 1);
+	else if (addTop && lca.hasTop( n1) && lca.hasTop( n2)) // connected through artificial top above the roots
+		return (lca.depth( n1) + 2) + (lca.depth( n2) + 2);
+	else
+		return 2*LeaCho_D;
+}
+
+} // namespace {
+
+
+
+void WNQuery::similarityLeacockChodorow(	const std::string& literal1, 
+											const std::string& literal2,
+											const std::string& pos,
+											const std::string& relation,
+											const bool addArtificialTop,
+											tSims& results) const
+{
+	WNStats::Timer timer( m_stats, WNStats::SimilarityLeacockChodorow);
+	// clear output
+	results.clear();
+	
+	// get senses of input words
+	std::vector<std::string> senses1, senses2;
+	literal_ids( literal1, pos, senses1);
+	literal_ids( literal2, pos, senses2);
+	if (senses1.empty() || senses2.empty()) // either of words not found
+		return;
+
+	// for each synset pair, calc similarity & put into results
+	double s;
+	for (size_t i=0; i!=senses1.size(); i++)
+		for (size_t j=0; j!=senses2.size(); j++) {
+			s = simLeaCho( senses1[i], senses2[j], pos, relation, addArtificialTop);
+			results.insert( std::make_pair( s, std::make_pair( senses1[i], senses2[j])));
+		}
+
+}
+
+
+double WNQuery::simLeaCho(	const std::string& id1, 
+							const std::string& id2,
+							const std::string& pos,
+							const std::string& relation,
+							const bool addArtificialTop) const
+{
+	// look up synsets
+	const WNGraph& g = graph( pos);
+	WNGraph::tnode n1 = g.find( id1);
+	WNGraph::tnode n2 = g.find( id2);
+	unsigned rel = g.relation( relation);
+
+	// if the relation never branches from either synset, use the LCA index
+	if (n1 != WNGraph::npos && n2 != WNGraph::npos) {
+		const LCAIndex& lca = g.lcaIndex( rel);
+		if (lca.isChain( n1) && lca.isChain( n2))
+			return leacho_score( chain_sum( lca, n1, n2, addArtificialTop));
+	}
+
+	// otherwise search from both synsets
+	if (n1 == WNGraph::npos || n2 == WNGraph::npos)
+		return LeaCho_noconnect;
+	return leacho_score( meetReach( g, n1, n2, rel, addArtificialTop));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Nearest neighbors
+
+void WNQuery::nearestNeighbors(	const std::string& id,
+								const std::string& pos,
+								const std::string& relation,
+								size_t k,
+								const bool addArtificialTop,
+								tNeighbors& results) const
+{
+	WNStats::Timer timer( m_stats, WNStats::NearestNeighbors);
+	results.clear();
+	const WNGraph& g = graph( pos);
+	WNGraph::tnode n = g.find( id);
+	if (g.synset( n) == NULL || k == 0)
+		return;
+	std::vector< std::pair< WNGraph::tnode, double > > nodes;
+	nearest_nodes( g, n, g.relation( relation), k, addArtificialTop, nodes);
+	results.reserve( nodes.size());
+	for (size_t i=0; i!=nodes.size(); i++)
+		results.push_back( std::make_pair( g.id( nodes[i].first), nodes[i].second));
+}
+
+
+namespace {
+
+/// Scratch space of nearest_nodes(), kept per thread
+struct NearestScratch
+{
+	std::vector<unsigned>	mark;	///< state s is visited in the current search if mark[s] == gen
+	unsigned				gen;	///< number of the current search
+	std::vector<unsigned>	cur;	///< states of the current level
+	std::vector<unsigned>	next;	///< states of the next level
+
+	NearestScratch()
+		: gen( 0)
+	{}
+};
+
+/// Order of neighbors: by distance, then by id (nodes are in id order only until the graph is patched)
+struct Nearer
+{
+	const WNGraph&	g;
+
+	Nearer( const WNGraph& gr)
+		: g( gr)
+	{}
+
+	bool operator()( const std::pair< WNGraph::tnode, int >& a, const std::pair< WNGraph::tnode, int >& b) const
+	{
+		return a.second != b.second ? a.second < b.second : g.id( a.first) < g.id( b.first);
+	}
+};
+
+} // namespace {
+
+
+void WNQuery::nearest_nodes(	const WNGraph& g,
+								WNGraph::tnode n,
+								unsigned rel,
+								size_t k,
+								const bool addTop,
+								std::vector< std::pair< WNGraph::tnode, double > >& res) const
+{
+	// The connecting path of n and a synset x goes up along the relation from n to a common node,
+	// then down against the relation to x. The search states are "up" (2*node) and "down" (2*node+1),
+	// plus down from the artificial top (2*nn+1), which is one step above every synset with no target.
+	// The distance of a state is the length of the path so far, and turning down costs nothing,
+	// so x is found at the distance d1+d2 (the path sum minus 2, see similarityLeacockChodorow()).
+	res.clear();
+	const size_t nn = g.size();
+	const unsigned top = unsigned( 2*nn + 1);
+	static thread_local NearestScratch scratch;
+	std::vector<unsigned>& mark = scratch.mark;
+	std::vector<unsigned>& cur = scratch.cur;
+	std::vector<unsigned>& next = scratch.next;
+	if (mark.size() < 2*nn + 2)
+		mark.resize( 2*nn + 2, 0);
+	unsigned gen = ++scratch.gen;
+	if (gen == 0) { // wrapped around: clear the marks
+		std::fill( mark.begin(), mark.end(), 0);
+		gen = scratch.gen = 1;
+	}
+
+	std::vector< std::pair< WNGraph::tnode, int > > found; // (node, distance)
+	cur.clear();
+	next.clear();
+	mark[2*n] = gen;
+	cur.push_back( 2*n);
+	// level by level, as long as a connection shorter than 2*D is possible
+	for (int d=0; !cur.empty() && d + 2 < 2*LeaCho_D; d++) {
+		// turn down at the nodes reached going up (first, so these aren't reached later at d+1)
+		for (size_t i=0, e=cur.size(); i!=e; i++) {
+			unsigned st = cur[i];
+			if (st != top && st % 2 == 0 && mark[st+1] != gen) {
+				mark[st+1] = gen;
+				cur.push_back( st+1);
+			}
+		}
+		for (size_t i=0; i!=cur.size(); i++) {
+			unsigned st = cur[i];
+			if (st == top) { // down to every synset with no target
+				for (WNGraph::tnode x=0; x!=nn; x++)
+					if (g.targets( rel, x).empty() && mark[2*x+1] != gen && g.synset( x) != NULL) {
+						mark[2*x+1] = gen;
+						next.push_back( 2*x+1);
+					}
+				continue;
+			}
+			WNGraph::tnode x = st / 2;
+			if (st % 2 == 0) { // up
+				WNGraph::Targets t = g.targets( rel, x);
+				for (const WNGraph::tnode* p=t.first; p!=t.last; p++)
+					if (mark[2 * *p] != gen && g.synset( *p) != NULL) { // (missing targets are skipped)
+						mark[2 * *p] = gen;
+						next.push_back( 2 * *p);
+					}
+				if (addTop && t.empty() && mark[top] != gen) {
+					mark[top] = gen;
+					next.push_back( top);
+				}
+			}
+			else { // down
+				if (x != n)
+					found.push_back( std::make_pair( x, d));
+				WNGraph::Targets t = g.sources( rel, x);
+				for (const WNGraph::tnode* p=t.first; p!=t.last; p++)
+					if (mark[2 * *p + 1] != gen) {
+						mark[2 * *p + 1] = gen;
+						next.push_back( 2 * *p + 1);
+					}
+			}
+		}
+		// the whole level is done, so the k best are known (ties included)
+		if (found.size() >= k)
+			break;
+		cur.swap( next);
+		next.clear();
+	}
+
+	std::sort( found.begin(), found.end(), Nearer( g));
+	if (found.size() > k)
+		found.resize( k);
+	res.reserve( found.size());
+	for (size_t i=0; i!=found.size(); i++)
+		res.push_back( std::make_pair( found[i].first, leacho_score( found[i].second + 2)));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Similarity matrices
+
+namespace {
+
+/// Reach lists longer than this are not kept, pairs with such senses are searched with meetReach()
+const size_t MaxKeptReach = 4096;
+
+/// A sense (synset node) of a similarity matrix
+struct MatrixSense
+{
+	WNGraph::tnode									node;
+	bool											chain;	///< chain node of the LCA index
+	bool											kept;	///< reach was kept
+	std::vector< std::pair< WNGraph::tnode, int > >	reach;	///< synsets reachable from node with distances, sorted by node (artificial top last)
+};
+
+/// Sum of distances of the nearest common node of two sorted reach lists, 2*LeaCho_D if there's none
+int join_sum( const std::vector< std::pair< WNGraph::tnode, int > >& r1, const std::vector< std::pair< WNGraph::tnode, int > >& r2)
+{
+	int best = 2*LeaCho_D;
+	size_t i = 0, j = 0;
+	while (i != r1.size() && j != r2.size()) {
+		if (r1[i].first < r2[j].first)
+			i++;
+		else if (r2[j].first < r1[i].first)
+			j++;
+		else {
+			best = std::min( best, r1[i].second + r2[j].second);
+			i++;
+			j++;
+		}
+	}
+	return best;
+}
+
+} // namespace {
+
+
+/// Collects the reach of each sense
+struct WNQuery::ReachJob : public ThreadPool::Job
+{
+	const WNQuery&				wn;
+	const WNGraph&				g;
+	const LCAIndex&				lca;
+	unsigned					rel;
+	bool						addTop;
+	std::vector<MatrixSense>&	senses;
+
+	ReachJob( const WNQuery& w, const WNGraph& gr, const LCAIndex& l, unsigned r, bool t, std::vector<MatrixSense>& s)
+		: wn( w), g( gr), lca( l), rel( r), addTop( t), senses( s)
+	{}
+
+	void run( size_t i)
+	{
+		MatrixSense& s = senses[i];
+		s.chain = lca.isChain( s.node);
+		wn.getReach( g, s.node, rel, s.reach, 1, addTop);
+		s.kept = s.reach.size() <= MaxKeptReach;
+		if (s.kept)
+			std::sort( s.reach.begin(), s.reach.end());
+		else
+			std::vector< std::pair< WNGraph::tnode, int > >().swap( s.reach);
+	}
+};
+
+
+/// Scores one row of the matrix
+struct WNQuery::ScoreJob : public ThreadPool::Job
+{
+	const WNQuery&									wn;
+	const WNGraph&									g;
+	const LCAIndex&									lca;
+	unsigned										rel;
+	bool											addTop;
+	const std::vector<MatrixSense>&					senses;
+	const std::vector< std::vector<size_t> >&		rows;	///< senses of the words of the rows (indices into senses)
+	const std::vector< std::vector<size_t> >&		cols;
+	tSimMatrix&										results;
+
+	ScoreJob( const WNQuery& w, const WNGraph& gr, const LCAIndex& l, unsigned r, bool t, const std::vector<MatrixSense>& s,
+			  const std::vector< std::vector<size_t> >& rs, const std::vector< std::vector<size_t> >& cs, tSimMatrix& res)
+		: wn( w), g( gr), lca( l), rel( r), addTop( t), senses( s), rows( rs), cols( cs), results( res)
+	{}
+
+	void run( size_t i)
+	{
+		std::vector<double>& row = results[i];
+		row.assign( cols.size(), LeaCho_notfound);
+		if (rows[i].empty())
+			return;
+		for (size_t j=0; j!=cols.size(); j++) {
+			if (cols[j].empty())
+				continue;
+			// best score of sense pairs (scores are decreasing with the sums)
+			int best = 2*LeaCho_D;
+			for (size_t a=0; a!=rows[i].size(); a++) {
+				const MatrixSense& s1 = senses[rows[i][a]];
+				for (size_t b=0; b!=cols[j].size(); b++) {
+					const MatrixSense& s2 = senses[cols[j][b]];
+					int sum;
+					if (s1.chain && s2.chain)
+						sum = chain_sum( lca, s1.node, s2.node, addTop);
+					else if (s1.kept && s2.kept)
+						sum = join_sum( s1.reach, s2.reach);
+					else
+						sum = wn.meetReach( g, s1.node, s2.node, rel, addTop);
+					best = std::min( best, sum);
+				}
+			}
+			row[j] = leacho_score( best);
+		}
+	}
+};
+
+
+void WNQuery::similarityMatrix(	const std::vector<std::string>& literals1,
+								const std::vector<std::string>& literals2,
+								const std::string& pos,
+								const std::string& relation,
+								const bool addArtificialTop,
+								tSimMatrix& results,
+								ThreadPool* pool) const
+{
+	WNStats::Timer timer( m_stats, WNStats::SimilarityMatrix);
+	const WNGraph& g = graph( pos);
+	std::vector< std::vector<WNGraph::tnode> > senses1( literals1.size()), senses2( literals2.size());
+	for (size_t i=0; i!=literals1.size(); i++) {
+		WNGraph::Targets t = g.senses( literals1[i]);
+		senses1[i].assign( t.first, t.last);
+	}
+	for (size_t i=0; i!=literals2.size(); i++) {
+		WNGraph::Targets t = g.senses( literals2[i]);
+		senses2[i].assign( t.first, t.last);
+	}
+	sim_matrix( g, senses1, senses2, g.relation( relation), addArtificialTop, results, pool);
+}
+
+
+void WNQuery::similarityMatrixIDs(	const std::vector<std::string>& ids1,
+									const std::vector<std::string>& ids2,
+									const std::string& pos,
+									const std::string& relation,
+									const bool addArtificialTop,
+									tSimMatrix& results,
+									ThreadPool* pool) const
+{
+	WNStats::Timer timer( m_stats, WNStats::SimilarityMatrix);
+	const WNGraph& g = graph( pos);
+	std::vector< std::vector<WNGraph::tnode> > senses1( ids1.size()), senses2( ids2.size());
+	for (size_t i=0; i!=ids1.size(); i++) {
+		WNGraph::tnode n = g.find( ids1[i]);
+		if (g.synset( n) != NULL)
+			senses1[i].push_back( n);
+	}
+	for (size_t i=0; i!=ids2.size(); i++) {
+		WNGraph::tnode n = g.find( ids2[i]);
+		if (g.synset( n) != NULL)
+			senses2[i].push_back( n);
+	}
+	sim_matrix( g, senses1, senses2, g.relation( relation), addArtificialTop, results, pool);
+}
+
+
+void WNQuery::sim_matrix(	const WNGraph& g,
+							const std::vector< std::vector<WNGraph::tnode> >& senses1,
+							const std::vector< std::vector<WNGraph::tnode> >& senses2,
+							unsigned rel,
+							const bool addTop,
+							tSimMatrix& results,
+							ThreadPool* pool) const
+{
+	// collect distinct senses
+	std::vector<MatrixSense> senses;
+	std::map<WNGraph::tnode, size_t> index;
+	std::vector< std::vector<size_t> > rows( senses1.size()), cols( senses2.size());
+	for (int k=0; k!=2; k++) {
+		const std::vector< std::vector<WNGraph::tnode> >& in = k == 0 ? senses1 : senses2;
+		std::vector< std::vector<size_t> >& out = k == 0 ? rows : cols;
+		for (size_t i=0; i!=in.size(); i++)
+			for (size_t j=0; j!=in[i].size(); j++) {
+				std::pair< std::map<WNGraph::tnode, size_t>::iterator, bool > r = index.insert( std::make_pair( in[i][j], senses.size()));
+				if (r.second) {
+					senses.push_back( MatrixSense());
+					senses.back().node = in[i][j];
+				}
+				out[i].push_back( r.first->second);
+			}
+	}
+
+	// get reach of senses, then score rows
+	const LCAIndex& lca = g.lcaIndex( rel);
+	ReachJob rj( *this, g, lca, rel, addTop, senses);
+	results.clear();
+	results.resize( rows.size());
+	ScoreJob sj( *this, g, lca, rel, addTop, senses, rows, cols, results);
+	if (pool != NULL) {
+		pool->run( rj, senses.size());
+		pool->run( sj, rows.size());
+	}
+	else {
+		for (size_t i=0; i!=senses.size(); i++)
+			rj.run( i);
+		for (size_t i=0; i!=rows.size(); i++)
+			sj.run( i);
+	}
+}
+
+
+void WNQuery::getReach(	const WNGraph& g,
+						WNGraph::tnode n,
+						unsigned rel,
+						std::vector< std::pair< WNGraph::tnode, int > >& res,
+						int dist,
+						const bool addTop) const
+{
+	GraphBFS bfs( g, rel, n);
+	bool top = false;
+	do {
+		WNGraph::Targets l = bfs.level();
+		for (const WNGraph::tnode* p=l.first; p!=l.last; p++) {
+			res.push_back( std::make_pair( *p, dist + bfs.depth()));
+			// if it has no "children" of this type (is terminal leaf or root level), add artificial "root" if requested
+			// (the first one found is the nearest)
+			if (addTop && !top && g.targets( rel, *p).empty()) {
+				res.push_back( std::make_pair( WNGraph::npos, dist + bfs.depth() + 1));
+				top = true;
+			}
+		}
+	} while (bfs.nextLevel());
+}
+
+
+namespace {
+
+/// Check nodes of the current level of search x against those visited by search y
+void meet_level( const WNGraph& g, unsigned rel, bool addTop, const GraphBFS& x, const GraphBFS& y, int& topx, int topy, int& best)
+{
+	WNGraph::Targets l = x.level();
+	for (const WNGraph::tnode* p=l.first; p!=l.last; p++) {
+		int dy = y.distance( *p);
+		if (dy >= 0 && x.depth() + dy + 2 < best) // common node
+			best = x.depth() + dy + 2;
+		if (addTop && topx < 0 && g.targets( rel, *p).empty()) { // nearest leaf: artificial top is above it
+			topx = x.depth() + 1;
+			if (topy >= 0 && topx + topy + 2 < best)
+				best = topx + topy + 2;
+		}
+	}
+}
+
+} // namespace {
+
+
+int WNQuery::meetReach(	const WNGraph& g,
+						WNGraph::tnode n1,
+						WNGraph::tnode n2,
+						unsigned rel,
+						const bool addTop) const
+{
+	// a common node further than this from either synset can't give a sum less than 2*D
+	const int maxdist = 2*LeaCho_D - 3;
+	const int inf = 4*LeaCho_D;
+	GraphBFS b1( g, rel, n1, maxdist), b2( g, rel, n2, maxdist);
+	int best = 2*LeaCho_D;
+	int top1 = -1, top2 = -1; // distance of artificial top, -1 if not reached yet
+	meet_level( g, rel, addTop, b1, b2, top1, top2, best);
+	meet_level( g, rel, addTop, b2, b1, top2, top1, best);
+	bool more1 = true, more2 = true;
+	for (;;) {
+		// a common node not found yet is further than the current level of (at least) one of the searches
+		int bound = std::min( more1 ? b1.depth() + 1 : inf, more2 ? b2.depth() + 1 : inf) + 2;
+		if (bound >= best)
+			break;
+		// go on with the search that is behind
+		if (more1 && (!more2 || b1.depth() <= b2.depth())) {
+			more1 = b1.nextLevel();
+			meet_level( g, rel, addTop, b1, b2, top1, top2, best);
+		}
+		else {
+			more2 = b2.nextLevel();
+			meet_level( g, rel, addTop, b2, b1, top2, top1, best);
+		}
+	}
+	return best;
+}
+
+
+
+
+} // namespace LibWNXML {
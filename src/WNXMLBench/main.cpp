@@ -0,0 +1,383 @@
+/*
+
+Benchmarks of LibWNXML: loading, lookups, relation traversal and similarity.
+
+Writes a table of results to stderr and the same results as JSON to stdout, so that
+results of different versions can be compared by scripts.
+
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include "../MLUtils/MultiLog.h"
+
+#include "../LibWNXML/WNQuery.h"
+#include "../LibWNXML/WNXMLGenerator.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Allocation counting
+
+namespace {
+std::atomic<unsigned long long> g_allocs( 0);
+}
+
+void* operator new( size_t size)
+{
+	g_allocs.fetch_add( 1, std::memory_order_relaxed);
+	if (size == 0)
+		size = 1;
+	void* p = malloc( size);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[]( size_t size)
+{
+	return operator new( size);
+}
+
+void operator delete( void* p) throw()
+{
+	free( p);
+}
+
+void operator delete[]( void* p) throw()
+{
+	free( p);
+}
+
+// sized deallocation (C++14), same as the unsized one
+void operator delete( void* p, size_t) throw()
+{
+	operator delete( p);
+}
+
+void operator delete[]( void* p, size_t) throw()
+{
+	operator delete[]( p);
+}
+
+
+namespace {
+
+/// Peak resident set size of the process in bytes
+unsigned long long peak_rss()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (GetProcessMemoryInfo( GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return pmc.PeakWorkingSetSize;
+	return 0;
+#else
+	struct rusage ru;
+	if (getrusage( RUSAGE_SELF, &ru) != 0)
+		return 0;
+#ifdef __APPLE__
+	return (unsigned long long) ru.ru_maxrss;			// bytes
+#else
+	return (unsigned long long) ru.ru_maxrss * 1024;	// kilobytes
+#endif
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Measurements
+
+typedef std::chrono::steady_clock tClock;
+
+/// Results of a benchmark
+struct Result
+{
+	std::string			name;
+	size_t				ops;		///< number of operations timed
+	double				total;		///< seconds
+	std::vector<double>	times;		///< of operations, in seconds, sorted
+	unsigned long long	allocs;		///< number of allocations during the run
+
+	/// p-th percentile of operation times (0 <= p <= 100), in seconds
+	double	percentile( double p) const
+	{
+		if (times.empty())
+			return 0.0;
+		size_t i = size_t( p / 100.0 * double( times.size() - 1) + 0.5);
+		return times[i];
+	}
+};
+
+
+/// Run op( i) for i = 0..n-1, timing each call
+template <class Op>
+Result measure( const std::string& name, size_t n, Op op)
+{
+	Result r;
+	r.name = name;
+	r.ops = n;
+	r.times.reserve( n);
+	unsigned long long allocs = g_allocs.load();
+	tClock::time_point start = tClock::now();
+	for (size_t i=0; i!=n; i++) {
+		tClock::time_point t = tClock::now();
+		op( i);
+		r.times.push_back( std::chrono::duration<double>( tClock::now() - t).count());
+	}
+	r.total = std::chrono::duration<double>( tClock::now() - start).count();
+	r.allocs = g_allocs.load() - allocs;
+	std::sort( r.times.begin(), r.times.end());
+	return r;
+}
+
+
+/// Result of a phase timed as a whole (no per-operation times)
+Result phase( const std::string& name, double seconds)
+{
+	Result r;
+	r.name = name;
+	r.ops = 1;
+	r.total = seconds;
+	r.times.push_back( seconds);
+	r.allocs = 0;
+	return r;
+}
+
+
+void write_table( const std::vector<Result>& results, std::ostream& os)
+{
+	os << std::left << std::setw( 28) << "benchmark" << std::right
+		<< std::setw( 10) << "ops" << std::setw( 12) << "total s" << std::setw( 12) << "ops/s"
+		<< std::setw( 10) << "p50 us" << std::setw( 10) << "p90 us" << std::setw( 10) << "p99 us" << std::setw( 10) << "max us"
+		<< std::setw( 12) << "allocs/op" << "\n";
+	os << std::fixed;
+	for (size_t i=0; i!=results.size(); i++) {
+		const Result& r = results[i];
+		os << std::left << std::setw( 28) << r.name << std::right
+			<< std::setw( 10) << r.ops << std::setw( 12) << std::setprecision( 3) << r.total
+			<< std::setw( 12) << std::setprecision( 0) << (r.total > 0 ? r.ops / r.total : 0.0)
+			<< std::setprecision( 1)
+			<< std::setw( 10) << r.percentile( 50) * 1e6 << std::setw( 10) << r.percentile( 90) * 1e6
+			<< std::setw( 10) << r.percentile( 99) * 1e6 << std::setw( 10) << r.percentile( 100) * 1e6
+			<< std::setw( 12) << double( r.allocs) / double( r.ops) << "\n";
+	}
+}
+
+
+void write_json( const std::string& input, const std::vector<Result>& results, std::ostream& os)
+{
+	os << "{\n  \"input\": \"";
+	for (size_t i=0; i!=input.size(); i++) {
+		if (input[i] == '"' || input[i] == '\\')
+			os << '\\';
+		os << input[i];
+	}
+	os << "\",\n  \"peak_rss_bytes\": " << peak_rss() << ",\n  \"results\": [\n";
+	os << std::setprecision( 9);
+	for (size_t i=0; i!=results.size(); i++) {
+		const Result& r = results[i];
+		os << "    {\"name\": \"" << r.name << "\", \"ops\": " << r.ops << ", \"total_s\": " << r.total
+			<< ", \"ops_per_s\": " << (r.total > 0 ? r.ops / r.total : 0.0)
+			<< ", \"mean_s\": " << r.total / double( r.ops)
+			<< ", \"p50_s\": " << r.percentile( 50) << ", \"p90_s\": " << r.percentile( 90)
+			<< ", \"p99_s\": " << r.percentile( 99) << ", \"max_s\": " << r.percentile( 100)
+			<< ", \"allocs\": " << r.allocs << "}" << (i+1 != results.size() ? ",\n" : "\n");
+	}
+	os << "  ]\n}\n";
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Input
+
+/// Deterministic pseudo-random numbers (so that runs of different versions use the same queries)
+class Random
+{
+public:
+	explicit Random( unsigned long long seed) : m_state( seed * 6364136223846793005ULL + 1442695040888963407ULL) {}
+	size_t	operator()( size_t n)
+	{
+		m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return size_t( (m_state >> 33) % n);
+	}
+private:
+	unsigned long long	m_state;
+};
+
+
+/// Query arguments sampled from the loaded WN
+struct Sample
+{
+	std::string	pos;
+	std::string	id;
+	std::string	literal;
+	int			sense;
+};
+
+
+void sample_queries( const LibWNXML::WNQuery& wn, size_t n, std::vector<Sample>& samples)
+{
+	// all synsets, then pick n of them at random
+	std::vector< std::pair<std::string, const LibWNXML::Synset*> > all;
+	const char* poses[] = {"n", "v", "a", "b"};
+	for (size_t p=0; p!=4; p++) {
+		const LibWNXML::WNQuery::tdat& dat = wn.dat( poses[p]);
+		for (LibWNXML::WNQuery::tdat::const_iterator it=dat.begin(); it!=dat.end(); it++)
+			if (!it->second.synonyms.empty())
+				all.push_back( std::make_pair( std::string( poses[p]), &it->second));
+	}
+	samples.clear();
+	if (all.empty())
+		return;
+	Random rnd( 42);
+	for (size_t i=0; i!=n; i++) {
+		const std::pair<std::string, const LibWNXML::Synset*>& s = all[rnd( all.size())];
+		const LibWNXML::Synset::Synonym& syn = s.second->synonyms[rnd( s.second->synonyms.size())];
+		Sample smp;
+		smp.pos = s.first;
+		smp.id = s.second->id;
+		smp.literal = syn.literal;
+		smp.sense = atoi( syn.sense.c_str());
+		samples.push_back( smp);
+	}
+}
+
+} // namespace {
+
+
+int main( int argc, char *argv[])
+{
+	try {
+		// check command line
+		std::string input;
+		size_t synthetic = 0, nops = 10000;
+		unsigned nthreads = 1;
+		std::string relation = "hypernym";
+		for (int i=1; i<argc; i++) {
+			std::string arg = argv[i];
+			if (arg == "--synthetic" && i+1 < argc)
+				synthetic = size_t( atol( argv[++i]));
+			else if (arg == "-n" && i+1 < argc)
+				nops = size_t( atol( argv[++i]));
+			else if (arg == "-j" && i+1 < argc)
+				nthreads = unsigned( atoi( argv[++i]));
+			else if (arg == "-r" && i+1 < argc)
+				relation = argv[++i];
+			else if (input.empty())
+				input = arg;
+			else
+				input = "";
+		}
+		if ((input.empty() && synthetic == 0) || nops == 0) {
+			std::cerr << "Usage:\n  WNXMLBench [-n <ops>] [-j <threads>] [-r <relation>] <WN_XML_file>|--synthetic <synsets>\n";
+			std::cerr << "  -n           number of operations per benchmark (default: 10000)\n";
+			std::cerr << "  -j           number of threads loading the XML file (default: 1, 0: number of processors)\n";
+			std::cerr << "  -r           relation for traversal and similarity (default: hypernym)\n";
+			std::cerr << "  --synthetic  benchmark a generated noun hierarchy of this many synsets (see WNXMLGen)\n";
+			std::cerr << "Results are written to stderr as a table, and to stdout as JSON.\n";
+			return 1;
+		}
+		if (synthetic != 0) {
+			input = "WNXMLBench_synthetic.xml";
+			std::cerr << "Writing " << synthetic << " synthetic synsets to " << input << "...\n";
+			LibWNXML::WNXMLGenerator::Params params;
+			params.synsets[0] = synthetic;
+			params.synsets[1] = params.synsets[2] = params.synsets[3] = 0;
+			LibWNXML::WNXMLGenerator( params).write( input);
+		}
+
+		std::vector<Result> results;
+		std::auto_ptr<ML::MultiLog> logger( ML::MultiLog::create( std::cerr, 100));
+
+		// load
+		std::cerr << "Loading " << input << "...\n";
+		unsigned long long allocs = g_allocs.load();
+		tClock::time_point start = tClock::now();
+		std::auto_ptr<LibWNXML::WNQuery> wn( new LibWNXML::WNQuery( input, *logger, nthreads));
+		results.push_back( phase( "load", std::chrono::duration<double>( tClock::now() - start).count()));
+		results.back().allocs = g_allocs.load() - allocs;
+		const LibWNXML::WNQuery::LoadTimes& lt = wn->loadTimes();
+		results.push_back( phase( "load.parse", lt.parse));
+		results.push_back( phase( "load.save_synset", lt.save));
+		results.push_back( phase( "load.invert_relations", lt.invert));
+		results.push_back( phase( "load.build_graphs", lt.graphs));
+		if (synthetic != 0)
+			remove( input.c_str());
+
+		std::vector<Sample> smp;
+		sample_queries( *wn, nops, smp);
+		if (smp.empty()) {
+			std::cerr << "No synsets in input\n";
+			return 1;
+		}
+		const LibWNXML::WNQuery& q = *wn;
+
+		// lookups
+		std::cerr << "Running lookups...\n";
+		LibWNXML::Synset syns;
+		std::vector<LibWNXML::Synset> synsets;
+		std::vector<std::string> ids;
+		results.push_back( measure( "lookUpID", nops, [&]( size_t i) {
+			q.lookUpID( smp[i].id, smp[i].pos, syns);
+		}));
+		results.push_back( measure( "lookUpLiteral", nops, [&]( size_t i) {
+			q.lookUpLiteral( smp[i].literal, smp[i].pos, synsets);
+		}));
+		results.push_back( measure( "lookUpSense", nops, [&]( size_t i) {
+			q.lookUpSense( smp[i].literal, smp[i].sense, smp[i].pos, syns);
+		}));
+
+		// traversal
+		std::cerr << "Running traversals...\n";
+		results.push_back( measure( "traceRelation", nops, [&]( size_t i) {
+			q.traceRelation( smp[i].id, smp[i].pos, relation, ids);
+		}));
+		std::set<std::string> targets;
+		std::string found;
+		results.push_back( measure( "isIDConnectedWith", nops, [&]( size_t i) {
+			targets.clear();
+			targets.insert( smp[(i * 7 + 1) % smp.size()].id);
+			q.isIDConnectedWith( smp[i].id, smp[i].pos, relation, targets, found);
+		}));
+
+		// similarity (of pairs of literals: the second one is looked up in the POS of the first one)
+		std::cerr << "Running similarity...\n";
+		LibWNXML::WNQuery::tSims sims;
+		results.push_back( measure( "similarityLeacockChodorow", nops, [&]( size_t i) {
+			q.similarityLeacockChodorow( smp[i].literal, smp[(i * 13 + 5) % smp.size()].literal, smp[i].pos, relation, true, sims);
+		}));
+
+		write_table( results, std::cerr);
+		std::cerr << "peak RSS: " << peak_rss() / (1024 * 1024) << " MB\n";
+		write_json( synthetic != 0 ? "synthetic:" + std::to_string( (unsigned long long) synthetic) : input, results, std::cout);
+
+	} // try {
+	catch (const std::exception& e) {
+		std::cerr << e.what() << "\n";
+		return 1;
+	}
+	catch (...) {
+		std::cerr << "Unknown exception\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,348 @@
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <sstream>
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <errno.h>
+#include <signal.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include "Daemon.h"
+
+
+namespace {
+
+#ifdef _WIN32
+typedef SOCKET tSocket;
+const tSocket InvalidSocket = INVALID_SOCKET;
+void close_socket( tSocket s)		{ closesocket( s); }
+void shutdown_socket( tSocket s)	{ shutdown( s, SD_BOTH); }
+bool interrupted()					{ return false; }
+#else
+typedef int tSocket;
+const tSocket InvalidSocket = -1;
+void close_socket( tSocket s)		{ close( s); }
+void shutdown_socket( tSocket s)	{ shutdown( s, SHUT_RDWR); }
+bool interrupted()					{ return errno == EINTR; }
+#endif
+
+/// Longest command line accepted (the connection is closed if a line is longer)
+const size_t MaxLine = 1 << 20;
+
+/// Send all of data, false on error
+bool send_all( tSocket s, const char* data, size_t len)
+{
+	while (len != 0) {
+		int n = send( s, data, int( len), 0);
+		if (n < 0 && interrupted())
+			continue;
+		if (n <= 0)
+			return false;
+		data += n;
+		len -= size_t( n);
+	}
+	return true;
+}
+
+/// Check if address is a TCP port number
+bool is_port( const std::string& address)
+{
+	return !address.empty() && address.size() <= 5 && address.find_first_not_of( "0123456789") == std::string::npos;
+}
+
+} // namespace {
+
+
+/// A client connection. Shared by the reader, the writer and the commands of the connection
+/// being run, the socket is closed when all of them are done.
+struct Daemon::Connection
+{
+	Daemon&							daemon;
+	tSocket							sock;
+	std::mutex						mutex;		///< guards the members below
+	std::condition_variable			cond;		///< signals changes of the members below
+	std::map<size_t, std::string>	done;		///< responses not sent yet, by command number
+	size_t							count;		///< number of commands read
+	size_t							next;		///< number of the next response to send
+	bool							eof;		///< no more commands will be read
+	bool							broken;		///< sending failed
+
+	Connection( Daemon& d, tSocket s)
+		: daemon( d), sock( s), count( 0), next( 0), eof( false), broken( false)
+	{}
+
+	~Connection()
+	{
+		close_socket( sock);
+		{
+			std::lock_guard<std::mutex> lock( daemon.m_mutex);
+			daemon.m_connections--;
+		}
+		daemon.m_closed.notify_one();
+	}
+};
+
+
+Daemon::Daemon( const tProcessor& proc, unsigned nthreads)
+	: m_proc( proc)
+	, m_stop( false)
+	, m_connections( 0)
+{
+	if (nthreads == 0)
+		nthreads = std::thread::hardware_concurrency();
+	if (nthreads == 0)
+		nthreads = 1;
+	for (unsigned i=0; i!=nthreads; i++)
+		m_workers.push_back( std::thread( &Daemon::worker, this));
+}
+
+
+Daemon::~Daemon()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex);
+		m_stop = true;
+	}
+	m_cond.notify_all();
+	for (size_t i=0; i!=m_workers.size(); i++)
+		m_workers[i].join();
+}
+
+
+void Daemon::run( const std::string& address)
+{
+#ifdef _WIN32
+	WSADATA wsa;
+	if (WSAStartup( MAKEWORD( 2, 2), &wsa) != 0) {
+		ML_THROW_EXC( "Could not initialize sockets", DaemonException);
+	}
+#else
+	signal( SIGPIPE, SIG_IGN); // failed sends are handled where they happen
+#endif
+
+	tSocket ls = InvalidSocket;
+	if (is_port( address)) {
+		int port = atoi( address.c_str());
+		if (port <= 0 || port > 65535) {
+			ML_THROW_EXC( "Invalid port number: " << address, DaemonException);
+		}
+		ls = socket( AF_INET, SOCK_STREAM, 0);
+		if (ls == InvalidSocket) {
+			ML_THROW_EXC( "Could not create socket", DaemonException);
+		}
+		int one = 1;
+		setsockopt( ls, SOL_SOCKET, SO_REUSEADDR, (const char*) &one, sizeof(one));
+		sockaddr_in sa;
+		memset( &sa, 0, sizeof(sa));
+		sa.sin_family = AF_INET;
+		sa.sin_addr.s_addr = htonl( INADDR_LOOPBACK);
+		sa.sin_port = htons( (unsigned short) port);
+		if (bind( ls, (const sockaddr*) &sa, sizeof(sa)) != 0) {
+			close_socket( ls);
+			ML_THROW_EXC( "Could not bind to localhost port " << port, DaemonException);
+		}
+	}
+	else {
+#ifdef _WIN32
+		ML_THROW_EXC( "Unix domain sockets are not supported on this platform, give a TCP port instead of " << address, DaemonException);
+#else
+		sockaddr_un sa;
+		memset( &sa, 0, sizeof(sa));
+		sa.sun_family = AF_UNIX;
+		if (address.size() >= sizeof(sa.sun_path)) {
+			ML_THROW_EXC( "Socket path too long: " << address, DaemonException);
+		}
+		strcpy( sa.sun_path, address.c_str());
+		ls = socket( AF_UNIX, SOCK_STREAM, 0);
+		if (ls == InvalidSocket) {
+			ML_THROW_EXC( "Could not create socket", DaemonException);
+		}
+		// remove the socket file left by a previous run, unless a daemon is still listening on it
+		struct stat st;
+		if (stat( address.c_str(), &st) == 0 && S_ISSOCK( st.st_mode)) {
+			tSocket probe = socket( AF_UNIX, SOCK_STREAM, 0);
+			bool live = probe != InvalidSocket && connect( probe, (const sockaddr*) &sa, sizeof(sa)) == 0;
+			if (probe != InvalidSocket)
+				close_socket( probe);
+			if (live) {
+				close_socket( ls);
+				ML_THROW_EXC( "Socket is in use by another process: " << address, DaemonException);
+			}
+			unlink( address.c_str());
+		}
+		// other users must not connect: the socket file is created with access for the owner only
+		mode_t oldmask = umask( 0177);
+		int bound = bind( ls, (const sockaddr*) &sa, sizeof(sa));
+		umask( oldmask);
+		if (bound != 0 || chmod( address.c_str(), 0600) != 0) {
+			close_socket( ls);
+			ML_THROW_EXC( "Could not bind to socket " << address, DaemonException);
+		}
+#endif
+	}
+	if (listen( ls, SOMAXCONN) != 0) {
+		close_socket( ls);
+		ML_THROW_EXC( "Could not listen on " << address, DaemonException);
+	}
+
+	// accept connections; each gets a reader and a writer thread
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock( m_mutex);
+			while (m_connections >= MaxConnections)
+				m_closed.wait( lock);
+		}
+		tSocket s = accept( ls, NULL, NULL);
+		if (s == InvalidSocket) {
+			if (!interrupted()) // e.g. out of file descriptors: wait for some to be freed
+				std::this_thread::sleep_for( std::chrono::milliseconds( 100));
+			continue;
+		}
+		{
+			std::lock_guard<std::mutex> lock( m_mutex);
+			m_connections++;
+		}
+		std::shared_ptr<Connection> conn( new Connection( *this, s));
+		std::thread( &Daemon::reader, this, conn).detach();
+		std::thread( &Daemon::writer, conn).detach();
+	}
+}
+
+
+void Daemon::reader( std::shared_ptr<Connection> conn)
+{
+	std::string buf;
+	char chunk[4096];
+	bool quit = false;
+	while (!quit) {
+		int n = recv( conn->sock, chunk, sizeof(chunk), 0);
+		if (n < 0 && interrupted())
+			continue;
+		if (n <= 0) // closed by client (or by the writer)
+			break;
+		buf.append( chunk, size_t( n));
+		size_t start = 0, nl;
+		while (!quit && (nl = buf.find( '\n', start)) != std::string::npos) {
+			Command cmd;
+			cmd.query.assign( buf, start, nl - start);
+			start = nl + 1;
+			if (!cmd.query.empty() && cmd.query[cmd.query.size()-1] == '\r')
+				cmd.query.erase( cmd.query.size()-1);
+			if (cmd.query == ".q") {
+				quit = true;
+				break;
+			}
+			// wait for room in the pipeline
+			{
+				std::unique_lock<std::mutex> lock( conn->mutex);
+				while (conn->count - conn->next >= MaxPipeline && !conn->broken)
+					conn->cond.wait( lock);
+				if (conn->broken) {
+					quit = true;
+					break;
+				}
+				cmd.seq = conn->count++;
+			}
+			cmd.conn = conn;
+			{
+				std::lock_guard<std::mutex> lock( m_mutex);
+				m_queue.push_back( cmd);
+			}
+			m_cond.notify_one();
+		}
+		buf.erase( 0, start);
+		if (buf.size() > MaxLine)
+			break;
+	}
+	{
+		std::lock_guard<std::mutex> lock( conn->mutex);
+		conn->eof = true;
+	}
+	conn->cond.notify_all();
+}
+
+
+void Daemon::writer( std::shared_ptr<Connection> conn)
+{
+	std::unique_lock<std::mutex> lock( conn->mutex);
+	for (;;) {
+		std::map<size_t, std::string>::iterator it = conn->done.find( conn->next);
+		if (it == conn->done.end()) {
+			if (conn->eof && conn->next == conn->count) // all commands responded
+				break;
+			conn->cond.wait( lock);
+			continue;
+		}
+		std::string response;
+		response.swap( it->second);
+		conn->done.erase( it);
+		conn->next++;
+		lock.unlock();
+		bool sent = send_all( conn->sock, response.data(), response.size());
+		lock.lock();
+		conn->cond.notify_all(); // room in the pipeline
+		if (!sent) {
+			conn->broken = true;
+			shutdown_socket( conn->sock); // stop the reader too
+			break;
+		}
+	}
+	if (!conn->broken) // done: let the client see the end (the socket is closed when the last command is done)
+		shutdown_socket( conn->sock);
+}
+
+
+void Daemon::worker()
+{
+	for (;;) {
+		Command cmd;
+		{
+			std::unique_lock<std::mutex> lock( m_mutex);
+			while (!m_stop && m_queue.empty())
+				m_cond.wait( lock);
+			if (m_stop)
+				return;
+			cmd = m_queue.front();
+			m_queue.pop_front();
+		}
+
+		// run command (empty lines have no output)
+		std::ostringstream os;
+		const char* status = "OK";
+		try {
+			if (cmd.query.find_first_not_of( " \t") != std::string::npos)
+				m_proc( cmd.query, os);
+		}
+		catch (const DaemonException& e) {
+			status = "ERR";
+			os.str( e.msg());
+		}
+		catch (const std::exception& e) {
+			status = "ERR";
+			os.str( e.what());
+		}
+		catch (...) {
+			status = "ERR";
+			os.str( "Unknown exception");
+		}
+		std::string out = os.str();
+		std::ostringstream response;
+		response << status << " " << out.size() << "\n" << out;
+
+		// hand over to the writer of the connection
+		Connection& conn = *cmd.conn;
+		{
+			std::lock_guard<std::mutex> lock( conn.mutex);
+			conn.done[cmd.seq] = response.str();
+		}
+		conn.cond.notify_all();
+	}
+}
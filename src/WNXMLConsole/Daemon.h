@@ -0,0 +1,91 @@
+#ifndef __DAEMON_H__
+#define __DAEMON_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../MLUtils/Exception.h"
+
+/// Exception for socket errors of the daemon
+ML_EXCEPTION( DaemonException);
+
+/// Serves console commands to client processes connecting on a local socket, so that
+/// many clients can share one loaded WordNet.
+///
+/// Protocol: the client sends command lines, the same as typed in the console (e.g. ".i ENG-1 n"),
+/// terminated by '\n' ("\r\n" is accepted too). For every line it gets a response:
+///
+///   OK <length>\n<length bytes of command output>
+///   ERR <length>\n<length bytes of error message>
+///
+/// The client may send further commands without waiting for responses (pipelining): the commands
+/// are run concurrently on the worker threads, and the responses are sent in the order of the commands.
+/// ".q" closes the connection (after the responses to the preceding commands).
+class Daemon
+{
+public:
+
+	/// Runs one command line, writing its output to os. Called from several threads at the same time.
+	/// A DaemonException is sent to the client as an error (ERR response) with its message.
+	typedef std::function<void( const std::string& query, std::ostream& os)> tProcessor;
+
+	/// @param proc command processor
+	/// @param nthreads number of worker threads running commands (0: number of hardware threads)
+	Daemon( const tProcessor& proc, unsigned nthreads = 0);
+
+	/// Stop worker threads
+	~Daemon();
+
+	/// Listen for connections and serve them (does not return unless an error occurs).
+	/// @param address path of a Unix domain socket (created with access for the owner only), or a TCP port number
+	///  (then only connections from localhost are accepted)
+	/// @exception DaemonException if the socket can't be set up
+	void	run( const std::string& address);
+
+	/// Maximum number of commands of a connection being run or waiting to be sent (reading from the client stops
+	/// at this many, until responses are sent)
+	static const size_t MaxPipeline = 256;
+
+	/// Maximum number of connections served at the same time (each has a reader and a writer thread); further
+	/// connections wait in the listen queue until one is closed
+	static const size_t MaxConnections = 64;
+
+private:
+	Daemon( const Daemon&);				// not copyable
+	Daemon& operator=( const Daemon&);
+
+	struct Connection;
+	struct Command
+	{
+		std::shared_ptr<Connection>	conn;
+		size_t						seq;	///< number of command in the connection
+		std::string					query;
+	};
+
+	/// Read commands of a connection, queue them for the workers
+	void	reader( std::shared_ptr<Connection> conn);
+
+	/// Send the responses of a connection in the order of the commands
+	static void	writer( std::shared_ptr<Connection> conn);
+
+	/// Worker thread: run queued commands
+	void	worker();
+
+	tProcessor					m_proc;
+	std::vector<std::thread>	m_workers;
+	std::mutex					m_mutex;	///< guards the queue and the number of connections
+	std::condition_variable		m_cond;		///< signals workers: new command, or stop
+	std::condition_variable		m_closed;	///< signals the accepting thread: a connection was closed
+	std::deque<Command>			m_queue;
+	bool						m_stop;
+	size_t						m_connections;	///< number of open connections
+};
+
+
+#endif // #ifndef __DAEMON_H__
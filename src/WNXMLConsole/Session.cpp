@@ -0,0 +1,83 @@
+#include <ostream>
+#include "../CharConverter/EncodingNames.h"
+#include "Session.h"
+
+
+ML::CharEncoding::Enc Session::s_wnenc = ML::CharEncoding::ISO_8859_2;
+ML::CharEncoding::Enc Session::s_termenc = ML::CharEncoding::MSDOS_852;
+
+
+Session::Session( ML::CharEncoding::Enc wnenc, ML::CharEncoding::Enc termenc)
+{
+	if (wnenc != termenc) {
+		ML::CharEncoding wn = {wnenc, ML::CharEncoding::XT_CHREF_NORM}; // (as written by WNXMLParser)
+		ML::CharEncoding term = {termenc, ML::CharEncoding::XT_NONE};
+		m_decoder = ML::CharConverter::create( term, wn);
+		m_encoder = ML::CharConverter::create( wn, term);
+	}
+}
+
+
+ML::CharEncoding::Enc Session::encoding( const std::string& name)
+{
+	ML::CharEncoding::Enc enc = ML::EncodingNames::getEncoding( name.c_str());
+	if (enc == ML::CharEncoding::UNKNOWN) {
+		ML_THROW_EXC( "Unknown character encoding '" << name << "'", SessionException);
+	}
+	return enc;
+}
+
+
+void Session::setEncodings( ML::CharEncoding::Enc wnenc, ML::CharEncoding::Enc termenc)
+{
+	s_wnenc = wnenc;
+	s_termenc = termenc;
+}
+
+
+Session& Session::current()
+{
+	static thread_local std::auto_ptr<Session> session;
+	if (session.get() == NULL)
+		session.reset( new Session( s_wnenc, s_termenc));
+	return *session;
+}
+
+
+const std::string& Session::decode( const std::string& command)
+{
+	if (m_decoder.get() == NULL)
+		return command;
+	m_decoder->convert( command, m_command);
+	return m_command;
+}
+
+
+void Session::write( const std::string& text, std::ostream& os)
+{
+	if (m_encoder.get() == NULL)
+		os.write( text.data(), std::streamsize( text.size()));
+	else {
+		m_encoder->convert( text, m_conv);
+		os.write( m_conv.data(), std::streamsize( m_conv.size()));
+	}
+}
+
+
+void Session::writeSynset( const LibWNXML::Synset& syns, std::ostream& os)
+{
+	m_text.clear();
+	m_text += syns.id;
+	m_text += "  {";
+	for (size_t i=0; i!=syns.synonyms.size(); i++) {
+		if (i != 0)
+			m_text += ", ";
+		m_text += syns.synonyms[i].literal;
+		m_text += ':';
+		m_text += syns.synonyms[i].sense;
+	}
+	m_text += "}  (";
+	m_text += syns.def;
+	m_text += ")\n";
+	write( m_text, os);
+}
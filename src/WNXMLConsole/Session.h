@@ -0,0 +1,81 @@
+#ifndef __SESSION_H__
+#define __SESSION_H__
+
+#include <iosfwd>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "../CharConverter/CharConverter.h"
+#include "../MLUtils/Exception.h"
+#include "../LibWNXML/Synset.h"
+
+/// Exception for unknown character encodings
+ML_EXCEPTION( SessionException);
+
+/// Output layer of the console: converts commands from the encoding of the terminal to the encoding
+/// of the WordNet data, and results the other way.
+///
+/// The converters are created once, and the text is built in buffers reused for every synset, so
+/// writing long results (e.g. hyponym trees) does not create a converter or a stream per synset.
+/// If the terminal uses the encoding of the WordNet data, nothing is converted.
+/// A session is not thread-safe: each thread running commands uses its own (see current()).
+class Session
+{
+public:
+
+	/// @param wnenc encoding of the WordNet data (see WNQuery::encoding())
+	/// @param termenc encoding of the terminal
+	Session( ML::CharEncoding::Enc wnenc, ML::CharEncoding::Enc termenc);
+
+	/// Look up encoding name (for valid names, see CharConverter/EncodingNames.cpp)
+	/// @exception SessionException for unknown encodings
+	static ML::CharEncoding::Enc	encoding( const std::string& name) throw(SessionException);
+
+	/// Set the encodings of the sessions returned by current() (default: ISO-8859-2 WordNet, MS-DOS 852 terminal).
+	/// Call before any thread uses current().
+	static void		setEncodings( ML::CharEncoding::Enc wnenc, ML::CharEncoding::Enc termenc);
+
+	/// Session of the calling thread (created at the first call in the thread)
+	static Session&	current();
+
+	/// Convert command from terminal encoding (the result is valid until the next call)
+	const std::string&	decode( const std::string& command);
+
+	/// Write text (in WordNet encoding) to os, converted to terminal encoding
+	void	write( const std::string& text, std::ostream& os);
+
+	/// Write synset as a line: id  {literal:sense, ...}  (definition)
+	void	writeSynset( const LibWNXML::Synset& syns, std::ostream& os);
+
+	/// Empty reusable stream for collecting text to write (see writeStream()).
+	std::ostringstream&	stream()
+	{
+		m_stream.str( std::string());
+		m_stream.clear();
+		return m_stream;
+	}
+
+	/// Write the text collected in stream(), converted to terminal encoding
+	void	writeStream( std::ostream& os)
+	{
+		m_text = m_stream.str();
+		write( m_text, os);
+	}
+
+private:
+	Session( const Session&);				// not copyable
+	Session& operator=( const Session&);
+
+	std::auto_ptr<ML::CharConverter>	m_decoder;	///< terminal -> WordNet, NULL if the encodings are the same
+	std::auto_ptr<ML::CharConverter>	m_encoder;	///< WordNet -> terminal, NULL if the encodings are the same
+	std::string							m_command;	///< converted command
+	std::string							m_text;		///< text being built
+	std::string							m_conv;		///< converted text
+	std::ostringstream					m_stream;
+
+	static ML::CharEncoding::Enc		s_wnenc;
+	static ML::CharEncoding::Enc		s_termenc;
+};
+
+
+#endif // #ifndef __SESSION_H__
@@ -1,424 +1,780 @@
-/*
-
-TODO:
-
-
-*/
-
-
-#include <iostream>
-#include <memory>
-#include <sstream>
-#include <vector>
-#include "..\CharConverter\CharConverter.h"
-#include "../MLUtils/MultiLog.h"
-
-#include "../LibWNXML/WNQuery.h"
-#include "../SemFeatures/SemFeatures.h"
-
-
-const ML::CharEncoding winenc = {ML::CharEncoding::ISO_8859_2, ML::CharEncoding::XT_CHREF_NORM};
-const ML::CharEncoding dosenc = {ML::CharEncoding::MSDOS_852, ML::CharEncoding::XT_NONE};
-
-
-/// Tokenize a string, delimited by either of characters given, into a vector of strings.
-void split( const std::string& str, const std::string& tokchars, std::vector<std::string>& result)
-{
-//	ML::NewHandler newHandler;
-
-	char *tok = NULL;
-	char *buff = new char[str.size()+1];
-    
-	strcpy( buff, str.c_str());
-	result.clear();
-
-	tok = strtok( buff, tokchars.c_str());
-	while (tok != NULL) {
-		result.push_back( std::string( tok));
-		tok = strtok( NULL, tokchars.c_str());
-	}
-
-	delete[] buff;
-}
-
-
-void write_synset( const LibWNXML::Synset& syns, std::ostream& outp)
-{
-	std::ostringstream os;
-	
-	os << syns.id << "  {";
-	for (size_t i=0; i!=syns.synonyms.size(); i++) {
-		os << syns.synonyms[i].literal << ":" << syns.synonyms[i].sense;
-		if (i != syns.synonyms.size()-1)
-			os << ", ";
-	}
-	os << "}  (" << syns.def << ")";
-	
-	std::auto_ptr<ML::CharConverter> cc = ML::CharConverter::create( winenc, dosenc);
-	std::string str;
-	cc->convert( os.str(), str);
-
-	outp << str << std::endl;
-}
-
-
-void write_synset_id( const LibWNXML::WNQuery& wn, const std::string& id, const std::string& pos, std::ostream& outp)
-{
-	LibWNXML::Synset syns;
-	wn.lookUpID( id, pos, syns);
-	if (!syns.empty())
-		write_synset( syns, outp);
-}
-
-
-void process_query( const LibWNXML::WNQuery& wn, ML_NPro2::SemFeatures* sf, const std::string& query, std::ostream& os)
-{
-	std::string str;
-	std::auto_ptr<ML::CharConverter> cc = ML::CharConverter::create( dosenc, winenc);
-	cc->convert( query, str);
-	std::vector<std::string> t;
-	split( str, " ", t);
-
-	if (t[0] == ".h") { // .h
-		os << "Available commands:\n";
-		os << ".h                                               this help\n";
-		os << ".q                                               quit\n";
-		os << ".i   <id> <pos>                                   look up synset id in given POS (n,v,a,b)\n";
-		os << ".l   <literal>                                    look up all synsets containing literal in all POS\n";
-		os << ".l   <literal> <pos>                              look up all synsets containing literal in given POS\n";
-		os << ".l   <literal> <sensenum> <pos>                   look up synset containing literal with given sense number in given POS\n";
-		os << ".rl  <literal> <pos>                              list known relations of all senses of literal in POS\n";
-		os << ".rl  <literal> <pos> <relation>                   look up relation (hypernym, hyponym) of all senses of literal with id and POS, list target ids\n";		
-		os << ".ri  <id> <pos> <relation>                        look up relation of synset with id and POS, list target ids\n";
-		os << ".ti  <id> <pos> <relation>                        trace relations of synset with id and POS\n";
-		os << ".tl  <literal> <pos> <relation>                   trace relations of all senses of literal in POS\n";
-		os << ".ci  <id> <pos> <relation> <id1> [<id2>...]       check if any of id1,id2,... is reachable from id by following relation\n";
-		os << ".cl  <literal> <pos> <relation> <id1> [<id2>...]  check if any of id1,id2,... is reachable from any sense of literal by following relation\n";
-		os << ".cli <literal> <pos> <id> [hyponyms]              check if synset contains literal, or if \"hyponyms\" is added, any of its hyponyms\n";
-		os << ".slc <literal1> <literal2> <pos> <relation> [top] calculate Leacock-Chodorow similarity for all senses of literals in pos using relation\n";
-		os << "                                                  if 'top' is added, an artificial root node is added to relation paths, making WN interconnected.\n";
-		if (sf != NULL) {
-			os << ".s  <feature>                                     look up semantic feature\n";
-			os << ".sc <literal> <pos> <feature>                    check whether any sense of literal is compatible with semantic feature\n";
-		}
-		os << "\n";
-	}
-
-	else if (t[0] == ".i") { // .i
-		if (t.size() != 3) {
-			os << "Incorrect format for command .i\n\n";
-			return;
-		}
-		LibWNXML::Synset syns;
-		if (!wn.lookUpID( t[1], t[2], syns))
-			os << "Synset not found\n\n";
-		else {
-			write_synset( syns, os);
-			os << std::endl;
-		}
-	}
-
-	else if (t[0] == ".l") { // .l
-		if (t.size() != 2 && t.size() != 3 && t.size() != 4) {
-			os << "Incorrect format for command .l\n\n";
-			return;
-		}
-		if (t.size() == 2) { // .l <literal>
-			std::vector<LibWNXML::Synset> res1, res;
-			wn.lookUpLiteral(t[1], "n", res1);
-			res.insert( res.end(), res1.begin(), res1.end());
-			wn.lookUpLiteral(t[1], "v", res1);
-			res.insert( res.end(), res1.begin(), res1.end());
-			wn.lookUpLiteral(t[1], "a", res1);
-			res.insert( res.end(), res1.begin(), res1.end());
-			wn.lookUpLiteral(t[1], "b", res1);
-			res.insert( res.end(), res1.begin(), res1.end());
-			if (res.empty())
-				os << "Literal not found\n\n";
-			else {
-				for (size_t i=0; i!=res.size(); i++)
-					write_synset( res[i], os);
-				os << std::endl;
-			}
-		}
-		else if (t.size() == 3) { // .l <literal> <pos>
-			std::vector<LibWNXML::Synset> res;
-			if (!wn.lookUpLiteral(t[1], t[2], res))
-				os << "Literal not found\n\n";
-			else {
-				for (size_t i=0; i!=res.size(); i++)
-					write_synset( res[i], os);
-				os << std::endl;
-			}
-		}
-		else if (t.size() == 4) {  // .l <literal> <sensenum> <pos>
-			LibWNXML::Synset syns;
-			if (!wn.lookUpSense(t[1], atoi(t[2].c_str()), t[3], syns))
-				os << "Word sense not found\n\n";
-			else {
-				write_synset( syns, os);
-				os << std::endl;
-			}
-		}
-	}
-
-	else if (t[0] == ".rl") { // .rl
-		if (t.size() != 4 && t.size() != 3) {
-			os << "Incorrect format for command .rl\n\n";
-			return;
-		}
-		if (t.size() == 3) { // .rl <literal> <pos>
-			std::vector<LibWNXML::Synset> ss;
-			wn.lookUpLiteral( t[1], t[2], ss);
-			if (ss.empty())
-				os << "Literal not found\n";
-			else {
-				std::set<std::string> rs;
-				for (size_t j=0; j!=ss.size(); j++) {
-					write_synset( ss[j], os);
-					rs.clear();
-					for (size_t i=0; i!=ss[j].ilrs.size(); i++)
-						if (rs.count( ss[j].ilrs[i].second) == 0) {
-							os << "  " << ss[j].ilrs[i].second << std::endl;
-							rs.insert( ss[j].ilrs[i].second);
-						}
-					os << std::endl;
-				}
-			}
-		}
-		if (t.size() == 4) { // .rl <literal> <pos> <relation>
-			std::vector<std::string> ss;
-			wn.lookUpLiteral( t[1], t[2], ss);
-			if (ss.empty())
-				os << "Literal not found\n";
-			else 
-				for (size_t j=0; j!=ss.size(); j++) {
-					write_synset_id( wn, ss[j], t[2], os);
-					std::vector<std::string> ids;
-					wn.lookUpRelation( ss[j], t[2], t[3], ids);
-					if (!ids.empty())
-						for (size_t i=0; i!=ids.size(); i++) {
-							os << "  ";
-							write_synset_id( wn, ids[i], t[2], os);
-						}
-					os << std::endl;
-				}
-		}
-	}
-
-	else if (t[0] == ".ri") { // .ri
-		if (t.size() != 4) {
-			os << "Incorrect format for command .ri\n\n";
-			return;
-		}
-		std::vector<std::string> ids;
-		wn.lookUpRelation( t[1], t[2], t[3], ids);
-		if (ids.empty())
-			os << "Synset not found or has no relations of the specified type\n";
-		else
-			for (size_t i=0; i!=ids.size(); i++)
-				write_synset_id( wn, ids[i], t[2], os);
-	}
-
-	else if (t[0] == ".ti") { // .ti
-		if (t.size() != 4) {
-			os << "Incorrect format for command .ti\n\n";
-			return;
-		}
-		std::ostringstream oss;
-		wn.traceRelationOS( t[1], t[2], t[3], oss);
-		if (oss.str().empty())
-			os << "Synset not found\n\n";
-		else {
-			std::auto_ptr<ML::CharConverter> cc = ML::CharConverter::create( winenc, dosenc);
-			std::string str;
-			cc->convert( oss.str(), str);
-			os << str << std::endl;
-		}
-	}
-
-	else if (t[0] == ".tl") { // .tl
-		if (t.size() != 4) {
-			os << "Incorrect format for command .ti\n\n";
-			return;
-		}
-		std::vector<LibWNXML::Synset> senses;
-		if (!wn.lookUpLiteral( t[1], t[2], senses)) {
-			os << "Literal not found\n\n";
-			return;
-		}
-		for (size_t i=0; i!=senses.size(); i++) {
-			std::ostringstream oss;
-			wn.traceRelationOS( senses[i].id, t[2], t[3], oss);
-			if (!oss.str().empty()) {
-				std::auto_ptr<ML::CharConverter> cc = ML::CharConverter::create( winenc, dosenc);
-				std::string str;
-				cc->convert( oss.str(), str);
-				os << str << std::endl;
-			}
-		}
-	}
-
-	else if (t[0] == ".ci") { // .ci
-		if (t.size() < 5) {
-			os << "Incorrect format for command .ci\n";
-			return;
-		}
-		std::set<std::string> ids;
-		for (size_t i=4; i!=t.size(); i++)
-			ids.insert( t[i]);
-		std::string foundtarg;
-		if (wn.isIDConnectedWith( t[1], t[2], t[3], ids, foundtarg))
-			os << "Connection found to " << foundtarg << std::endl;
-		else
-			os << "No connection found\n";
-	}
-
-	else if (t[0] == ".cl") { // .cl
-		if (t.size() < 5) {
-			os << "Incorrect format for command .cl\n";
-			return;
-		}
-		std::set<std::string> ids;
-		for (size_t i=4; i!=t.size(); i++)
-			ids.insert( t[i]);
-		std::string foundid;
-		std::string foundtarg;
-		if (wn.isLiteralConnectedWith( t[1], t[2], t[3], ids, foundid, foundtarg))
-			os << "Connection found:\nSense of literal: " << foundid << "\nTarget id: " << foundtarg << std::endl;
-		else
-			os << "No connection found\n";
-	}
-
-	else if (t[0] == ".s") { // .s
-		if (sf == NULL) {
-			os << "Sorry, semantic features not loaded.\n";
-			return;
-		}
-		if (t.size() != 2) {
-			os << "Incorrect format for command .s\n";
-			return;
-		}
-		std::set<std::string> ids;
-		if (sf->lookUpFeature( t[1], ids)) {
-			os << int(ids.size()) << " synset(s) found:\n";
-			for (std::set<std::string>::iterator i=ids.begin(); i!=ids.end(); i++)
-				os << *i << std::endl;
-		}
-		else {
-			os << "Semantic feature not found\n";
-		}
-	}
-
-	else if (t[0] == ".sc") { // .sc
-		if (sf == NULL) {
-			os << "Sorry, semantic features not loaded.\n";
-			return;
-		}
-		if (t.size() != 4) {
-			os << "Incorrect format for command .sc\n";
-			return;
-		}
-		std::string foundid, foundtargid;
-		if (sf->isLiteralCompatibleWithFeature( t[1], t[2], t[3], foundid, foundtargid)) {
-			os << "Compatibility found:\n";		
-			os << "Sense of literal: ";
-			write_synset_id( wn, foundid, t[2], os);
-			os << "Synset ID pertaining to feature: ";
-			write_synset_id( wn, foundtargid, t[2], os);
-		}
-		else {
-			os << "Compatibility not found\n";
-		}
-	}
-	
-	else if (t[0] == ".cli") { // .cli <literal> <pos> <id> [hyponyms]
-		if ((t.size() != 4 && t.size() != 5) || (t.size() == 5 && t[4] !="hyponyms")) {
-			os << "Incorrect format for command .cli\n";
-			return;
-		}
-		bool hyps = (t.size() == 5 && t[4] == "hyponyms");
-		if (wn.isLiteralCompatibleWithSynset( t[1], t[2], t[3], hyps))
-			os << "Compatible\n";
-		else
-			os << "Not compatible\n";
-	}
-	
-	else if (t[0] == ".slc") { // .slc <literal1> <literal2> <pos> <relation>
-		if ((t.size() != 5 && t.size() != 6) || (t.size() == 6 && t[5] != "top")) {
-			os << "Incorrect format for command .slc\n";
-			return;
-		}
-		LibWNXML::WNQuery::tSims res;
-		bool addtop = (t.size() == 6);
-		wn.similarityLeacockChodorow( t[1], t[2], t[3], t[4], addtop, res);
-		os << "Results:\n";
-		for (LibWNXML::WNQuery::tSims::reverse_iterator it=res.rbegin(); it!=res.rend(); it++)
-			os << "  " << it->first << "    " << it->second.first << "  " << it->second.second << "\n";
-	}
-
-	else {
-		os << "Unknown command\n\n";
-	}
-
-
-}
-
-
-int main( int argc, char *argv[])
-{
-	try {
-		
-		// check command line
-		if (argc != 2 && argc != 3) {
-			std::cerr << "Usage:\n  WNXMLConsole <WN_XML_file> [<semantic_features_XML_file>]\n";
-			return 1;
-		}
-
-		// init WN
-		std::cerr << "Reading XML...\n";
-		std::auto_ptr<ML::MultiLog> logger( ML::MultiLog::create( std::cerr, 100));
-		std::auto_ptr<LibWNXML::WNQuery> wn( new LibWNXML::WNQuery( argv[1], *logger));
-		wn->writeStats( std::cerr);
-
-		// init SemFeatures (if appl.)
-		std::auto_ptr<ML_NPro2::SemFeatures> sf( NULL);
-		if (argc == 3) {
-			std::cerr << "Reading SemFeatures...\n";
-			sf = std::auto_ptr<ML_NPro2::SemFeatures>( new ML_NPro2::SemFeatures( *wn));
-			std::cerr << sf->readXML( argv[2]) << " pairs read\n";
-		}
-
-		// query loop
-		std::cerr << "Type your query, or .h for help, .q to quit\n";
-		std::string line;
-		while (true) {	
-			
-			std::cerr << ">";
-			std::getline( std::cin, line);
-
-			if (line == ".q")
-				break;
-			else if (line != "") {
-				try {
-					process_query( *wn, sf.get(), line, std::cout);
-				}
-				catch (const LibWNXML::InvalidPOSException& e) {
-					std::cerr << e.msg() << std::endl;
-				}
-			}
-
-		} // while (true)
-
-	} // try {
-	catch (const std::exception& e) {
-		std::cerr << e.what() << std::endl;
-		return 1;
-	}
-	catch (...) {
-		std::cerr << "Unknown exception\n";
-		return 1;
-	}
-	
-	return 0;
-}
+/*
+
+TODO:
+
+
+*/
+
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include "../MLUtils/MultiLog.h"
+
+#include "../LibWNXML/ThreadPool.h"
+#include "../LibWNXML/WNQuery.h"
+#include "../LibWNXML/WNXMLParser.h"
+#include "../SemFeatures/SemFeatures.h"
+#include "Daemon.h"
+#include "Session.h"
+
+
+/// Tokenize a string, delimited by either of characters given, into a vector of strings.
+/// (Doesn't use strtok(), so it can be called from several threads, see daemon mode.)
+void split( const std::string& str, const std::string& tokchars, std::vector<std::string>& result)
+{
+	result.clear();
+	size_t start = str.find_first_not_of( tokchars);
+	while (start != std::string::npos) {
+		size_t end = str.find_first_of( tokchars, start);
+		result.push_back( str.substr( start, end - start));
+		start = str.find_first_not_of( tokchars, end);
+	}
+}
+
+
+void write_synset( const LibWNXML::Synset& syns, std::ostream& outp)
+{
+	Session::current().writeSynset( syns, outp);
+}
+
+
+void write_synset_id( const LibWNXML::WNQuery& wn, const std::string& id, const std::string& pos, std::ostream& outp)
+{
+	LibWNXML::Synset syns;
+	wn.lookUpID( id, pos, syns);
+	if (!syns.empty())
+		write_synset( syns, outp);
+}
+
+
+/// Write the literals with the same folded form as a literal that was not found (the same word with different case
+/// or accents), then the nearest ones within 2 edits, if there are any
+void write_suggestions( const LibWNXML::WNQuery& wn, const std::string& literal, const std::string& pos, std::ostream& outp)
+{
+	std::vector<std::string> res;
+	wn.findFoldedLiterals( literal, pos, res);
+	LibWNXML::WNQuery::tFuzzyMatches fuzzy;
+	wn.fuzzyLookUpLiteral( literal, pos, 2, 5, fuzzy);
+	for (size_t i=0; i!=fuzzy.size() && res.size()<5; i++)
+		if (std::find( res.begin(), res.end(), fuzzy[i].first) == res.end())
+			res.push_back( fuzzy[i].first);
+	if (res.empty())
+		return;
+	outp << "Did you mean: ";
+	for (size_t i=0; i!=res.size(); i++) {
+		if (i != 0)
+			outp << ", ";
+		Session::current().write( res[i], outp);
+	}
+	outp << "?\n";
+}
+
+
+void process_query( const LibWNXML::WNQuery& wn, ML_NPro2::SemFeatures* sf, const std::string& query, std::ostream& os)
+{
+	Session& session = Session::current();
+	std::vector<std::string> t;
+	split( session.decode( query), " ", t);
+
+	if (t[0] == ".h") { // .h
+		os << "Available commands:\n";
+		os << ".h                                               this help\n";
+		os << ".q                                               quit\n";
+		os << ".i   <id> <pos>                                   look up synset id in given POS (n,v,a,b)\n";
+		os << ".l   <literal>                                    look up all synsets containing literal in all POS\n";
+		os << ".l   <literal> <pos>                              look up all synsets containing literal in given POS\n";
+		os << ".l   <literal> <sensenum> <pos>                   look up synset containing literal with given sense number in given POS\n";
+		os << ".lf  <literal> [<pos>]                            look up all synsets containing literal ignoring case and accents, in given POS or all POS\n";
+		os << ".f   <literal> [<pos> [<distance>]]               list the literals nearest to literal (misspelled), at most distance (default 2) edits away\n";
+		os << ".p   <prefix> [<pos> [<k>]]                       list the k (default 10) literals starting with prefix that have the most senses (in POS)\n";
+		os << ".ps  <prefix> [<pos> [<k>]]                       list the k (default 10) synsets of the senses of these literals\n";
+		os << ".rl  <literal> <pos>                              list known relations of all senses of literal in POS\n";
+		os << ".rl  <literal> <pos> <relation>                   look up relation (hypernym, hyponym) of all senses of literal with id and POS, list target ids\n";		
+		os << ".ri  <id> <pos> <relation>                        look up relation of synset with id and POS, list target ids\n";
+		os << ".ti  <id> <pos> <relation>                        trace relations of synset with id and POS\n";
+		os << ".tl  <literal> <pos> <relation>                   trace relations of all senses of literal in POS\n";
+		os << ".ci  <id> <pos> <relation> <id1> [<id2>...]       check if any of id1,id2,... is reachable from id by following relation\n";
+		os << ".cl  <literal> <pos> <relation> <id1> [<id2>...]  check if any of id1,id2,... is reachable from any sense of literal by following relation\n";
+		os << ".cli <literal> <pos> <id> [hyponyms]              check if synset contains literal, or if \"hyponyms\" is added, any of its hyponyms\n";
+		os << ".slc <literal1> <literal2> <pos> <relation> [top] calculate Leacock-Chodorow similarity for all senses of literals in pos using relation\n";
+		os << "                                                  if 'top' is added, an artificial root node is added to relation paths, making WN interconnected.\n";
+		os << ".nn  <id> <pos> <relation> <k> [top]              list the k synsets most similar to synset id by Leacock-Chodorow similarity (see .slc)\n";
+		os << ".ws  <file>                                       write binary snapshot of the loaded WN to file (can be given instead of the XML file at startup)\n";
+		os << ".patch <file>                                     apply a WNXML file of added, modified and deleted synsets (only in the interactive console)\n";
+		os << ".stats                                            write load statistics and query latency histograms (Prometheus text format)\n";
+		if (sf != NULL) {
+			os << ".s  <feature>                                     look up semantic feature\n";
+			os << ".sc <literal> <pos> <feature>                    check whether any sense of literal is compatible with semantic feature\n";
+		}
+		os << "\n";
+	}
+
+	else if (t[0] == ".i") { // .i
+		if (t.size() != 3) {
+			os << "Incorrect format for command .i\n\n";
+			return;
+		}
+		LibWNXML::Synset syns;
+		if (!wn.lookUpID( t[1], t[2], syns))
+			os << "Synset not found\n\n";
+		else {
+			write_synset( syns, os);
+			os << "\n";
+		}
+	}
+
+	else if (t[0] == ".l") { // .l
+		if (t.size() != 2 && t.size() != 3 && t.size() != 4) {
+			os << "Incorrect format for command .l\n\n";
+			return;
+		}
+		if (t.size() == 2) { // .l <literal>
+			std::vector<LibWNXML::Synset> res1, res;
+			wn.lookUpLiteral(t[1], "n", res1);
+			res.insert( res.end(), res1.begin(), res1.end());
+			wn.lookUpLiteral(t[1], "v", res1);
+			res.insert( res.end(), res1.begin(), res1.end());
+			wn.lookUpLiteral(t[1], "a", res1);
+			res.insert( res.end(), res1.begin(), res1.end());
+			wn.lookUpLiteral(t[1], "b", res1);
+			res.insert( res.end(), res1.begin(), res1.end());
+			if (res.empty()) {
+				os << "Literal not found\n";
+				write_suggestions( wn, t[1], "", os);
+				os << "\n";
+			}
+			else {
+				for (size_t i=0; i!=res.size(); i++)
+					write_synset( res[i], os);
+				os << "\n";
+			}
+		}
+		else if (t.size() == 3) { // .l <literal> <pos>
+			std::vector<LibWNXML::Synset> res;
+			if (!wn.lookUpLiteral(t[1], t[2], res)) {
+				os << "Literal not found\n";
+				write_suggestions( wn, t[1], t[2], os);
+				os << "\n";
+			}
+			else {
+				for (size_t i=0; i!=res.size(); i++)
+					write_synset( res[i], os);
+				os << "\n";
+			}
+		}
+		else if (t.size() == 4) {  // .l <literal> <sensenum> <pos>
+			LibWNXML::Synset syns;
+			if (!wn.lookUpSense(t[1], atoi(t[2].c_str()), t[3], syns))
+				os << "Word sense not found\n\n";
+			else {
+				write_synset( syns, os);
+				os << "\n";
+			}
+		}
+	}
+
+	else if (t[0] == ".lf") { // .lf <literal> [<pos>]
+		if (t.size() != 2 && t.size() != 3) {
+			os << "Incorrect format for command .lf\n\n";
+			return;
+		}
+		std::vector<LibWNXML::Synset> res;
+		if (t.size() == 2) { // all POS
+			const char* const allpos[4] = { "n", "v", "a", "b" };
+			std::vector<LibWNXML::Synset> res1;
+			for (int p=0; p!=4; p++) {
+				wn.lookUpLiteralFolded( t[1], allpos[p], res1);
+				res.insert( res.end(), res1.begin(), res1.end());
+			}
+		}
+		else
+			wn.lookUpLiteralFolded( t[1], t[2], res);
+		if (res.empty())
+			os << "Literal not found\n\n";
+		else {
+			for (size_t i=0; i!=res.size(); i++)
+				write_synset( res[i], os);
+			os << "\n";
+		}
+	}
+
+	else if (t[0] == ".f") { // .f <literal> [<pos> [<distance>]]
+		if (t.size() < 2 || t.size() > 4 || (t.size() == 4 && atoi( t[3].c_str()) < 0)) {
+			os << "Incorrect format for command .f\n\n";
+			return;
+		}
+		LibWNXML::WNQuery::tFuzzyMatches res;
+		wn.fuzzyLookUpLiteral( t[1], t.size() >= 3 ? t[2] : "", t.size() == 4 ? unsigned( atoi( t[3].c_str())) : 2, 10, res);
+		if (res.empty())
+			os << "No literal found\n\n";
+		else {
+			for (size_t i=0; i!=res.size(); i++) {
+				os << "  ";
+				session.write( res[i].first, os);
+				os << "  " << res[i].second << "\n";
+			}
+			os << "\n";
+		}
+	}
+
+	else if (t[0] == ".p" || t[0] == ".ps") { // .p <prefix> [<pos> [<k>]], .ps <prefix> [<pos> [<k>]]
+		if (t.size() < 2 || t.size() > 4 || (t.size() == 4 && atoi( t[3].c_str()) <= 0)) {
+			os << "Incorrect format for command " << t[0] << "\n\n";
+			return;
+		}
+		std::string pos = t.size() >= 3 ? t[2] : "";
+		size_t k = t.size() == 4 ? size_t( atoi( t[3].c_str())) : 10;
+		if (t[0] == ".p") {
+			LibWNXML::WNQuery::tCompletions res;
+			wn.completeLiteral( t[1], pos, k, res);
+			if (res.empty())
+				os << "No literal found\n\n";
+			else {
+				for (size_t i=0; i!=res.size(); i++) {
+					os << "  ";
+					session.write( res[i].first, os);
+					os << "  " << res[i].second << "\n";
+				}
+				os << "\n";
+			}
+		}
+		else {
+			std::vector< std::pair<std::string, std::string> > res;
+			wn.completeLiteralSynsets( t[1], pos, k, res);
+			if (res.empty())
+				os << "No literal found\n\n";
+			else {
+				for (size_t i=0; i!=res.size(); i++)
+					write_synset_id( wn, res[i].second, res[i].first, os);
+				os << "\n";
+			}
+		}
+	}
+
+	else if (t[0] == ".rl") { // .rl
+		if (t.size() != 4 && t.size() != 3) {
+			os << "Incorrect format for command .rl\n\n";
+			return;
+		}
+		if (t.size() == 3) { // .rl <literal> <pos>
+			std::vector<LibWNXML::Synset> ss;
+			wn.lookUpLiteral( t[1], t[2], ss);
+			if (ss.empty())
+				os << "Literal not found\n";
+			else {
+				std::set<std::string> rs;
+				for (size_t j=0; j!=ss.size(); j++) {
+					write_synset( ss[j], os);
+					rs.clear();
+					for (size_t i=0; i!=ss[j].ilrs.size(); i++)
+						if (rs.count( ss[j].ilrs[i].second) == 0) {
+							os << "  " << ss[j].ilrs[i].second << "\n";
+							rs.insert( ss[j].ilrs[i].second);
+						}
+					os << "\n";
+				}
+			}
+		}
+		if (t.size() == 4) { // .rl <literal> <pos> <relation>
+			std::vector<std::string> ss;
+			wn.lookUpLiteral( t[1], t[2], ss);
+			if (ss.empty())
+				os << "Literal not found\n";
+			else 
+				for (size_t j=0; j!=ss.size(); j++) {
+					write_synset_id( wn, ss[j], t[2], os);
+					std::vector<std::string> ids;
+					wn.lookUpRelation( ss[j], t[2], t[3], ids);
+					if (!ids.empty())
+						for (size_t i=0; i!=ids.size(); i++) {
+							os << "  ";
+							write_synset_id( wn, ids[i], t[2], os);
+						}
+					os << "\n";
+				}
+		}
+	}
+
+	else if (t[0] == ".ri") { // .ri
+		if (t.size() != 4) {
+			os << "Incorrect format for command .ri\n\n";
+			return;
+		}
+		std::vector<std::string> ids;
+		wn.lookUpRelation( t[1], t[2], t[3], ids);
+		if (ids.empty())
+			os << "Synset not found or has no relations of the specified type\n";
+		else
+			for (size_t i=0; i!=ids.size(); i++)
+				write_synset_id( wn, ids[i], t[2], os);
+	}
+
+	else if (t[0] == ".ti") { // .ti
+		if (t.size() != 4) {
+			os << "Incorrect format for command .ti\n\n";
+			return;
+		}
+		std::ostringstream& oss = session.stream();
+		wn.traceRelationOS( t[1], t[2], t[3], oss);
+		if (oss.tellp() == 0)
+			os << "Synset not found\n\n";
+		else {
+			session.writeStream( os);
+			os << "\n";
+		}
+	}
+
+	else if (t[0] == ".tl") { // .tl
+		if (t.size() != 4) {
+			os << "Incorrect format for command .ti\n\n";
+			return;
+		}
+		std::vector<LibWNXML::Synset> senses;
+		if (!wn.lookUpLiteral( t[1], t[2], senses)) {
+			os << "Literal not found\n\n";
+			return;
+		}
+		for (size_t i=0; i!=senses.size(); i++) {
+			std::ostringstream& oss = session.stream();
+			wn.traceRelationOS( senses[i].id, t[2], t[3], oss);
+			if (oss.tellp() != 0) {
+				session.writeStream( os);
+				os << "\n";
+			}
+		}
+	}
+
+	else if (t[0] == ".ci") { // .ci
+		if (t.size() < 5) {
+			os << "Incorrect format for command .ci\n";
+			return;
+		}
+		std::set<std::string> ids;
+		for (size_t i=4; i!=t.size(); i++)
+			ids.insert( t[i]);
+		std::string foundtarg;
+		if (wn.isIDConnectedWith( t[1], t[2], t[3], ids, foundtarg))
+			os << "Connection found to " << foundtarg << "\n";
+		else
+			os << "No connection found\n";
+	}
+
+	else if (t[0] == ".cl") { // .cl
+		if (t.size() < 5) {
+			os << "Incorrect format for command .cl\n";
+			return;
+		}
+		std::set<std::string> ids;
+		for (size_t i=4; i!=t.size(); i++)
+			ids.insert( t[i]);
+		std::string foundid;
+		std::string foundtarg;
+		if (wn.isLiteralConnectedWith( t[1], t[2], t[3], ids, foundid, foundtarg))
+			os << "Connection found:\nSense of literal: " << foundid << "\nTarget id: " << foundtarg << "\n";
+		else
+			os << "No connection found\n";
+	}
+
+	else if (t[0] == ".s") { // .s
+		if (sf == NULL) {
+			os << "Sorry, semantic features not loaded.\n";
+			return;
+		}
+		if (t.size() != 2) {
+			os << "Incorrect format for command .s\n";
+			return;
+		}
+		std::set<std::string> ids;
+		if (sf->lookUpFeature( t[1], ids)) {
+			os << int(ids.size()) << " synset(s) found:\n";
+			for (std::set<std::string>::iterator i=ids.begin(); i!=ids.end(); i++)
+				os << *i << "\n";
+		}
+		else {
+			os << "Semantic feature not found\n";
+		}
+	}
+
+	else if (t[0] == ".sc") { // .sc
+		if (sf == NULL) {
+			os << "Sorry, semantic features not loaded.\n";
+			return;
+		}
+		if (t.size() != 4) {
+			os << "Incorrect format for command .sc\n";
+			return;
+		}
+		std::string foundid, foundtargid;
+		if (sf->isLiteralCompatibleWithFeature( t[1], t[2], t[3], foundid, foundtargid)) {
+			os << "Compatibility found:\n";		
+			os << "Sense of literal: ";
+			write_synset_id( wn, foundid, t[2], os);
+			os << "Synset ID pertaining to feature: ";
+			write_synset_id( wn, foundtargid, t[2], os);
+		}
+		else {
+			os << "Compatibility not found\n";
+		}
+	}
+	
+	else if (t[0] == ".cli") { // .cli <literal> <pos> <id> [hyponyms]
+		if ((t.size() != 4 && t.size() != 5) || (t.size() == 5 && t[4] !="hyponyms")) {
+			os << "Incorrect format for command .cli\n";
+			return;
+		}
+		bool hyps = (t.size() == 5 && t[4] == "hyponyms");
+		if (wn.isLiteralCompatibleWithSynset( t[1], t[2], t[3], hyps))
+			os << "Compatible\n";
+		else
+			os << "Not compatible\n";
+	}
+	
+	else if (t[0] == ".slc") { // .slc <literal1> <literal2> <pos> <relation>
+		if ((t.size() != 5 && t.size() != 6) || (t.size() == 6 && t[5] != "top")) {
+			os << "Incorrect format for command .slc\n";
+			return;
+		}
+		LibWNXML::WNQuery::tSims res;
+		bool addtop = (t.size() == 6);
+		wn.similarityLeacockChodorow( t[1], t[2], t[3], t[4], addtop, res);
+		os << "Results:\n";
+		for (LibWNXML::WNQuery::tSims::reverse_iterator it=res.rbegin(); it!=res.rend(); it++)
+			os << "  " << it->first << "    " << it->second.first << "  " << it->second.second << "\n";
+	}
+
+	else if (t[0] == ".nn") { // .nn <id> <pos> <relation> <k> [top]
+		if ((t.size() != 5 && t.size() != 6) || (t.size() == 6 && t[5] != "top") || atoi( t[4].c_str()) <= 0) {
+			os << "Incorrect format for command .nn\n";
+			return;
+		}
+		LibWNXML::WNQuery::tNeighbors res;
+		bool addtop = (t.size() == 6);
+		wn.nearestNeighbors( t[1], t[2], t[3], size_t( atoi( t[4].c_str())), addtop, res);
+		os << "Results:\n";
+		for (size_t i=0; i!=res.size(); i++) {
+			os << "  " << res[i].second << "    ";
+			write_synset_id( wn, res[i].first, t[2], os);
+		}
+	}
+
+	else if (t[0] == ".ws") { // .ws <file>
+		if (t.size() != 2) {
+			os << "Incorrect format for command .ws\n";
+			return;
+		}
+		try {
+			wn.saveSnapshot( t[1]);
+			os << "Snapshot written to " << t[1] << "\n";
+		}
+		catch (const LibWNXML::WNQueryException& e) {
+			os << e.msg() << "\n";
+		}
+	}
+
+	else if (t[0] == ".stats") { // .stats
+		if (t.size() != 1) {
+			os << "Incorrect format for command .stats\n";
+			return;
+		}
+		wn.statistics().write( os);
+	}
+
+	else {
+		os << "Unknown command\n\n";
+	}
+
+
+}
+
+
+/// Length of the UTF-8 sequence at str[i], 0 if it's not a valid sequence
+size_t utf8_length( const std::string& str, size_t i)
+{
+	unsigned char c = (unsigned char) str[i];
+	size_t n = c < 0x80 ? 1 : c >= 0xC2 && c <= 0xDF ? 2 : c >= 0xE0 && c <= 0xEF ? 3 : c >= 0xF0 && c <= 0xF4 ? 4 : 0;
+	if (n == 0 || i + n > str.size())
+		return 0;
+	for (size_t k=1; k!=n; k++)
+		if (((unsigned char) str[i+k] & 0xC0) != 0x80)
+			return 0;
+	return n;
+}
+
+
+/// Write str (UTF-8) as a JSON string literal. Bytes that are not valid UTF-8 are written as \u00XX,
+/// so the output is valid JSON even for malformed input lines.
+void write_json_string( const std::string& str, std::ostream& os)
+{
+	static const char hex[] = "0123456789abcdef";
+	os << '"';
+	for (size_t i=0; i!=str.size(); i++) {
+		unsigned char c = (unsigned char) str[i];
+		switch (c) {
+		case '"':	os << "\\\""; break;
+		case '\\':	os << "\\\\"; break;
+		case '\n':	os << "\\n"; break;
+		case '\r':	os << "\\r"; break;
+		case '\t':	os << "\\t"; break;
+		default:
+			if (c < 0x20)
+				os << "\\u00" << hex[c >> 4] << hex[c & 15];
+			else if (c < 0x80)
+				os << char( c);
+			else {
+				size_t n = utf8_length( str, i);
+				if (n == 0)
+					os << "\\u00" << hex[c >> 4] << hex[c & 15];
+				else {
+					os.write( str.data() + i, std::streamsize( n));
+					i += n - 1;
+				}
+			}
+		}
+	}
+	os << '"';
+}
+
+
+/// Runs a block of batch mode commands on the thread pool, keeping the outputs in input order
+struct BatchJob : public LibWNXML::ThreadPool::Job
+{
+	const LibWNXML::WNQuery&		wn;
+	ML_NPro2::SemFeatures*			sf;
+	const std::vector<std::string>&	queries;
+	std::vector<std::string>		outputs;	///< command output, or error message
+	std::vector<char>				failed;		///< (not vector<bool>: elements are set from several threads)
+
+	BatchJob( const LibWNXML::WNQuery& w, ML_NPro2::SemFeatures* s, const std::vector<std::string>& q)
+		: wn( w), sf( s), queries( q), outputs( q.size()), failed( q.size(), 0)
+	{}
+
+	void run( size_t i)
+	{
+		std::ostringstream os;
+		try {
+			process_query( wn, sf, queries[i], os);
+			outputs[i] = os.str();
+		}
+		catch (const LibWNXML::InvalidPOSException& e) {
+			// (the message may contain parts of the command, in WordNet encoding)
+			Session::current().write( e.msg(), os);
+			outputs[i] = os.str();
+			failed[i] = 1;
+		}
+		catch (const std::exception& e) {
+			outputs[i] = e.what();
+			failed[i] = 1;
+		}
+	}
+};
+
+
+/// Run commands read from in (one per line, up to .q or the end), write the outputs to out in input order.
+/// The commands are read and run in blocks, the commands of a block in parallel.
+/// @param json write a JSON object per command ({"query": ..., "ok": true, "output": ...} or
+///  {"query": ..., "ok": false, "error": ...}) instead of the plain output (errors are written to stderr then);
+///  the terminal encoding of the session must be UTF-8 then (see main())
+void run_batch( const LibWNXML::WNQuery& wn, ML_NPro2::SemFeatures* sf, std::istream& in, std::ostream& out, unsigned nthreads, bool json)
+{
+	const size_t BlockSize = 4096;
+	LibWNXML::ThreadPool pool( nthreads);
+	std::vector<std::string> queries;
+	std::string line;
+	bool quit = false;
+	while (!quit) {
+		// read block
+		queries.clear();
+		while (queries.size() != BlockSize) {
+			if (!std::getline( in, line)) {
+				quit = true;
+				break;
+			}
+			if (!line.empty() && line[line.size()-1] == '\r')
+				line.erase( line.size()-1);
+			if (line == ".q") {
+				quit = true;
+				break;
+			}
+			if (line.find_first_not_of( " \t") != std::string::npos)
+				queries.push_back( line);
+		}
+
+		// run and write
+		BatchJob job( wn, sf, queries);
+		pool.run( job, queries.size());
+		for (size_t i=0; i!=queries.size(); i++) {
+			if (json) {
+				out << "{\"query\": ";
+				write_json_string( queries[i], out);
+				out << (job.failed[i] ? ", \"ok\": false, \"error\": " : ", \"ok\": true, \"output\": ");
+				write_json_string( job.outputs[i], out);
+				out << "}\n";
+			}
+			else if (job.failed[i])
+				std::cerr << job.outputs[i] << "\n";
+			else
+				out << job.outputs[i];
+		}
+	}
+	out.flush();
+}
+
+
+/// Run a command for a daemon client: like process_query(), but .ws is refused (clients must not write files
+/// with the rights of the daemon), and errors of the library are reported to the client as DaemonException
+void daemon_query( const LibWNXML::WNQuery& wn, ML_NPro2::SemFeatures* sf, const std::string& query, std::ostream& os)
+{
+	std::vector<std::string> t;
+	split( query, " ", t);
+	if (!t.empty() && t[0] == ".ws") {
+		ML_THROW_EXC( "Command .ws is not available in daemon mode", DaemonException);
+	}
+	try {
+		process_query( wn, sf, query, os);
+	}
+	catch (const LibWNXML::InvalidPOSException& e) {
+		ML_THROW_EXC( e.msg(), DaemonException);
+	}
+	catch (const LibWNXML::WNQueryException& e) {
+		ML_THROW_EXC( e.msg(), DaemonException);
+	}
+}
+
+
+int main( int argc, char *argv[])
+{
+	try {
+		
+		// check command line
+		std::string daemonaddr, batchfile, termenc;
+		unsigned nthreads = 0;
+		bool json = false;
+		std::vector<std::string> files;
+		for (int i=1; i<argc; i++) {
+			std::string arg = argv[i];
+			if (arg == "--daemon" && i+1 < argc)
+				daemonaddr = argv[++i];
+			else if (arg == "--batch" && i+1 < argc)
+				batchfile = argv[++i];
+			else if (arg == "--encoding" && i+1 < argc)
+				termenc = argv[++i];
+			else if (arg == "--json")
+				json = true;
+			else if (arg == "-j" && i+1 < argc)
+				nthreads = unsigned( atoi( argv[++i]));
+			else
+				files.push_back( arg);
+		}
+		if ((files.size() != 1 && files.size() != 2) || (!daemonaddr.empty() && !batchfile.empty())) {
+			std::cerr << "Usage:\n  WNXMLConsole [--daemon <socket_path>|<port> | --batch <command_file>|- [--json]] [-j <threads>] [--encoding <terminal_encoding>] <WN_XML_file>|<WN_snapshot_file> [<semantic_features_XML_file>]\n";
+			std::cerr << "  --daemon  serve queries to clients connecting on a Unix domain socket, or on a TCP port of localhost\n";
+			std::cerr << "  --batch   run the commands of a file (- for standard input), write their output in order\n";
+			std::cerr << "  --json    in batch mode, write a JSON object per command: {\"query\": ..., \"ok\": true, \"output\": ...} or {\"query\": ..., \"ok\": false, \"error\": ...}\n";
+			std::cerr << "            (commands and output are UTF-8 then, --encoding is ignored)\n";
+			std::cerr << "  -j        number of threads running queries in daemon or batch mode (default: number of processors)\n";
+			std::cerr << "  --encoding  character encoding of commands and output, e.g. UTF-8 (default: MSDOS-852)\n";
+			return 1;
+		}
+
+		ML::CharEncoding::Enc termcode = termenc.empty() ? ML::CharEncoding::MSDOS_852 : Session::encoding( termenc);
+		if (json) // JSON text is UTF-8
+			termcode = ML::CharEncoding::UTF_8;
+
+		// init WN
+		std::auto_ptr<ML::MultiLog> logger( ML::MultiLog::create( std::cerr, 100));
+		std::auto_ptr<LibWNXML::WNQuery> wn;
+		if (LibWNXML::WNQuery::isSnapshot( files[0])) {
+			std::cerr << "Reading snapshot...\n";
+			wn = LibWNXML::WNQuery::createFromSnapshot( files[0], *logger);
+		}
+		else {
+			// a UTF-8 terminal gets the data in UTF-8, so nothing is converted
+			std::cerr << "Reading XML...\n";
+			std::string wnenc = termcode == ML::CharEncoding::UTF_8 ? "UTF-8" : "ISO-8859-2";
+			wn = std::auto_ptr<LibWNXML::WNQuery>( new LibWNXML::WNQuery( files[0], *logger, 1, wnenc));
+		}
+		wn->writeStats( std::cerr);
+		Session::setEncodings( Session::encoding( wn->encoding()), termcode);
+
+		// init SemFeatures (if appl.)
+		std::auto_ptr<ML_NPro2::SemFeatures> sf( NULL);
+		if (files.size() == 2) {
+			std::cerr << "Reading SemFeatures...\n";
+			sf = std::auto_ptr<ML_NPro2::SemFeatures>( new ML_NPro2::SemFeatures( *wn));
+			std::cerr << sf->readXML( files[1]) << " pairs read\n";
+		}
+
+		// daemon mode: serve queries until killed
+		if (!daemonaddr.empty()) {
+			using namespace std::placeholders;
+			Daemon daemon( std::bind( daemon_query, std::cref( *wn), sf.get(), _1, _2), nthreads);
+			std::cerr << "Listening on " << daemonaddr << "\n";
+			daemon.run( daemonaddr);
+			return 1;
+		}
+
+		// batch mode
+		if (!batchfile.empty()) {
+			std::ios::sync_with_stdio( false);
+			if (batchfile == "-")
+				run_batch( *wn, sf.get(), std::cin, std::cout, nthreads, json);
+			else {
+				std::ifstream in( batchfile.c_str());
+				if (!in) {
+					std::cerr << "Could not open " << batchfile << "\n";
+					return 1;
+				}
+				run_batch( *wn, sf.get(), in, std::cout, nthreads, json);
+			}
+			return 0;
+		}
+
+		// query loop
+		std::cerr << "Type your query, or .h for help, .q to quit\n";
+		std::string line;
+		while (true) {	
+			
+			std::cerr << ">";
+			if (!std::getline( std::cin, line) || line == ".q")
+				break;
+			else if (line.compare( 0, 7, ".patch ") == 0) {
+				// (not in process_query(): it changes the WordNet, so it can't run in parallel with queries in batch or daemon mode)
+				try {
+					LibWNXML::WNQuery::PatchCounts c = wn->applyPatch( line.substr( 7));
+					std::cout << "Patch applied: " << c.added << " synsets added, " << c.modified << " modified, " << c.deleted << " deleted\n\n";
+				}
+				catch (const LibWNXML::WNQueryException& e) {
+					std::cerr << e.msg() << "\n";
+				}
+				catch (const LibWNXML::WNXMLParserException& e) {
+					std::cerr << e.msg() << "\n";
+				}
+			}
+			else if (line != "") {
+				try {
+					process_query( *wn, sf.get(), line, std::cout);
+				}
+				catch (const LibWNXML::InvalidPOSException& e) {
+					std::cerr << e.msg() << "\n";
+				}
+			}
+
+		} // while (true)
+
+	} // try {
+	catch (const std::exception& e) {
+		std::cerr << e.what() << "\n";
+		return 1;
+	}
+	catch (...) {
+		std::cerr << "Unknown exception\n";
+		return 1;
+	}
+	
+	return 0;
+}
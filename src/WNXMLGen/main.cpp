@@ -0,0 +1,103 @@
+/*
+
+Writes a synthetic WordNet in WNXML format, for testing and benchmarking (see LibWNXML/WNXMLGenerator.h).
+
+*/
+
+
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+
+#include "../LibWNXML/WNXMLGenerator.h"
+
+
+int main( int argc, char *argv[])
+{
+	try {
+		// check command line
+		LibWNXML::WNXMLGenerator::Params params;
+		std::string outfile;
+		bool ok = true;
+		for (int i=1; i<argc && ok; i++) {
+			std::string arg = argv[i];
+			if (i+1 == argc) {
+				ok = false;
+				break;
+			}
+			const char* val = argv[++i];
+			if (arg == "-o")
+				outfile = val;
+			else if (arg == "--nouns")
+				params.synsets[0] = size_t( atol( val));
+			else if (arg == "--verbs")
+				params.synsets[1] = size_t( atol( val));
+			else if (arg == "--adjectives")
+				params.synsets[2] = size_t( atol( val));
+			else if (arg == "--adverbs")
+				params.synsets[3] = size_t( atol( val));
+			else if (arg == "--depth")
+				params.maxDepth = unsigned( atoi( val));
+			else if (arg == "--fanout")
+				params.fanout = atof( val);
+			else if (arg == "--multi-parent")
+				params.multiParent = atof( val);
+			else if (arg == "--symmetric")
+				params.symmetric = atof( val);
+			else if (arg == "--synonyms")
+				params.synonyms = atof( val);
+			else if (arg == "--senses-exponent")
+				params.sensesExponent = atof( val);
+			else if (arg == "--max-senses")
+				params.maxSenses = unsigned( atoi( val));
+			else if (arg == "--gloss-words")
+				params.glossWords = atof( val);
+			else if (arg == "--seed")
+				params.seed = strtoull( val, NULL, 10);
+			else if (arg == "--id-prefix")
+				params.idPrefix = val;
+			else
+				ok = false;
+		}
+		if (!ok) {
+			LibWNXML::WNXMLGenerator::Params defaults;
+			std::cerr << "Usage:\n  WNXMLGen [options] [-o <output_file>]\n";
+			std::cerr << "Writes a synthetic WordNet in WNXML format to the output file, or to stdout. Options (with defaults):\n";
+			std::cerr << "  --nouns <n>           number of noun synsets (" << defaults.synsets[0] << ")\n";
+			std::cerr << "  --verbs <n>           number of verb synsets (" << defaults.synsets[1] << ")\n";
+			std::cerr << "  --adjectives <n>      number of adjective synsets (" << defaults.synsets[2] << ")\n";
+			std::cerr << "  --adverbs <n>         number of adverb synsets (" << defaults.synsets[3] << ")\n";
+			std::cerr << "  --depth <n>           number of hypernym levels below the top synsets (" << defaults.maxDepth << ")\n";
+			std::cerr << "  --fanout <x>          mean number of hyponyms of a synset (" << defaults.fanout << ")\n";
+			std::cerr << "  --multi-parent <x>    fraction of synsets with a second hypernym (" << defaults.multiParent << ")\n";
+			std::cerr << "  --symmetric <x>       fraction of synsets with a near_antonym (similar_to for adjectives) relation (" << defaults.symmetric << ")\n";
+			std::cerr << "  --synonyms <x>        mean number of literals of a synset (" << defaults.synonyms << ")\n";
+			std::cerr << "  --senses-exponent <x> literals have k senses with probability ~ k^-x, 0 for uniform (" << defaults.sensesExponent << ")\n";
+			std::cerr << "  --max-senses <n>      maximum number of senses of a literal (" << defaults.maxSenses << ")\n";
+			std::cerr << "  --gloss-words <x>     mean number of words of definitions, 0 for none (" << defaults.glossWords << ")\n";
+			std::cerr << "  --seed <n>            random seed, the same seed and options give the same output (" << defaults.seed << ")\n";
+			std::cerr << "  --id-prefix <s>       synset ids are <s>-<number>-<pos> (" << defaults.idPrefix << ")\n";
+			return 1;
+		}
+
+		LibWNXML::WNXMLGenerator gen( params);
+		if (outfile.empty()) {
+			std::ios::sync_with_stdio( false);
+			gen.write( std::cout);
+			std::cout.flush();
+		}
+		else
+			gen.write( outfile);
+
+	} // try {
+	catch (const std::exception& e) {
+		std::cerr << e.what() << "\n";
+		return 1;
+	}
+	catch (...) {
+		std::cerr << "Unknown exception\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,1161 @@
+/*
+
+Tests of LibWNXML, run on a generated WordNet (see WNXMLGenerator) or on a WordNet XML file.
+
+Differential tests compare the library with simple reference implementations:
+- the parser (block-buffered and line by line) with the first version of it, which routed the elements
+  by comparing their names, on the synsets of the input with all the fields and some stray elements added;
+- similarities (single, matrices) and traces with the first version of WNQuery, which followed every relation path
+  on the synset maps;
+- a snapshot with the WordNet it was saved from, and loading with several threads with loading with one;
+- the literal trie and the folded index (completion, fuzzy and folded lookups) with linear scans of the literals,
+  also after a small patch that updates them in place, and after a large one that has them built again.
+
+Queries are run by one thread, then by several threads at the same time on a freshly loaded object
+(the const member functions are documented to be safe for concurrent readers, and the indices built
+at first use are built while the other threads are querying too). The results must be the same.
+
+A patch (WNQuery::applyPatch()) changing, deleting and adding synsets of the WordNet must give
+the same snapshot and the same query results as loading the file with the patch applied.
+A job running on a ThreadPool must be able to run the pool again.
+Exits with 0 if all tests passed.
+
+*/
+
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../CharConverter/CharConverter.h"
+#include "../CharConverter/EncodingNames.h"
+#include "../MLUtils/MultiLog.h"
+
+#include "../LibWNXML/FoldedIndex.h"
+#include "../LibWNXML/ThreadPool.h"
+#include "../LibWNXML/WNQuery.h"
+#include "../LibWNXML/WNXMLGenerator.h"
+#include "../LibWNXML/WNXMLParser.h"
+
+
+namespace {
+
+using LibWNXML::WNQuery;
+
+/// A query: a synset and one of its literals, and another synset of the same POS
+struct Sample
+{
+	std::string	id;
+	std::string	pos;
+	std::string	literal;
+	std::string	other;
+	std::string	otherliteral;
+};
+
+
+/// Take samples from the synsets of all POS (every step-th synset)
+void sample_queries( const WNQuery& wn, size_t n, std::vector<Sample>& smp)
+{
+	const char* const posnames[4] = { "n", "v", "a", "b" };
+	std::vector< std::pair<std::string, const LibWNXML::Synset*> > all;
+	for (int p=0; p!=4; p++) {
+		const WNQuery::tdat& d = wn.dat( posnames[p]);
+		for (WNQuery::tdat::const_iterator it=d.begin(); it!=d.end(); it++)
+			if (!it->second.synonyms.empty())
+				all.push_back( std::make_pair( std::string( posnames[p]), &it->second));
+	}
+	if (all.empty())
+		return;
+	size_t step = all.size() / n + 1;
+	for (size_t i=0; i<all.size(); i+=step) {
+		const LibWNXML::Synset& s = *all[i].second;
+		// another synset of the same POS, further on
+		size_t j = (i + all.size() / 3) % all.size();
+		while (all[j].first != all[i].first)
+			j = (j + 1) % all.size();
+		Sample q;
+		q.id = s.id;
+		q.pos = all[i].first;
+		q.literal = s.synonyms[0].literal;
+		q.other = all[j].second->id;
+		q.otherliteral = all[j].second->synonyms[0].literal;
+		smp.push_back( q);
+	}
+}
+
+
+/// Run the queries of samples [first, first + n) (wrapping around), write the results to os
+void run_queries( const WNQuery& wn, const std::vector<Sample>& smp, size_t first, size_t n,
+				  LibWNXML::ThreadPool& pool, std::ostream& os)
+{
+	const std::string rel = "hypernym";
+	for (size_t k=0; k!=n; k++) {
+		const Sample& q = smp[(first + k) % smp.size()];
+		os << q.id << ":";
+
+		std::vector<std::string> ids;
+		wn.lookUpLiteral( q.literal, q.pos, ids);
+		os << " lit";
+		for (size_t i=0; i!=ids.size(); i++)
+			os << " " << ids[i];
+
+		wn.traceRelation( q.id, q.pos, rel, ids);
+		os << " trace " << ids.size();
+		std::ostringstream tree;
+		wn.traceRelationOS( q.id, q.pos, "hyponym", tree, 3);
+		os << " tree " << tree.str().size();
+
+		std::set<std::string> targets;
+		targets.insert( q.other);
+		std::string found, foundid;
+		os << " conn " << wn.isIDConnectedWith( q.id, q.pos, rel, targets, found) << found;
+		os << " litconn " << wn.isLiteralConnectedWith( q.literal, q.pos, rel, targets, foundid, found) << foundid << found;
+		os << " compat " << wn.isLiteralCompatibleWithSynset( q.literal, q.pos, q.other, true);
+
+		WNQuery::tSims sims;
+		wn.similarityLeacockChodorow( q.literal, q.otherliteral, q.pos, rel, true, sims);
+		os << " sim";
+		for (WNQuery::tSims::const_iterator it=sims.begin(); it!=sims.end(); it++)
+			os << " " << it->first << "/" << it->second.first << "/" << it->second.second;
+
+		WNQuery::tNeighbors nb;
+		wn.nearestNeighbors( q.id, q.pos, rel, 5, true, nb);
+		os << " nn";
+		for (size_t i=0; i!=nb.size(); i++)
+			os << " " << nb[i].first << "/" << nb[i].second;
+
+		WNQuery::tCompletions c;
+		wn.completeLiteral( q.literal.substr( 0, 2), q.pos, 5, c);
+		os << " compl";
+		for (size_t i=0; i!=c.size(); i++)
+			os << " " << c[i].first << "/" << c[i].second;
+
+		WNQuery::tFuzzyMatches fm;
+		wn.fuzzyLookUpLiteral( q.literal + "x", q.pos, 1, 5, fm);
+		os << " fuzzy";
+		for (size_t i=0; i!=fm.size(); i++)
+			os << " " << fm[i].first << "/" << fm[i].second;
+
+		std::vector<LibWNXML::Synset> folded;
+		wn.lookUpLiteralFolded( q.literal, q.pos, folded);
+		os << " folded " << folded.size() << "\n";
+	}
+
+	// a similarity matrix of the literals of the samples, on the shared pool
+	std::vector<std::string> literals;
+	for (size_t k=0; k!=n && k!=20; k++)
+		if (smp[(first + k) % smp.size()].pos == "n")
+			literals.push_back( smp[(first + k) % smp.size()].literal);
+	WNQuery::tSimMatrix m;
+	wn.similarityMatrix( literals, literals, "n", rel, true, m, &pool);
+	for (size_t i=0; i!=m.size(); i++)
+		for (size_t j=0; j!=m[i].size(); j++)
+			os << m[i][j] << (j + 1 == m[i].size() ? "\n" : " ");
+}
+
+
+/// Check that concurrent queries give the same results as serial ones
+bool test_concurrent_queries( const std::string& input, unsigned nthreads, size_t nqueries)
+{
+	std::auto_ptr<ML::MultiLog> logger( ML::MultiLog::create( std::cerr, 100));
+	LibWNXML::ThreadPool pool( nthreads);
+	std::vector<Sample> smp;
+	std::vector<std::string> expected( nthreads);
+	{
+		WNQuery wn( input, *logger);
+		sample_queries( wn, nqueries, smp);
+		if (smp.empty()) {
+			std::cerr << "No synsets in input\n";
+			return false;
+		}
+		for (unsigned t=0; t!=nthreads; t++) {
+			std::ostringstream os;
+			run_queries( wn, smp, t * smp.size() / nthreads, smp.size(), pool, os);
+			expected[t] = os.str();
+		}
+	}
+
+	// the threads start at different samples, so they build the lazy indices at different times
+	WNQuery wn( input, *logger);
+	std::vector<std::string> results( nthreads);
+	std::vector<std::thread> threads;
+	for (unsigned t=0; t!=nthreads; t++)
+		threads.push_back( std::thread( [&, t]() {
+			std::ostringstream os;
+			run_queries( wn, smp, t * smp.size() / nthreads, smp.size(), pool, os);
+			results[t] = os.str();
+		}));
+	for (size_t t=0; t!=threads.size(); t++)
+		threads[t].join();
+
+	bool ok = true;
+	for (unsigned t=0; t!=nthreads; t++)
+		if (results[t] != expected[t]) {
+			std::cerr << "  thread " << t << ": results differ from the serial run\n";
+			ok = false;
+		}
+	return ok;
+}
+
+
+/// Read the synsets of a WordNet XML file, in file order
+/// @param blocksize input block size of the parser (see WNXMLParser::setBlockSize()), 0 to read line by line
+void read_synsets( const std::string& filename, const std::string& encoding, std::vector<LibWNXML::Synset>& synsets,
+				   size_t blocksize = 0)
+{
+	std::ifstream inf( filename.c_str());
+	LibWNXML::WNXMLParser psr( encoding);
+	psr.setBlockSize( blocksize);
+	LibWNXML::Synset syns;
+	int lcnt = 0;
+	while (!inf.eof() || psr.hasBuffered()) {
+		psr.parseXMLSynset( inf, syns, lcnt);
+		if (!syns.empty())
+			synsets.push_back( syns);
+	}
+	psr.finishParsing();
+	while (psr.hasBuffered()) {
+		psr.parseXMLSynset( inf, syns, lcnt);
+		synsets.push_back( syns);
+	}
+}
+
+
+/// The parser of the first version of WNXMLParser, as the reference of its dispatch tables: the input is passed
+/// to the SAX parser line by line, and elements and character data are routed to the synset fields by comparing
+/// the names of the elements on the path (the WNXML root may not be missing, and a line may not go on after </SYNSET>)
+class BaselineParser : public xmlpp::SaxParser
+{
+public:
+	BaselineParser( const std::string& encoding)
+		: m_synsets( NULL), m_syns( NULL)
+	{
+		ML::CharEncoding outenc;
+		outenc.ext = ML::CharEncoding::XT_CHREF_NORM;
+		outenc.enc = ML::EncodingNames::getEncoding( encoding.c_str());
+		ML::CharEncoding inenc;
+		inenc.ext = ML::CharEncoding::XT_NONE;
+		inenc.enc = ML::CharEncoding::UTF_8;
+		m_cconv = ML::CharConverter::create( inenc, outenc);
+	}
+
+	/// Parse a WordNet XML file, append its synsets to synsets
+	void parse( const std::string& filename, std::vector<LibWNXML::Synset>& synsets)
+	{
+		std::ifstream inf( filename.c_str());
+		m_synsets = &synsets;
+		std::string line;
+		while (std::getline( inf, line))
+			parse_chunk( line);
+		finish_chunk_parsing();
+	}
+
+protected:
+	virtual void on_start_element( const std::string& name, const AttributeList&)
+	{
+		m_path.push_back( name);
+		const std::string& parent = up( 1);
+		if (name == "SYNSET") {
+			m_synsets->push_back( LibWNXML::Synset());
+			m_syns = &m_synsets->back();
+		}
+		else if (m_syns == NULL)
+			return;
+		else if (name == "LITERAL" && parent == "SYNONYM" && up( 2) == "SYNSET")
+			m_syns->synonyms.push_back( LibWNXML::Synset::Synonym( "", "", ""));
+		else if (parent != "SYNSET")
+			return;
+		else if (name == "ILR")
+			m_syns->ilrs.push_back( std::make_pair( "", ""));
+		else if (name == "USAGE")
+			m_syns->usages.push_back( "");
+		else if (name == "SNOTE")
+			m_syns->snotes.push_back( "");
+		else if (name == "SUMO")
+			m_syns->sumolinks.push_back( std::make_pair( "", ""));
+		else if (name == "EQ_NEAR_SYNONYM")
+			m_syns->elrs.push_back( std::make_pair( "", "eq_near_synonym"));
+		else if (name == "EQ_HYPERNYM")
+			m_syns->elrs.push_back( std::make_pair( "", "eq_has_hypernym"));
+		else if (name == "EQ_HYPONYM")
+			m_syns->elrs.push_back( std::make_pair( "", "eq_has_hyponym"));
+		else if (name == "ELR")
+			m_syns->elrs.push_back( std::make_pair( "", ""));
+		else if (name == "EKSZ")
+			m_syns->ekszlinks.push_back( std::make_pair( "", ""));
+		else if (name == "VFRAME")
+			m_syns->vframelinks.push_back( std::make_pair( "", ""));
+	}
+
+	virtual void on_end_element( const std::string& name)
+	{
+		m_path.pop_back();
+		if (name == "SYNSET")
+			m_syns = NULL;
+	}
+
+	virtual void on_characters( const std::string& text)
+	{
+		if (m_syns == NULL)
+			return;
+		std::string conv;
+		m_cconv->convert( text, conv);
+		field( up( 0), up( 1), up( 2)) += conv;
+	}
+
+	virtual void on_error( const std::string& text)
+		{ ML_THROW_EXC( "XML parser error: " << text, LibWNXML::WNXMLParserException); }
+	virtual void on_fatal_error( const std::string& text)
+		{ ML_THROW_EXC( "XML parser fatal error: " << text, LibWNXML::WNXMLParserException); }
+
+private:
+	// name of the nth element up the path from the current one (0: current), "" if there's none
+	const std::string& up( size_t n) const
+	{
+		static const std::string none;
+		return n < m_path.size() ? m_path[m_path.size() - 1 - n] : none;
+	}
+
+	// last item of a synset field (the XML is invalid if there's none)
+	template <class T> T& last( std::vector<T>& v)
+	{
+		if (v.empty()) {
+			ML_THROW_EXC( "BaselineParser: no item for character data of " << up( 0), LibWNXML::WNXMLParserException);
+		}
+		return v.back();
+	}
+
+	// synset field of character data in element, under parent and gparent (m_ignored if none)
+	std::string& field( const std::string& element, const std::string& parent, const std::string& gparent)
+	{
+		LibWNXML::Synset& s = *m_syns;
+		if (parent == "SYNSET") {
+			if (element == "ID")	return s.id;
+			if (element == "POS")	return s.pos;
+			if (element == "ILR")	return last( s.ilrs).first;
+			if (element == "DEF")	return s.def;
+			if (element == "BCS")	return s.bcs;
+			if (element == "USAGE")	return last( s.usages);
+			if (element == "SNOTE")	return last( s.snotes);
+			if (element == "STAMP")	return s.stamp;
+			if (element == "DOMAIN")	return s.domain;
+			if (element == "SUMO")	return last( s.sumolinks).first;
+			if (element == "NL")	return s.nl;
+			if (element == "TNL")	return s.tnl;
+			if (element == "EQ_NEAR_SYNONYM" || element == "EQ_HYPERNYM" || element == "EQ_HYPONYM" || element == "ELR")
+				return last( s.elrs).first;
+			if (element == "EKSZ")	return last( s.ekszlinks).first;
+			if (element == "VFRAME")	return last( s.vframelinks).first;
+		}
+		if (element == "LITERAL" && parent == "SYNONYM")
+			return last( s.synonyms).literal;
+		if (parent == "LITERAL" && gparent == "SYNONYM") {
+			if (element == "SENSE")	return last( s.synonyms).sense;
+			if (element == "LNOTE")	return last( s.synonyms).lnote;
+			if (element == "NUCLEUS")	return last( s.synonyms).nucleus;
+		}
+		if (element == "TYPE") {
+			if (parent == "ILR")	return last( s.ilrs).second;
+			if (parent == "SUMO")	return last( s.sumolinks).second;
+			if (parent == "ELR")	return last( s.elrs).second;
+			if (parent == "EKSZ")	return last( s.ekszlinks).second;
+			if (parent == "VFRAME")	return last( s.vframelinks).second;
+		}
+		m_ignored.clear();
+		return m_ignored;
+	}
+
+	std::vector<LibWNXML::Synset>*		m_synsets;	// output
+	LibWNXML::Synset*					m_syns;		// synset being parsed (NULL outside SYNSET)
+	std::vector<std::string>			m_path;		// names of the elements from the root to the current one
+	std::auto_ptr<ML::CharConverter>	m_cconv;	// from UTF-8 to the output encoding
+	std::string							m_ignored;	// character data of elements with no field
+};
+
+
+/// Write the synsets of a WordNet to a file for the parser tests: with all the fields a synset can have
+/// (and the elements writeXML() doesn't write), character data split by entities, elements on separate lines,
+/// and elements in places where they don't belong (which are ignored)
+void write_parser_input( const std::string& filename, const std::string& encoding, const std::vector<LibWNXML::Synset>& synsets)
+{
+	std::ofstream outf( filename.c_str());
+	outf << "<?xml version=\"1.0\" encoding=\"" << encoding << "\"?>\n<WNXML>\n";
+	for (size_t i=0; i!=synsets.size(); i++) {
+		LibWNXML::Synset s = synsets[i];
+		std::ostringstream num;
+		num << i;
+		if (i % 3 == 0) {
+			for (size_t j=0; j!=s.synonyms.size(); j++) {
+				s.synonyms[j].lnote = "lnote " + num.str();
+				s.synonyms[j].nucleus = "yes";
+			}
+			s.def += " & <" + num.str() + ">";
+			s.bcs = "2";
+			s.usages.push_back( "usage '" + num.str() + "'");
+			s.usages.push_back( "");
+			s.snotes.push_back( "snote \"" + num.str() + "\"");
+			s.stamp = "stamp " + num.str();
+			s.domain = "factotum";
+			s.sumolinks.push_back( std::make_pair( std::string( "Entity"), std::string( "+")));
+			s.nl = "yes";
+			s.tnl = "no";
+			s.elrs.push_back( std::make_pair( "ENG20-" + num.str() + "-" + s.pos, std::string( "eq_synonym")));
+			s.ekszlinks.push_back( std::make_pair( num.str(), std::string( "eksz")));
+			s.vframelinks.push_back( std::make_pair( num.str(), std::string( "vframe")));
+		}
+		std::ostringstream xml;
+		s.writeXML( xml);
+		std::string text = xml.str();
+		const std::string end = "</SYNSET>";
+		if (i % 5 == 1)
+			text.insert( text.size() - end.size(), "<EQ_NEAR_SYNONYM>ENG20-" + num.str() + "-n</EQ_NEAR_SYNONYM>"
+						 "<EQ_HYPERNYM>ENG20-1-n</EQ_HYPERNYM><EQ_HYPONYM>ENG20-2-n</EQ_HYPONYM>");
+		if (i % 5 == 2) { // stray elements, text after a child element
+			text.insert( text.size() - end.size(), "<TYPE>stray</TYPE><UNKNOWN>stray<ID>stray</ID></UNKNOWN>"
+						 "<ILR>ILR-" + num.str() + "<USAGE>stray</USAGE><TYPE>hypernym</TYPE>-tail</ILR><SYNONYM><DEF>stray</DEF><SENSE>9</SENSE></SYNONYM><LITERAL>stray</LITERAL>");
+			size_t pos = text.find( "</SENSE>");
+			if (pos != std::string::npos)
+				text.insert( pos + 8, "-tail<USAGE>stray</USAGE>");
+		}
+		if (i % 4 == 3) { // elements on separate lines (where the line ends are not in character data of a field)
+			const char* const tags[6] = { "<SYNONYM>", "</ID>", "</POS>", "</LITERAL>", "</SYNONYM>", "</ILR>" };
+			for (int t=0; t!=6; t++) {
+				const std::string tag = tags[t];
+				for (size_t pos = text.find( tag); pos != std::string::npos; pos = text.find( tag, pos + tag.size()))
+					text.insert( pos + tag.size(), "\n");
+			}
+		}
+		outf << text << "\n";
+	}
+	outf << "</WNXML>\n";
+}
+
+
+/// XML of a synset (for comparing synsets)
+std::string synset_xml( LibWNXML::Synset s)
+{
+	std::ostringstream os;
+	s.writeXML( os);
+	return os.str();
+}
+
+
+/// Check that the parser gives the same synsets as the first version of it (BaselineParser), line by line and block-buffered
+/// (in the encoding WNQuery reads in by default)
+bool test_parser( const std::string& input)
+{
+	const std::string encoding = "ISO-8859-2";
+	std::vector<LibWNXML::Synset> synsets;
+	read_synsets( input, encoding, synsets);
+	const std::string filename = "WNXMLTest_parser.xml";
+	write_parser_input( filename, encoding, synsets);
+
+	std::vector<LibWNXML::Synset> expected;
+	BaselineParser( encoding).parse( filename, expected);
+	bool ok = true;
+	const size_t blocksizes[3] = { 0, 1000, LibWNXML::WNXMLParser::DefaultBlockSize };
+	for (int b=0; b!=3; b++) {
+		std::vector<LibWNXML::Synset> result;
+		read_synsets( filename, encoding, result, blocksizes[b]);
+		size_t i = 0;
+		while (i != result.size() && i != expected.size() && synset_xml( result[i]) == synset_xml( expected[i]))
+			i++;
+		if (i != result.size() || i != expected.size()) {
+			std::cerr << "  block size " << blocksizes[b] << ": synset #" << i << " differs from the first parser's\n";
+			ok = false;
+		}
+	}
+	remove( filename.c_str());
+	return ok;
+}
+
+
+/// Write synsets to a WordNet XML file
+void write_synsets( const std::string& filename, const std::string& encoding, std::vector<LibWNXML::Synset>& synsets)
+{
+	std::ofstream outf( filename.c_str());
+	outf << "<?xml version=\"1.0\" encoding=\"" << encoding << "\"?>\n<WNXML>\n";
+	for (size_t i=0; i!=synsets.size(); i++) {
+		synsets[i].writeXML( outf);
+		outf << "\n";
+	}
+	outf << "</WNXML>\n";
+}
+
+
+/// Make a patch of synsets (in file order) that modifies, deletes and adds some, and the synsets with the patch
+/// applied: the modified ones where they were, the deleted ones left out, the added ones at the end
+void make_patch( const std::vector<LibWNXML::Synset>& synsets, std::vector<LibWNXML::Synset>& patch,
+				 std::vector<LibWNXML::Synset>& patched)
+{
+	using LibWNXML::Synset;
+	for (size_t i=0; i!=synsets.size(); i++) {
+		const Synset& s = synsets[i];
+		std::ostringstream num;
+		num << i;
+		if (i % 23 == 5) { // deleted (other synsets may still point at it)
+			Synset d;
+			d.id = s.id;
+			d.pos = s.pos;
+			patch.push_back( d);
+			continue;
+		}
+		if (i % 17 == 3) { // a literal replaced by a new one, the hypernyms moved to the next synset of the POS,
+			// and a relation to a synset the patch adds
+			Synset m = s;
+			m.def = "patched";
+			if (!m.synonyms.empty())
+				m.synonyms.back() = Synset::Synonym( "patched" + num.str(), "1");
+			const Synset& next = synsets[(i + 1) % synsets.size()];
+			for (size_t j=0; j!=m.ilrs.size(); j++)
+				if (m.ilrs[j].second == "hypernym" && next.pos == s.pos && next.id != s.id)
+					m.ilrs[j].first = next.id;
+			if (i % 97 != 0)
+				m.ilrs.push_back( std::make_pair( "PATCH-" + num.str() + "-" + s.pos, std::string( "near_antonym")));
+			patch.push_back( m);
+			patched.push_back( m);
+			continue;
+		}
+		patched.push_back( s);
+	}
+	// added: with a new literal and one of an existing synset, the hyponym of that synset
+	// (also the synsets the modified ones point at)
+	for (size_t i=0; i!=synsets.size(); i++) {
+		if (i % 97 != 0 && i % 17 != 3)
+			continue;
+		const Synset& s = synsets[i];
+		std::ostringstream num;
+		num << i;
+		Synset a;
+		a.id = "PATCH-" + num.str() + "-" + s.pos;
+		a.pos = s.pos;
+		a.synonyms.push_back( Synset::Synonym( "added" + num.str(), "1"));
+		if (!s.synonyms.empty())
+			a.synonyms.push_back( Synset::Synonym( s.synonyms[0].literal, "9"));
+		a.ilrs.push_back( std::make_pair( s.id, std::string( "hypernym")));
+		a.def = "added";
+		patch.push_back( a);
+		patched.push_back( a);
+	}
+}
+
+
+/// Read a whole file
+std::string file_content( const std::string& filename)
+{
+	std::ifstream inf( filename.c_str(), std::ios::binary);
+	return std::string( std::istreambuf_iterator<char>( inf), std::istreambuf_iterator<char>());
+}
+
+
+/// Check that a patch gives the same WordNet as loading the file with the patch applied: the same snapshot
+/// (synsets with their relations in the same order, word senses, literal trie) and the same query results
+/// (through the indices the patch updates, built before it)
+bool test_patch( const std::string& input, unsigned nthreads, size_t nqueries)
+{
+	std::auto_ptr<ML::MultiLog> logger( ML::MultiLog::create( std::cerr, 100));
+	LibWNXML::ThreadPool pool( nthreads);
+	WNQuery wn( input, *logger);
+	std::vector<LibWNXML::Synset> synsets, patch, patched;
+	read_synsets( input, wn.encoding(), synsets);
+	make_patch( synsets, patch, patched);
+	const std::string patchedfile = "WNXMLTest_patched.xml";
+	write_synsets( patchedfile, wn.encoding(), patched);
+	WNQuery fresh( patchedfile, *logger);
+
+	std::vector<Sample> smp;
+	sample_queries( wn, nqueries, smp);
+	std::ostringstream before;
+	run_queries( wn, smp, 0, smp.size(), pool, before);
+	wn.applyPatch( patch);
+
+	bool ok = true;
+	smp.clear();
+	sample_queries( fresh, nqueries, smp);
+	std::ostringstream os1, os2;
+	run_queries( wn, smp, 0, smp.size(), pool, os1);
+	run_queries( fresh, smp, 0, smp.size(), pool, os2);
+	if (os1.str() != os2.str()) {
+		std::cerr << "  query results differ from loading the patched file\n";
+		ok = false;
+	}
+	wn.saveSnapshot( "WNXMLTest_patch.snap");
+	fresh.saveSnapshot( "WNXMLTest_patched.snap");
+	if (file_content( "WNXMLTest_patch.snap") != file_content( "WNXMLTest_patched.snap")) {
+		std::cerr << "  snapshot differs from the one of the patched file\n";
+		ok = false;
+	}
+	remove( patchedfile.c_str());
+	remove( "WNXMLTest_patch.snap");
+	remove( "WNXMLTest_patched.snap");
+	return ok;
+}
+
+
+/// Synsets reachable from synset id along relation rel with their distances (the synset itself at dist),
+/// as the first version of WNQuery (getReach()) collected them: every path is followed
+void baseline_reach( const WNQuery& wn, const std::string& id, const std::string& pos, const std::string& rel,
+					 std::vector< std::pair<std::string, int> >& res, int dist, bool addTop)
+{
+	const WNQuery::tdat& d = wn.dat( pos);
+	WNQuery::tdat::const_iterator it = d.find( id);
+	if (it == d.end())
+		return;
+	res.push_back( std::make_pair( id, dist));
+	bool haschildren = false;
+	for (size_t i=0; i!=it->second.ilrs.size(); i++)
+		if (it->second.ilrs[i].second == rel) {
+			haschildren = true;
+			baseline_reach( wn, it->second.ilrs[i].first, pos, rel, res, dist + 1, addTop);
+		}
+	if (!haschildren && addTop)
+		res.push_back( std::make_pair( std::string( "#TOP#"), dist + 1));
+}
+
+
+/// Leacock-Chodorow similarity of two synsets as the first version of WNQuery (simLeaCho()) computed it:
+/// from the common node of their reaches with the shortest connecting path
+double baseline_sim( const WNQuery& wn, const std::string& id1, const std::string& id2, const std::string& pos,
+					 const std::string& rel, bool addTop)
+{
+	std::vector< std::pair<std::string, int> > r1, r2;
+	baseline_reach( wn, id1, pos, rel, r1, 1, addTop);
+	baseline_reach( wn, id2, pos, rel, r2, 1, addTop);
+	int len = 2 * LibWNXML::LeaCho_D;
+	bool found = false;
+	for (size_t i=0; i!=r1.size(); i++)
+		for (size_t j=0; j!=r2.size(); j++)
+			if (r1[i].first == r2[j].first && r1[i].second + r2[j].second < len) {
+				len = r1[i].second + r2[j].second;
+				found = true;
+			}
+	if (!found)
+		return LibWNXML::LeaCho_noconnect;
+	return -1.0 * log10( double( len - 1) / (2.0 * double( LibWNXML::LeaCho_D)));
+}
+
+
+/// Similarities of the senses of two literals as the first version of WNQuery::similarityLeacockChodorow() computed them
+void baseline_sims( const WNQuery& wn, const std::string& literal1, const std::string& literal2, const std::string& pos,
+					const std::string& rel, bool addTop, WNQuery::tSims& results)
+{
+	results.clear();
+	std::vector<std::string> senses1, senses2;
+	wn.lookUpLiteral( literal1, pos, senses1);
+	wn.lookUpLiteral( literal2, pos, senses2);
+	for (size_t i=0; i!=senses1.size(); i++)
+		for (size_t j=0; j!=senses2.size(); j++)
+			results.insert( std::make_pair( baseline_sim( wn, senses1[i], senses2[j], pos, rel, addTop),
+											std::make_pair( senses1[i], senses2[j])));
+}
+
+
+/// Trace of relation rel from synset id as the first version of WNQuery::traceRelation() made it: the synsets that have
+/// relations of the type, depth-first, listed again on every path that reaches them
+void baseline_trace( const WNQuery& wn, const std::string& id, const std::string& pos, const std::string& rel,
+					 std::vector<std::string>& res)
+{
+	const WNQuery::tdat& d = wn.dat( pos);
+	WNQuery::tdat::const_iterator it = d.find( id);
+	if (it == d.end())
+		return;
+	std::vector<std::string> targets;
+	for (size_t i=0; i!=it->second.ilrs.size(); i++)
+		if (it->second.ilrs[i].second == rel)
+			targets.push_back( it->second.ilrs[i].first);
+	if (targets.empty())
+		return;
+	res.push_back( id);
+	for (size_t i=0; i!=targets.size(); i++)
+		baseline_trace( wn, targets[i], pos, rel, res);
+}
+
+
+/// Print a difference from the reference (the first few of them), count it
+void mismatch( size_t& count, const std::string& what)
+{
+	if (count++ < 5)
+		std::cerr << "  " << what << "\n";
+}
+
+
+/// Compare the similarities and traces of the samples with those of the first version of WNQuery
+/// (on "hypernym", which the generated WordNets have without cycles), return the number of differences
+size_t check_baseline_queries( const WNQuery& wn, const std::vector<Sample>& smp, LibWNXML::ThreadPool& pool)
+{
+	size_t count = 0;
+	std::map< std::string, std::vector<std::string> > literals; // for matrices, by POS
+	for (size_t k=0; k!=smp.size(); k++) {
+		const Sample& q = smp[k];
+		for (int top=0; top!=2; top++) {
+			WNQuery::tSims sims, expected;
+			wn.similarityLeacockChodorow( q.literal, q.otherliteral, q.pos, "hypernym", top != 0, sims);
+			baseline_sims( wn, q.literal, q.otherliteral, q.pos, "hypernym", top != 0, expected);
+			if (sims != expected)
+				mismatch( count, "similarity of " + q.literal + " and " + q.otherliteral);
+			wn.similarityLeacockChodorow( q.literal, q.literal, q.pos, "hypernym", top != 0, sims);
+			baseline_sims( wn, q.literal, q.literal, q.pos, "hypernym", top != 0, expected);
+			if (sims != expected)
+				mismatch( count, "similarity of " + q.literal + " to itself");
+		}
+
+		const char* const rels[2] = { "hypernym", "hyponym" };
+		for (int r=0; r!=2; r++) {
+			std::vector<std::string> trace, paths, expected;
+			wn.traceRelation( q.id, q.pos, rels[r], trace);
+			baseline_trace( wn, q.id, q.pos, rels[r], paths);
+			// the first version listed synsets again on every path, now they are listed at the first one
+			std::set<std::string> seen;
+			for (size_t i=0; i!=paths.size(); i++)
+				if (seen.insert( paths[i]).second)
+					expected.push_back( paths[i]);
+			if (trace != expected)
+				mismatch( count, std::string( "trace of ") + rels[r] + " from " + q.id);
+		}
+
+		if (literals[q.pos].size() < 20)
+			literals[q.pos].push_back( q.literal);
+	}
+
+	// the score of two words in a matrix is the best score of their senses
+	for (std::map< std::string, std::vector<std::string> >::const_iterator it=literals.begin(); it!=literals.end(); it++) {
+		WNQuery::tSimMatrix m;
+		wn.similarityMatrix( it->second, it->second, it->first, "hypernym", true, m, &pool);
+		for (size_t i=0; i!=it->second.size(); i++)
+			for (size_t j=0; j!=it->second.size(); j++) {
+				WNQuery::tSims expected;
+				baseline_sims( wn, it->second[i], it->second[j], it->first, "hypernym", true, expected);
+				double best = expected.empty() ? LibWNXML::LeaCho_notfound : expected.rbegin()->first;
+				if (m[i][j] != best)
+					mismatch( count, "similarity matrix of " + it->second[i] + " and " + it->second[j]);
+			}
+	}
+	return count;
+}
+
+
+/// Check that similarities and traces are the same as with the first version of WNQuery
+bool test_baseline_queries( const std::string& input, unsigned nthreads, size_t nqueries)
+{
+	std::auto_ptr<ML::MultiLog> logger( ML::MultiLog::create( std::cerr, 100));
+	LibWNXML::ThreadPool pool( nthreads);
+	WNQuery wn( input, *logger);
+	std::vector<Sample> smp;
+	sample_queries( wn, nqueries, smp);
+	return check_baseline_queries( wn, smp, pool) == 0;
+}
+
+
+/// Check that a snapshot gives back the same WordNet: saving the loaded snapshot gives the same file,
+/// and the query results are the same. Loading with several threads must give the same snapshot too.
+bool test_snapshot( const std::string& input, unsigned nthreads, size_t nqueries)
+{
+	std::auto_ptr<ML::MultiLog> logger( ML::MultiLog::create( std::cerr, 100));
+	LibWNXML::ThreadPool pool( nthreads);
+	WNQuery wn( input, *logger);
+	wn.saveSnapshot( "WNXMLTest.snap");
+	std::auto_ptr<WNQuery> loaded = WNQuery::createFromSnapshot( "WNXMLTest.snap", *logger);
+	loaded->saveSnapshot( "WNXMLTest_loaded.snap");
+	WNQuery parallel( input, *logger, nthreads);
+	parallel.saveSnapshot( "WNXMLTest_parallel.snap");
+
+	bool ok = true;
+	const std::string snapshot = file_content( "WNXMLTest.snap");
+	if (file_content( "WNXMLTest_loaded.snap") != snapshot) {
+		std::cerr << "  saving a loaded snapshot gives a different file\n";
+		ok = false;
+	}
+	if (file_content( "WNXMLTest_parallel.snap") != snapshot) {
+		std::cerr << "  loading with " << nthreads << " threads gives a different snapshot\n";
+		ok = false;
+	}
+	std::vector<Sample> smp;
+	sample_queries( wn, nqueries, smp);
+	std::ostringstream os1, os2;
+	run_queries( wn, smp, 0, smp.size(), pool, os1);
+	run_queries( *loaded, smp, 0, smp.size(), pool, os2);
+	if (os1.str() != os2.str()) {
+		std::cerr << "  query results differ on the loaded snapshot\n";
+		ok = false;
+	}
+	remove( "WNXMLTest.snap");
+	remove( "WNXMLTest_loaded.snap");
+	remove( "WNXMLTest_parallel.snap");
+	return ok;
+}
+
+
+/// Numbers of senses of the literals in the POS n, v, a, b, counted from the synsets
+typedef std::map< std::string, std::vector<unsigned> > LiteralCounts;
+
+void count_literals( const WNQuery& wn, LiteralCounts& counts)
+{
+	const char* const posnames[4] = { "n", "v", "a", "b" };
+	counts.clear();
+	for (int p=0; p!=4; p++) {
+		const WNQuery::tdat& d = wn.dat( posnames[p]);
+		for (WNQuery::tdat::const_iterator it=d.begin(); it!=d.end(); it++)
+			for (size_t i=0; i!=it->second.synonyms.size(); i++) {
+				std::vector<unsigned>& c = counts[it->second.synonyms[i].literal];
+				c.resize( 4, 0);
+				c[p]++;
+			}
+	}
+}
+
+
+/// Number of senses of a literal in POS number p, or in all POS (p = -1)
+unsigned senses_in( const std::vector<unsigned>& c, int p)
+{
+	return p >= 0 ? c[p] : c[0] + c[1] + c[2] + c[3];
+}
+
+
+/// Levenshtein distance of two strings (of their bytes)
+unsigned levenshtein( const std::string& a, const std::string& b)
+{
+	std::vector<unsigned> row( b.size() + 1);
+	for (size_t j=0; j<=b.size(); j++)
+		row[j] = unsigned( j);
+	for (size_t i=1; i<=a.size(); i++) {
+		unsigned diag = row[0];
+		row[0] = unsigned( i);
+		for (size_t j=1; j<=b.size(); j++) {
+			unsigned d = std::min( std::min( row[j], row[j-1]) + 1, diag + (a[i-1] == b[j-1] ? 0 : 1));
+			diag = row[j];
+			row[j] = d;
+		}
+	}
+	return row[b.size()];
+}
+
+
+/// Order of (literal, number of senses) pairs by decreasing number of senses
+bool more_senses( const std::pair<std::string, unsigned>& a, const std::pair<std::string, unsigned>& b)
+{
+	return a.second > b.second;
+}
+
+
+/// completeLiteral() by a linear scan of the literals
+void scan_complete( const LiteralCounts& counts, const std::string& prefix, int p, size_t k, WNQuery::tCompletions& results)
+{
+	results.clear();
+	for (LiteralCounts::const_iterator it=counts.lower_bound( prefix); it!=counts.end() && it->first.compare( 0, prefix.size(), prefix) == 0; it++)
+		if (senses_in( it->second, p) != 0)
+			results.push_back( std::make_pair( it->first, senses_in( it->second, p)));
+	// the prefix itself first (it's the first one in byte order), then the others, stable: in byte order
+	std::stable_sort( results.begin() + (!results.empty() && results[0].first == prefix ? 1 : 0), results.end(), more_senses);
+	if (results.size() > k)
+		results.resize( k);
+}
+
+
+/// fuzzyLookUpLiteral() by a linear scan of the literals
+void scan_fuzzy( const LiteralCounts& counts, const std::string& word, int p, unsigned maxdist, size_t k, WNQuery::tFuzzyMatches& results)
+{
+	std::vector< std::vector< std::pair<std::string, unsigned> > > bydist( maxdist + 1);
+	for (LiteralCounts::const_iterator it=counts.begin(); it!=counts.end(); it++) {
+		if (senses_in( it->second, p) == 0)
+			continue;
+		unsigned d = levenshtein( word, it->first);
+		if (d <= maxdist)
+			bydist[d].push_back( std::make_pair( it->first, senses_in( it->second, p)));
+	}
+	results.clear();
+	for (unsigned d=0; d<=maxdist; d++) {
+		std::stable_sort( bydist[d].begin(), bydist[d].end(), more_senses);
+		for (size_t i=0; i!=bydist[d].size() && results.size()!=k; i++)
+			results.push_back( std::make_pair( bydist[d][i].first, d));
+	}
+}
+
+
+/// findFoldedLiterals() by a linear scan of the literals
+void scan_folded( const LiteralCounts& counts, const LibWNXML::FoldedIndex& index, const std::string& literal, int p,
+				  std::vector<std::string>& results)
+{
+	results.clear();
+	std::string folded, f;
+	index.fold( literal.data(), literal.size(), folded);
+	for (LiteralCounts::const_iterator it=counts.begin(); it!=counts.end(); it++) {
+		if (senses_in( it->second, p) == 0)
+			continue;
+		index.fold( it->first.data(), it->first.size(), f);
+		if (f == folded)
+			results.push_back( it->first);
+	}
+}
+
+
+/// Compare the literal searches of the trie and the folded index (completion, fuzzy lookup, folded lookup) on the literals
+/// of the samples with linear scans of the literals of the synsets, return the number of differences
+size_t check_literal_index( const WNQuery& wn, const std::vector<Sample>& smp)
+{
+	const char* const posnames[5] = { "", "n", "v", "a", "b" };
+	LiteralCounts counts;
+	count_literals( wn, counts);
+	size_t count = 0;
+	for (size_t k=0; k!=smp.size(); k++) {
+		const std::string& literal = smp[k].literal;
+		for (int p=-1; p!=4; p++) {
+			const std::string pos = posnames[p + 1];
+			for (size_t len=(k == 0 ? 0 : 1); len<=3 && len<=literal.size(); len++) {
+				WNQuery::tCompletions c, expected;
+				wn.completeLiteral( literal.substr( 0, len), pos, 10, c);
+				scan_complete( counts, literal.substr( 0, len), p, 10, expected);
+				if (c != expected)
+					mismatch( count, "completions of '" + literal.substr( 0, len) + "' in POS '" + pos + "'");
+			}
+
+			if (k % 5 == 0) {
+				const std::string words[2] = { literal + "x", literal.substr( 1) };
+				for (int w=0; w!=2; w++)
+					for (unsigned d=1; d<=2; d++) {
+						WNQuery::tFuzzyMatches fm, expected;
+						wn.fuzzyLookUpLiteral( words[w], pos, d, 10, fm);
+						scan_fuzzy( counts, words[w], p, d, 10, expected);
+						if (fm != expected)
+							mismatch( count, "fuzzy matches of '" + words[w] + "' in POS '" + pos + "'");
+					}
+			}
+
+			std::string upper = literal;
+			for (size_t i=0; i!=upper.size(); i++)
+				upper[i] = char( toupper( (unsigned char) upper[i]));
+			const std::string words[2] = { literal, upper };
+			for (int w=0; w!=2; w++) {
+				std::vector<std::string> folded, expected;
+				wn.findFoldedLiterals( words[w], pos, folded);
+				scan_folded( counts, wn.foldedIndex(), words[w], p, expected);
+				if (folded != expected)
+					mismatch( count, "folded literals of '" + words[w] + "' in POS '" + pos + "'");
+			}
+		}
+	}
+	return count;
+}
+
+
+/// Check the searches of the literal trie and the folded index against linear scans: on the loaded WordNet,
+/// after a small patch (which the trie and the index take in place), and after a large one (after which they are built again)
+bool test_literal_index( const std::string& input, size_t nqueries)
+{
+	using LibWNXML::Synset;
+	std::auto_ptr<ML::MultiLog> logger( ML::MultiLog::create( std::cerr, 100));
+	WNQuery wn( input, *logger);
+	std::vector<Sample> smp;
+	sample_queries( wn, nqueries, smp);
+	size_t count = check_literal_index( wn, smp);
+
+	// small patch: synsets dropping a literal, and synsets adding a new literal and an uppercase form of an old one
+	std::vector<Synset> synsets, patch, large, patched;
+	read_synsets( input, wn.encoding(), synsets);
+	for (size_t i=7; i<synsets.size(); i+=synsets.size() / 30 + 1) {
+		const Synset& s = synsets[i];
+		if (s.synonyms.empty())
+			continue;
+		std::ostringstream num;
+		num << i;
+		Synset m = s;
+		m.synonyms.erase( m.synonyms.begin());
+		patch.push_back( m);
+		Synset a;
+		a.id = "LITERAL-" + num.str() + "-" + s.pos;
+		a.pos = s.pos;
+		a.synonyms.push_back( Synset::Synonym( "new" + num.str(), "1"));
+		std::string upper = s.synonyms[0].literal;
+		for (size_t j=0; j!=upper.size(); j++)
+			upper[j] = char( toupper( (unsigned char) upper[j]));
+		a.synonyms.push_back( Synset::Synonym( upper, "1"));
+		a.ilrs.push_back( std::make_pair( s.id, std::string( "hypernym")));
+		patch.push_back( a);
+	}
+	wn.applyPatch( patch);
+	smp.clear();
+	sample_queries( wn, nqueries, smp);
+	for (size_t i=0; i!=patch.size(); i++)
+		if (!patch[i].synonyms.empty()) {
+			Sample q;
+			q.id = patch[i].id;
+			q.pos = patch[i].pos;
+			q.literal = patch[i].synonyms.back().literal;
+			smp.push_back( q);
+		}
+	count += check_literal_index( wn, smp);
+
+	make_patch( synsets, large, patched);
+	wn.applyPatch( large);
+	smp.clear();
+	sample_queries( wn, nqueries, smp);
+	count += check_literal_index( wn, smp);
+	return count == 0;
+}
+
+
+/// Job summing i * j over a square, the rows of which run the pool again
+class NestedJob : public LibWNXML::ThreadPool::Job
+{
+public:
+	NestedJob( LibWNXML::ThreadPool& pool, size_t n)
+		: m_pool( pool), m_n( n), m_sums( n, 0)
+	{}
+
+	virtual void run( size_t i)
+	{
+		RowJob row( i, m_sums[i]);
+		m_pool.run( row, m_n);
+	}
+
+	unsigned long long	total() const
+	{
+		unsigned long long s = 0;
+		for (size_t i=0; i!=m_sums.size(); i++)
+			s += m_sums[i];
+		return s;
+	}
+
+private:
+	class RowJob : public LibWNXML::ThreadPool::Job
+	{
+	public:
+		RowJob( size_t i, unsigned long long& sum)
+			: m_i( i), m_sum( sum)
+		{}
+		virtual void run( size_t j)	{ m_sum += m_i * j; } // (a nested run is in one thread)
+	private:
+		size_t				m_i;
+		unsigned long long&	m_sum;
+	};
+
+	LibWNXML::ThreadPool&			m_pool;
+	size_t							m_n;
+	std::vector<unsigned long long>	m_sums;
+};
+
+
+/// Check that a job can run the pool it's running on (without deadlock)
+bool test_nested_pool_run( unsigned nthreads)
+{
+	const size_t n = 200;
+	LibWNXML::ThreadPool pool( nthreads);
+	NestedJob job( pool, n);
+	pool.run( job, n);
+	unsigned long long expected = (unsigned long long) (n * (n - 1) / 2) * (n * (n - 1) / 2);
+	if (job.total() != expected) {
+		std::cerr << "  sum " << job.total() << ", expected " << expected << "\n";
+		return false;
+	}
+	return true;
+}
+
+} // namespace {
+
+
+int main( int argc, char *argv[])
+{
+	try {
+		// check command line
+		std::string input;
+		unsigned nthreads = 8;
+		size_t nqueries = 300;
+		for (int i=1; i<argc; i++) {
+			std::string arg = argv[i];
+			if (arg == "-j" && i+1 < argc)
+				nthreads = unsigned( atoi( argv[++i]));
+			else if (arg == "-n" && i+1 < argc)
+				nqueries = size_t( atol( argv[++i]));
+			else if (arg == "-h" || arg == "--help") {
+				std::cerr << "Usage:\n  WNXMLTest [-j <threads>] [-n <queries>] [<WN_XML_file>]\n";
+				std::cerr << "  -j  number of threads querying at the same time (default: 8)\n";
+				std::cerr << "  -n  number of queries sampled (default: 300)\n";
+				std::cerr << "Without a file, a generated WordNet is used (see WNXMLGen).\n";
+				return 1;
+			}
+			else
+				input = arg;
+		}
+		if (nthreads < 2)
+			nthreads = 2;
+
+		bool generated = input.empty();
+		if (generated) {
+			input = "WNXMLTest_synthetic.xml";
+			LibWNXML::WNXMLGenerator::Params params;
+			params.synsets[0] = 5000;
+			params.synsets[1] = 1000;
+			params.synsets[2] = 1000;
+			params.synsets[3] = 200;
+			params.maxDepth = 8;
+			params.multiParent = 0.1;
+			params.symmetric = 0.1;
+			LibWNXML::WNXMLGenerator( params).write( input);
+		}
+
+		int failed = 0;
+		std::cerr << "parser against the first version... ";
+		bool ok = test_parser( input);
+		std::cerr << (ok ? "OK\n" : "FAILED\n");
+		failed += ok ? 0 : 1;
+
+		std::cerr << "similarities and traces against the first version... ";
+		ok = test_baseline_queries( input, nthreads, nqueries);
+		std::cerr << (ok ? "OK\n" : "FAILED\n");
+		failed += ok ? 0 : 1;
+
+		std::cerr << "snapshot round trip... ";
+		ok = test_snapshot( input, nthreads, nqueries);
+		std::cerr << (ok ? "OK\n" : "FAILED\n");
+		failed += ok ? 0 : 1;
+
+		std::cerr << "literal trie and folded index against linear scans... ";
+		ok = test_literal_index( input, nqueries);
+		std::cerr << (ok ? "OK\n" : "FAILED\n");
+		failed += ok ? 0 : 1;
+
+		std::cerr << "concurrent queries (" << nthreads << " threads)... ";
+		ok = test_concurrent_queries( input, nthreads, nqueries);
+		std::cerr << (ok ? "OK\n" : "FAILED\n");
+		failed += ok ? 0 : 1;
+
+		std::cerr << "patch against loading the patched file... ";
+		ok = test_patch( input, nthreads, nqueries);
+		std::cerr << (ok ? "OK\n" : "FAILED\n");
+		failed += ok ? 0 : 1;
+
+		std::cerr << "nested thread pool runs... ";
+		ok = test_nested_pool_run( nthreads);
+		std::cerr << (ok ? "OK\n" : "FAILED\n");
+		failed += ok ? 0 : 1;
+
+		if (generated)
+			remove( input.c_str());
+		if (failed != 0) {
+			std::cerr << failed << " test(s) failed\n";
+			return 1;
+		}
+		std::cerr << "All tests passed\n";
+
+	} // try {
+	catch (const std::exception& e) {
+		std::cerr << e.what() << "\n";
+		return 1;
+	}
+	catch (...) {
+		std::cerr << "Unknown exception\n";
+		return 1;
+	}
+
+	return 0;
+}